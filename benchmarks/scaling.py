@@ -0,0 +1,383 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2026 agent
+#
+# This file is part of Nidhugg.
+#
+# Nidhugg is free software: you can redistribute it and/or modify it
+# under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# Nidhugg is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see
+# <http://www.gnu.org/licenses/>.
+
+# Runs the benchmark corpus across memory models, algorithms and
+# thread counts, and records the results as JSON. Also compares two
+# such result files, e.g. from two nidhugg binaries, and flags
+# regressions.
+#
+# Usage:
+#   ./scaling.py run [OPTIONS] [TEST[@N] ...]
+#   ./scaling.py compare [OPTIONS] BASE.json NEW.json
+#
+# See ./scaling.py run --help and ./scaling.py compare --help.
+
+import argparse
+import datetime
+import json
+import os
+import platform
+import re
+import shutil
+import signal
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+BENCHDIR = os.path.dirname(os.path.abspath(__file__))
+
+# The suites run by default, relative to BENCHDIR.
+DEFAULT_SUITES = ['SV-COMP', 'from_RCMC', 'from_TRACER', 'synthetic']
+
+# Tests that do not terminate in reasonable time without further
+# bounds (as in runall.sh).
+EXCLUDED = {
+    'SV-COMP/stack_true.c', 'SV-COMP/queue_ok.c', 'SV-COMP/pthread_demo.c',
+    'SV-COMP/gcd.c', 'SV-COMP/indexer.c',
+    'from_TRACER/filesystem.c', 'from_TRACER/exponential_bug.c',
+}
+
+# The synthetic tests are parametric in N, and are instantiated with
+# this N unless given explicitly as synthetic/FILE@N.
+SYNTHETIC_N = 4
+
+MODELS = ['sc', 'tso', 'pso', 'power', 'arm']
+ALGORITHMS = ['source', 'optimal', 'observers', 'rf']
+
+# Exit code of nidhugg when an error was detected in the test.
+VERIFICATION_FAILURE = 42
+
+def supported(model, algorithm):
+    if algorithm == 'rf':
+        return model == 'sc'
+    if algorithm in ('optimal', 'observers'):
+        return model in ('sc', 'tso')
+    return True
+
+# Whether nidhugg explores in parallel with --n-threads for this
+# combination. Other combinations are only run with one thread.
+def parallel(model, algorithm):
+    return (algorithm == 'rf' or model in ('power', 'arm')
+            or (model in ('sc', 'tso') and algorithm in ('optimal', 'observers')))
+
+def comma_list(s):
+    return [x for x in s.split(',') if x]
+
+def median(xs):
+    xs = sorted(xs)
+    return xs[len(xs) // 2]
+
+def default_tests():
+    tests = []
+    for suite in DEFAULT_SUITES:
+        for f in sorted(os.listdir(os.path.join(BENCHDIR, suite))):
+            name = suite + '/' + f
+            if not f.endswith('.c') or name in EXCLUDED:
+                continue
+            if suite == 'synthetic' and 'parametric' in f:
+                name += '@{0}'.format(SYNTHETIC_N)
+            tests.append(name)
+    return tests
+
+# Compiles a test (FILE or FILE@N) to transformed LLVM bitcode in
+# tmpdir. The transformation is done once per test rather than with
+# --transform-first for every run, so that it is not timed. Returns
+# the path to the bitcode.
+def compile_test(args, test, tmpdir):
+    path, _, n = test.partition('@')
+    src = path if os.path.isabs(path) else os.path.join(BENCHDIR, path)
+    base = os.path.join(tmpdir, test.replace('/', '_').replace('@', '_N'))
+    cmd = [args.clang, '-o', base + '.bc', '-c', '-emit-llvm', '-g']
+    if n:
+        cmd.append('-DN={0}'.format(n))
+    subprocess.check_call(cmd + [src], stderr=subprocess.DEVNULL)
+    cmd = [args.nidhugg, '--transform=' + base + '.t.bc']
+    if args.unroll is not None:
+        cmd.append('--unroll={0}'.format(args.unroll))
+    subprocess.check_call(cmd + [base + '.bc'], stdout=subprocess.DEVNULL,
+                          stderr=subprocess.DEVNULL)
+    return base + '.t.bc'
+
+# Whether each nidhugg binary supports --stats-json, as listed by
+# its --help.
+_stats_json = {}
+
+def has_stats_json(nidhugg):
+    if nidhugg not in _stats_json:
+        try:
+            out = subprocess.run([nidhugg, '--help'], stdout=subprocess.PIPE,
+                                 stderr=subprocess.STDOUT,
+                                 universal_newlines=True).stdout
+        except OSError:
+            out = ''
+        _stats_json[nidhugg] = '--stats-json' in out
+    return _stats_json[nidhugg]
+
+# The trace counts printed by nidhugg, for binaries without
+# --stats-json. The blocked counts are only printed when nonzero.
+def parse_output(output):
+    def count(label):
+        m = re.search(r'^' + label + r': (\d+)$', output, re.MULTILINE)
+        return int(m.group(1)) if m else 0
+    if not re.search(r'^Trace count: \d+$', output, re.MULTILINE):
+        return None
+    return {'traces': {'count': count('Trace count'),
+                       'sleepset_blocked': count('Sleepset-blocked trace count'),
+                       'assume_blocked': count('Assume-blocked trace count')}}
+
+# Runs nidhugg once. Returns a dict with the status, wall time, CPU
+# time and peak RSS of the run, and the trace counts from
+# --stats-json, or from the output of binaries that lack it.
+def run_once(args, ir, model, algorithm, threads, tmpdir):
+    stats = os.path.join(tmpdir, 'stats.json')
+    if os.path.exists(stats):
+        os.remove(stats)
+    cmd = [args.nidhugg, '--' + model, '--' + algorithm,
+           '--n-threads={0}'.format(threads)]
+    use_stats_json = has_stats_json(args.nidhugg)
+    if use_stats_json:
+        cmd.append('--stats-json=' + stats)
+    cmd.append(ir)
+    timed_out = []
+    t0 = time.monotonic()
+    # The output goes to a file rather than a pipe, so that the child
+    # cannot block on a full pipe while we wait for it.
+    out = tempfile.TemporaryFile(mode='w+', dir=tmpdir)
+    p = subprocess.Popen(cmd, stdout=(subprocess.DEVNULL if use_stats_json else out),
+                         stderr=subprocess.DEVNULL)
+    def kill():
+        timed_out.append(True)
+        p.send_signal(signal.SIGKILL)
+    timer = threading.Timer(args.timeout, kill)
+    timer.start()
+    _, status, usage = os.wait4(p.pid, 0)
+    wall = time.monotonic() - t0
+    timer.cancel()
+    p.returncode = os.WEXITSTATUS(status) if os.WIFEXITED(status) else -os.WTERMSIG(status)
+    if timed_out:
+        result = 'timeout'
+    elif p.returncode == 0:
+        result = 'ok'
+    elif p.returncode == VERIFICATION_FAILURE:
+        result = 'error_found'
+    else:
+        result = 'failed'
+    r = {'status': result,
+         'wall_seconds': wall,
+         'cpu_seconds': usage.ru_utime + usage.ru_stime,
+         # kilobytes on Linux, bytes on macOS
+         'peak_rss_kb': usage.ru_maxrss // (1024 if sys.platform == 'darwin' else 1)}
+    s = None
+    if use_stats_json:
+        if os.path.exists(stats):
+            with open(stats) as f:
+                s = json.load(f)
+    else:
+        out.seek(0)
+        s = parse_output(out.read())
+    out.close()
+    if s is not None:
+        r['traces'] = s['traces']['count']
+        r['blocked_traces'] = (s['traces']['sleepset_blocked']
+                               + s['traces']['assume_blocked'])
+    return r
+
+def run_config(args, test, ir, model, algorithm, threads, tmpdir):
+    samples = [run_once(args, ir, model, algorithm, threads, tmpdir)
+               for _ in range(args.reps)]
+    last = samples[-1]
+    entry = {'test': test, 'model': model, 'algorithm': algorithm,
+             'threads': threads, 'status': last['status'],
+             'wall_seconds': median([s['wall_seconds'] for s in samples]),
+             'cpu_seconds': median([s['cpu_seconds'] for s in samples]),
+             'peak_rss_kb': max(s['peak_rss_kb'] for s in samples),
+             'samples': samples}
+    if 'traces' in last:
+        entry['traces'] = last['traces']
+        entry['blocked_traces'] = last['blocked_traces']
+        if entry['wall_seconds'] > 0:
+            entry['traces_per_second'] = last['traces'] / entry['wall_seconds']
+    return entry
+
+# Adds the speedup and parallel efficiency of each run relative to
+# the one-thread run of the same configuration.
+def add_efficiency(runs):
+    seq = {}
+    for r in runs:
+        if r['threads'] == 1 and r['status'] in ('ok', 'error_found'):
+            seq[(r['test'], r['model'], r['algorithm'])] = r['wall_seconds']
+    for r in runs:
+        base = seq.get((r['test'], r['model'], r['algorithm']))
+        if base is None or r['status'] not in ('ok', 'error_found') \
+           or r['wall_seconds'] <= 0:
+            continue
+        r['speedup'] = base / r['wall_seconds']
+        r['parallel_efficiency'] = r['speedup'] / r['threads']
+
+def nidhugg_version(nidhugg):
+    try:
+        out = subprocess.run([nidhugg, '--version'], stdout=subprocess.PIPE,
+                             stderr=subprocess.STDOUT, universal_newlines=True).stdout
+        return out.strip()
+    except OSError:
+        return None
+
+def cmd_run(args):
+    for binary in (args.nidhugg, args.clang):
+        if shutil.which(binary) is None:
+            sys.exit('Cannot find \'{0}\'.'.format(binary))
+    tests = args.tests or default_tests()
+    threads = sorted(set(int(t) for t in comma_list(args.threads)))
+    for m in args.models:
+        if m not in MODELS:
+            sys.exit('Unknown memory model \'{0}\'.'.format(m))
+    for a in args.algorithms:
+        if a not in ALGORITHMS:
+            sys.exit('Unknown algorithm \'{0}\'.'.format(a))
+    runs = []
+    tmpdir = tempfile.mkdtemp(prefix='nidhugg-scaling-')
+    try:
+        for test in tests:
+            try:
+                ir = compile_test(args, test, tmpdir)
+            except subprocess.CalledProcessError:
+                print('{0}: compilation failed, skipping'.format(test), file=sys.stderr)
+                continue
+            for model in args.models:
+                for algorithm in args.algorithms:
+                    if not supported(model, algorithm):
+                        continue
+                    # POWER and ARM have a single algorithm
+                    if model in ('power', 'arm') and algorithm != 'source':
+                        continue
+                    for n in threads:
+                        if n > 1 and not parallel(model, algorithm):
+                            continue
+                        r = run_config(args, test, ir, model, algorithm, n, tmpdir)
+                        print('{0:<40} {1:<5} {2:<9} {3:>3} {4:<11} {5:8.2f}s'
+                              .format(test, model, algorithm, n, r['status'],
+                                      r['wall_seconds']), file=sys.stderr)
+                        runs.append(r)
+    finally:
+        shutil.rmtree(tmpdir)
+    add_efficiency(runs)
+    result = {'nidhugg': args.nidhugg,
+              'version': nidhugg_version(args.nidhugg),
+              'date': datetime.datetime.now().isoformat(timespec='seconds'),
+              'host': platform.node(),
+              'cpus': os.cpu_count(),
+              'timeout_seconds': args.timeout,
+              'reps': args.reps,
+              'runs': runs}
+    with open(args.output, 'w') as f:
+        json.dump(result, f, indent=2, sort_keys=True)
+        f.write('\n')
+    print('Results written to {0}'.format(args.output), file=sys.stderr)
+
+def run_key(r):
+    return (r['test'], r['model'], r['algorithm'], r['threads'])
+
+def cmd_compare(args):
+    with open(args.base) as f:
+        base = {run_key(r): r for r in json.load(f)['runs']}
+    with open(args.new) as f:
+        new = {run_key(r): r for r in json.load(f)['runs']}
+    regressions = 0
+    print('{0:<40} {1:<5} {2:<9} {3:>3} {4:>9} {5:>9} {6:>8}  {7}'
+          .format('test', 'model', 'algorithm', 'thr', 'base(s)', 'new(s)', 'change', 'flags'))
+    for key in sorted(set(base) | set(new)):
+        b, n = base.get(key), new.get(key)
+        flags = []
+        if b is None or n is None:
+            flags.append('ONLY-IN-' + ('NEW' if b is None else 'BASE'))
+            change = ''
+        else:
+            bw, nw = b['wall_seconds'], n['wall_seconds']
+            change = '{0:+7.1f}%'.format(100 * (nw - bw) / bw) if bw > 0 else ''
+            if b['status'] != n['status']:
+                flags.append('STATUS:{0}->{1}'.format(b['status'], n['status']))
+            elif nw > bw * (1 + args.threshold / 100) and nw - bw >= args.min_seconds:
+                flags.append('SLOWER')
+            elif bw > nw * (1 + args.threshold / 100) and bw - nw >= args.min_seconds:
+                flags.append('faster')
+            if n['peak_rss_kb'] > b['peak_rss_kb'] * (1 + args.threshold / 100) \
+               and n['peak_rss_kb'] - b['peak_rss_kb'] >= args.min_rss_kb:
+                flags.append('MEMORY')
+            if 'traces' in b and 'traces' in n and b['traces'] != n['traces']:
+                flags.append('TRACES:{0}->{1}'.format(b['traces'], n['traces']))
+        if [f for f in flags if f != 'faster']:
+            regressions += 1
+        if flags or args.verbose:
+            r = b or n
+            print('{0:<40} {1:<5} {2:<9} {3:>3} {4:>9} {5:>9} {6:>8}  {7}'
+                  .format(key[0], key[1], key[2], key[3],
+                          '{0:.2f}'.format(b['wall_seconds']) if b else '-',
+                          '{0:.2f}'.format(n['wall_seconds']) if n else '-',
+                          change, ' '.join(flags)))
+    print('{0} regression(s)'.format(regressions))
+    sys.exit(1 if regressions else 0)
+
+def main():
+    parser = argparse.ArgumentParser(description='Nidhugg scaling benchmarks.')
+    sub = parser.add_subparsers(dest='command')
+    sub.required = True
+
+    p = sub.add_parser('run', help='Run the benchmarks and write JSON results.')
+    p.add_argument('tests', nargs='*', metavar='TEST[@N]',
+                   help='Tests to run, relative to the benchmarks directory. '
+                   'Default: the suites {0}.'.format(', '.join(DEFAULT_SUITES)))
+    p.add_argument('--nidhugg', default='nidhugg', help='The nidhugg binary.')
+    p.add_argument('--clang', default='clang', help='The clang binary.')
+    p.add_argument('--models', type=comma_list, default=['sc', 'tso'],
+                   help='Memory models (default sc,tso).')
+    p.add_argument('--algorithms', type=comma_list, default=['source', 'optimal', 'rf'],
+                   help='Algorithms (default source,optimal,rf).')
+    p.add_argument('--threads', default='1,2,4,8',
+                   help='Values of --n-threads (default 1,2,4,8).')
+    p.add_argument('--unroll', type=int, help='Unroll loops N times.')
+    p.add_argument('--timeout', type=float, default=600,
+                   help='Timeout in seconds per run (default 600).')
+    p.add_argument('--reps', type=int, default=1,
+                   help='Repetitions per configuration; times are the median '
+                   '(default 1).')
+    p.add_argument('-o', '--output', default='scaling.json',
+                   help='Output file (default scaling.json).')
+    p.set_defaults(func=cmd_run)
+
+    p = sub.add_parser('compare', help='Compare two result files.')
+    p.add_argument('base', help='Results of the baseline binary.')
+    p.add_argument('new', help='Results of the new binary.')
+    p.add_argument('--threshold', type=float, default=10,
+                   help='Flag changes larger than this percentage (default 10).')
+    p.add_argument('--min-seconds', type=float, default=0.2,
+                   help='Ignore time changes smaller than this (default 0.2).')
+    p.add_argument('--min-rss-kb', type=int, default=10240,
+                   help='Ignore memory changes smaller than this (default 10240).')
+    p.add_argument('-v', '--verbose', action='store_true',
+                   help='Also print unflagged runs.')
+    p.set_defaults(func=cmd_compare)
+
+    args = parser.parse_args()
+    args.func(args)
+
+if __name__ == '__main__':
+    main()
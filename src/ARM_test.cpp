@@ -3054,6 +3054,118 @@ declare i32 @pthread_create(i64*,%attr_t*,i8*(i8*)*,i8*)
   BOOST_CHECK_EQUAL(res.assume_blocked_trace_count, 1);
 }
 
+BOOST_AUTO_TEST_CASE(Parallel_CoWR_1){
+  /* The module of CoWR_1 */
+  DPORDriver_test::check_parallel_equiv(R"(
+@x = global i32 0, align 4
+@y = global i32 0, align 4
+
+define i8* @p1(i8* %arg){
+  store i32 2, i32* @x, align 4
+  ret i8* null
+}
+
+define i8* @p2(i8* %arg){
+  %x1 = load i32, i32* @x, align 4
+  %x2 = load i32, i32* @x, align 4
+  %y = load i32, i32* @y, align 4
+  %xc1 = icmp eq i32 %x1, 2
+  %xc2 = icmp eq i32 %x2, 1
+  %yc  = icmp eq i32 %y, 1
+  %c1 = and i1 %xc1, %xc2
+  %c2 = and i1 %c1, %yc
+  br i1 %c2, label %error, label %exit
+error:
+  call void @__assert_fail()
+  br label %exit
+exit:
+  ret i8* null
+}
+
+define i32 @main(){
+  call i32 @pthread_create(i64* null, %attr_t* null, i8*(i8*)* @p1, i8* null)
+  call i32 @pthread_create(i64* null, %attr_t* null, i8*(i8*)* @p2, i8* null)
+  store i32 1, i32* @x, align 4
+  %x = load i32, i32* @x, align 4
+  %xc = icmp eq i32 %x, 2
+  %v = zext i1 %xc to i32
+  store i32 %v, i32* @y
+  ret i32 0
+}
+
+%attr_t = type {i64, [48 x i8]}
+declare i32 @pthread_create(i64*,%attr_t*,i8*(i8*)*,i8*)
+declare void @__assert_fail() nounwind noreturn
+)",DPORDriver_test::get_arm_conf(),36,4);
+}
+
+BOOST_AUTO_TEST_CASE(Parallel_W_RW_2W){
+  /* The module of W_RW_2W */
+  DPORDriver_test::check_parallel_equiv(R"(
+@x = global i32 0, align 4
+@y = global i32 0, align 4
+
+define i8* @p(i8* %arg){
+  load i32, i32* @x, align 4
+  store i32 1, i32* @y, align 4
+  ret i8* null
+}
+
+define i8* @q(i8* %arg){
+  store i32 2, i32* @y, align 4
+  store i32 1, i32* @x, align 4
+  ret i8* null
+}
+
+define i32 @main(){
+  call i32 @pthread_create(i64* null, %attr_t* null, i8*(i8*)* @p, i8* null)
+  call i32 @pthread_create(i64* null, %attr_t* null, i8*(i8*)* @q, i8* null)
+  store i32 2, i32* @x, align 4
+  ret i32 0
+}
+
+%attr_t = type {i64, [48 x i8]}
+declare i32 @pthread_create(i64*,%attr_t*,i8*(i8*)*,i8*)
+)",DPORDriver_test::get_arm_conf(),12,4);
+}
+
+BOOST_AUTO_TEST_CASE(Parallel_TWO_2W_rfi_datas_noise){
+  /* The module of TWO_2W_rfi_datas_noise */
+  DPORDriver_test::check_parallel_equiv(R"(
+@x = global i32 0, align 4
+@y = global i32 0, align 4
+@p_wait = global i1 0
+@q_wait = global i1 0
+
+define i8* @p(i8* %arg){
+  store i32 1, i32* @y, align 4
+  %y = load i32, i32* @y
+  store i32 %y, i32* @x, align 4
+  store i1 1, i1* @p_wait
+  ret i8* null
+}
+
+define i8* @q(i8* %arg){
+  store i32 1, i32* @x, align 4
+  %x = load i32, i32* @x
+  store i32 %x, i32* @y, align 4
+  store i1 1, i1* @q_wait
+  ret i8* null
+}
+
+define i32 @main(){
+  call i32 @pthread_create(i64* null, %attr_t* null, i8*(i8*)* @p, i8* null)
+  call i32 @pthread_create(i64* null, %attr_t* null, i8*(i8*)* @q, i8* null)
+  load i1, i1* @p_wait
+  load i1, i1* @q_wait
+  ret i32 0
+}
+
+%attr_t = type {i64, [48 x i8]}
+declare i32 @pthread_create(i64*,%attr_t*,i8*(i8*)*,i8*)
+)",DPORDriver_test::get_arm_conf(),32,4);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 #endif
@@ -18,35 +18,27 @@
  */
 
 #include "BVClock.h"
-#include "Debug.h"
 #include "FBVClock.h"
 
 #include <algorithm>
 
 BVClock BVClock::operator+(const BVClock &vc) const{
-  Debug::warn("BVClock")
-    << "WARNING: BVClock can be implemented more efficiently with bitwise operations.\n";
-  BVClock rv;
-  if(vec.size() < vc.vec.size()){
-    rv.vec = vc.vec;
-  }else{
-    rv.vec = vec;
+  if(words.size() < vc.words.size()){
+    BVClock rv(vc);
+    return rv += *this;
   }
-  const unsigned m = std::min(vc.vec.size(),vec.size());
-  for(unsigned i = 0; i < m; ++i){
-    rv.vec[i] = vec[i] || vc.vec[i];
-  }
-  return rv;
+  BVClock rv(*this);
+  return rv += vc;
 }
 
 std::string BVClock::to_string() const{
-  if(vec.size()){
+  if(sz){
     std::string s;
-    s.resize(2*vec.size()+1,',');
+    s.resize(2*sz+1,',');
     s[0] = '[';
     s[s.size()-1] = ']';
-    for(unsigned i = 0; i < vec.size(); ++i){
-      s[2*i+1] = vec[i] ? '1' : '0';
+    for(int i = 0; i < sz; ++i){
+      s[2*i+1] = (*this)[i] ? '1' : '0';
     }
     return s;
   }
@@ -54,32 +46,21 @@ std::string BVClock::to_string() const{
 }
 
 bool BVClock::leq(const BVClock &vc) const{
-  const int m = std::min(vec.size(),vc.vec.size());
-  for(int i = 0; i < m; ++i){
-    if(vec[i] && !vc.vec[i]) return false;
+  const unsigned m = std::min(words.size(),vc.words.size());
+  for(unsigned i = 0; i < m; ++i){
+    if(words[i] & ~vc.words[i]) return false;
   }
-  for(unsigned i = vc.vec.size(); i < vec.size(); ++i){
-    if(vec[i]) return false;
+  for(unsigned i = m; i < words.size(); ++i){
+    if(words[i]) return false;
   }
   return true;
 }
 
 BVClock &BVClock::operator=(FBVClock &vc){
-  const int sz = vc.size();
-  vec.resize(sz,false);
-  for(int i = 0; i < sz; ++i){
-    vec[i] = vc[i];
-  }
+  *this = vc.get();
   return *this;
 }
 
 BVClock &BVClock::operator+=(FBVClock &vc){
-  const unsigned sz = vc.size();
-  if(vec.size() < sz){
-    vec.resize(sz,false);
-  }
-  for(unsigned i = 0; i < sz; ++i){
-    vec[i] = vec[i] || vc[i];
-  }
-  return *this;
+  return *this += vc.get();
 }
@@ -22,6 +22,7 @@
 #ifndef __BVCLOCK_H__
 #define __BVCLOCK_H__
 
+#include <cstdint>
 #include <ostream>
 #include <string>
 #include <vector>
@@ -32,15 +33,28 @@ class FBVClock;
 
 /* A BVClock is a vector clock (similar to VClock<int>) where each
  * clock element is just a single bit.
+ *
+ * The bits are stored in 64-bit words, so that joins and comparisons
+ * operate on a word at a time (and are vectorised by the compiler).
  */
 class BVClock{
 public:
   /* Create a vector clock where each clock is initialized to 0. */
-  BVClock(){};
-  BVClock(const BVClock &vc) : vec(vc.vec) {};
-  BVClock(BVClock &&vc) : vec(std::move(vc.vec)) {};
-  BVClock &operator=(const BVClock &vc) { vec = vc.vec; return *this; };
-  BVClock &operator=(BVClock &&vc) { vec = std::move(vc.vec); return *this; };
+  BVClock() : sz(0) {};
+  BVClock(const BVClock &vc) : words(vc.words), sz(vc.sz) {};
+  BVClock(BVClock &&vc) : words(std::move(vc.words)), sz(vc.sz) {
+    vc.words.clear(); vc.sz = 0;
+  };
+  BVClock &operator=(const BVClock &vc) {
+    words = vc.words; sz = vc.sz; return *this;
+  };
+  BVClock &operator=(BVClock &&vc) {
+    if(this != &vc){
+      words = std::move(vc.words); sz = vc.sz;
+      vc.words.clear(); vc.sz = 0;
+    }
+    return *this;
+  };
   BVClock &operator=(FBVClock &vc);
   /* A vector clock v such that the clock of d in v takes the value
    * max((*this)[d],vc[d]) for all d.
@@ -48,12 +62,16 @@ public:
   BVClock operator+(const BVClock &vc) const;
   /* Assign this vector clock to (*this + vc). */
   BVClock &operator+=(const BVClock &vc){
-    if(vec.size() < vc.vec.size()){
-      vec.resize(vc.vec.size(),false);
+    if(words.size() < vc.words.size()){
+      words.resize(vc.words.size(),0);
     }
-    for(unsigned i = 0; i < vc.vec.size(); ++i){
-      vec[i] = vec[i] || vc.vec[i];
+    uint64_t *dst = words.data();
+    const uint64_t *src = vc.words.data();
+    const unsigned n = vc.words.size();
+    for(unsigned i = 0; i < n; ++i){
+      dst[i] |= src[i];
     }
+    if(sz < vc.sz) sz = vc.sz;
     return *this;
   };
   /* Assign this vector clock to (*this + vc). */
@@ -62,17 +80,22 @@ public:
   BVClock &operator+=(FBVClock &vc);
   /* The value of the clock of d. */
   bool operator[](int d) const{
-    if(d < int(vec.size())) return vec[d];
+    if(d < sz) return (words[d/64] >> (d%64)) & 1;
     return false;
   };
   void set(int d) {
-    if(d >= int(vec.size())){
-      vec.resize(d+1,false);
+    if(d >= sz){
+      words.resize(d/64+1,0);
+      sz = d+1;
     }
-    vec[d] = true;
+    words[d/64] |= uint64_t(1) << (d%64);
   };
   /* Assign 0 to all clocks */
-  void clear() { vec.clear(); };
+  void clear() { words.clear(); sz = 0; };
+  /* Returns some natural number i such that for all j s.t. i<=j, it
+   * holds that (*this)[j] == false.
+   */
+  int size() const { return sz; };
 
   /* *** Partial order comparisons ***
    *
@@ -95,7 +118,10 @@ public:
 
   std::string to_string() const;
 private:
-  std::vector<bool> vec;
+  /* Bit d is bit d%64 of words[d/64]. All bits from sz onwards are 0. */
+  std::vector<uint64_t> words;
+  /* The number of clock elements kept track of. */
+  int sz;
 };
 
 inline std::ostream &operator<<(std::ostream &os, const BVClock &vc){
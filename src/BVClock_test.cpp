@@ -0,0 +1,108 @@
+/* Copyright (C) 2026 agent
+ *
+ * This file is part of Nidhugg.
+ *
+ * Nidhugg is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nidhugg is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#ifdef HAVE_BOOST_UNIT_TEST_FRAMEWORK
+#include <boost/test/unit_test.hpp>
+
+#include "BVClock.h"
+
+BOOST_AUTO_TEST_SUITE(BVClock_test)
+
+BOOST_AUTO_TEST_CASE(Set_and_access){
+  BVClock a;
+  BOOST_CHECK(a.to_string() == "[]");
+  BOOST_CHECK(!a[0]);
+  BOOST_CHECK(!a[1000]);
+  a.set(2);
+  a.set(70);
+  BOOST_CHECK_EQUAL(a.size(), 71);
+  BOOST_CHECK(a[2]);
+  BOOST_CHECK(a[70]);
+  BOOST_CHECK(!a[1]);
+  BOOST_CHECK(!a[64]);
+  BOOST_CHECK(!a[71]);
+  a.clear();
+  BOOST_CHECK(!a[2]);
+  BOOST_CHECK_EQUAL(a.size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(To_string){
+  BVClock a;
+  a.set(0);
+  a.set(2);
+  BOOST_CHECK(a.to_string() == "[1,0,1]");
+}
+
+BOOST_AUTO_TEST_CASE(Move){
+  BVClock a;
+  a.set(70);
+  BVClock b(std::move(a));
+  BOOST_CHECK(b[70]);
+  BOOST_CHECK_EQUAL(b.size(), 71);
+  BOOST_CHECK_EQUAL(a.size(), 0);
+  BOOST_CHECK(a.to_string() == "[]");
+  BVClock c;
+  c.set(3);
+  c = std::move(b);
+  BOOST_CHECK(c[70] && !c[3]);
+  BOOST_CHECK_EQUAL(c.size(), 71);
+  BOOST_CHECK_EQUAL(b.size(), 0);
+  BOOST_CHECK(b.to_string() == "[]");
+  /* A moved-from clock can be reused */
+  b.set(1);
+  BOOST_CHECK(b.to_string() == "[0,1]");
+}
+
+BOOST_AUTO_TEST_CASE(Join){
+  BVClock a, b;
+  a.set(1);
+  b.set(3);
+  b.set(130);
+  BVClock c = a + b;
+  BOOST_CHECK(c[1] && c[3] && c[130]);
+  BOOST_CHECK(!c[0] && !c[2] && !c[129]);
+  BOOST_CHECK_EQUAL(c.size(), 131);
+  BVClock d = b + a;
+  BOOST_CHECK(d[1] && d[3] && d[130]);
+  a += b;
+  BOOST_CHECK(a[1] && a[3] && a[130]);
+  BOOST_CHECK(!b[1]);
+}
+
+BOOST_AUTO_TEST_CASE(Leq){
+  BVClock a, b;
+  BOOST_CHECK(a.leq(b));
+  a.set(5);
+  BOOST_CHECK(!a.leq(b));
+  BOOST_CHECK(b.leq(a));
+  b.set(5);
+  b.set(200);
+  BOOST_CHECK(a.leq(b));
+  BOOST_CHECK(!b.leq(a));
+  a.set(100);
+  BOOST_CHECK(!a.leq(b));
+  b.set(100);
+  BOOST_CHECK(a.leq(b));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
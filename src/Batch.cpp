@@ -0,0 +1,159 @@
+/* Copyright (C) 2026 agent
+ *
+ * This file is part of Nidhugg.
+ *
+ * Nidhugg is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nidhugg is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include "Batch.h"
+
+#include "Cpubind.h"
+#include "DPORDriver.h"
+#include "Json.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+  enum Status { OK, ERROR, FAILURE };
+
+  /* Explores job with threads threads, and returns its result record
+   * in record. */
+  Status run_job(const Batch::Job &job, unsigned index, unsigned threads,
+                 std::string &record){
+    using namespace std::chrono;
+    steady_clock::time_point start = steady_clock::now();
+    std::stringstream ss;
+    ss << std::setprecision(6) << std::fixed;
+    ss << "{\"job\": " << index
+       << ", \"name\": " << Json::quote(job.name)
+       << ", \"input\": " << Json::quote(job.input)
+       << ", \"threads\": " << threads;
+    Status status;
+    std::string message;
+    /* The job must not use more threads than it has been given */
+    Configuration conf = job.conf;
+    conf.n_threads = threads;
+    try{
+      std::unique_ptr<DPORDriver> driver(DPORDriver::fromInput(job.input,conf));
+      DPORDriver::Result res = driver->run();
+      status = res.has_errors() ? ERROR : OK;
+      ss << ", \"status\": " << (status == ERROR ? "\"error\"" : "\"ok\"")
+         << ", \"traces\": {\"count\": " << res.trace_count
+         << ", \"sleepset_blocked\": " << res.sleepset_blocked_trace_count
+         << ", \"assume_blocked\": " << res.assume_blocked_trace_count << "}";
+      if(status == ERROR){
+        ss << ", \"error_trace\": " << Json::quote(res.error_trace->to_string(2));
+      }
+    }catch(std::exception *exc){
+      status = FAILURE;
+      message = exc->what();
+    }catch(std::exception &exc){
+      status = FAILURE;
+      message = exc.what();
+    }
+    if(status == FAILURE){
+      ss << ", \"status\": \"failure\", \"message\": " << Json::quote(message);
+    }
+    double elapsed =
+      duration_cast<duration<double>>(steady_clock::now() - start).count();
+    ss << ", \"elapsed_seconds\": " << elapsed << "}";
+    record = ss.str();
+    return status;
+  }
+}
+
+std::vector<std::pair<int,std::vector<std::string> > >
+Batch::read_manifest(const std::string &filename){
+  std::ifstream is(filename);
+  if(!is){
+    throw std::logic_error("Failed to read batch manifest "+filename+".");
+  }
+  std::vector<std::pair<int,std::vector<std::string> > > lines;
+  std::string line;
+  for(int lineno = 1; std::getline(is,line); ++lineno){
+    std::stringstream ss(line);
+    std::vector<std::string> words;
+    std::string word;
+    while(ss >> word){
+      words.push_back(word);
+    }
+    if(words.empty() || words[0][0] == '#') continue;
+    lines.emplace_back(lineno,std::move(words));
+  }
+  return lines;
+}
+
+unsigned Batch::job_threads(const Job &job, unsigned n_threads){
+  return unsigned(std::max(1,std::min(job.conf.n_threads,int(n_threads))));
+}
+
+Batch::Summary Batch::run(const std::vector<Job> &jobs, unsigned n_threads,
+                          std::ostream &out){
+  n_threads = std::max(n_threads,1u);
+  /* Jobs that run side by side must not be bound to the same CPUs */
+  Cpubind::disable();
+
+  Summary summary;
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::size_t next = 0;
+  unsigned idle = n_threads;
+
+  auto worker = [&](){
+    std::unique_lock<std::mutex> lock(mutex);
+    while(true){
+      cv.wait(lock,[&](){
+        return next == jobs.size() || job_threads(jobs[next],n_threads) <= idle;
+      });
+      if(next == jobs.size()) return;
+      std::size_t index = next++;
+      unsigned threads = job_threads(jobs[index],n_threads);
+      idle -= threads;
+      lock.unlock();
+
+      std::string record;
+      Status status = run_job(jobs[index],index,threads,record);
+
+      lock.lock();
+      idle += threads;
+      switch(status){
+      case OK: ++summary.ok; break;
+      case ERROR: ++summary.errors; break;
+      case FAILURE: ++summary.failures; break;
+      }
+      out << record << std::endl;
+      cv.notify_all();
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for(unsigned i = 1; i < n_threads; ++i){
+    pool.emplace_back(worker);
+  }
+  worker();
+  for(std::thread &t : pool){
+    t.join();
+  }
+  return summary;
+}
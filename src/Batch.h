@@ -0,0 +1,91 @@
+/* Copyright (C) 2026 agent
+ *
+ * This file is part of Nidhugg.
+ *
+ * Nidhugg is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nidhugg is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#ifndef __BATCH_H__
+#define __BATCH_H__
+
+#include "Configuration.h"
+
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/* The Batch namespace runs many explorations in one process (see
+ * --batch), so that the process and LLVM start-up is paid once rather
+ * than once per test case.
+ */
+namespace Batch {
+
+  /* A job of a batch: the exploration of one input module. */
+  struct Job {
+    /* Identifies the job in result records, as MANIFEST:LINE. */
+    std::string name;
+    /* The LLVM assembly or bitcode file to explore. */
+    std::string input;
+    Configuration conf;
+  };
+
+  /* The outcome of a batch. */
+  struct Summary {
+    Summary() : ok(0), errors(0), failures(0) {};
+    /* The number of jobs that were explored without detecting any
+     * error. */
+    unsigned ok;
+    /* The number of jobs where an error was detected. */
+    unsigned errors;
+    /* The number of jobs that could not be explored, e.g. because the
+     * input could not be read. */
+    unsigned failures;
+  };
+
+  /* Reads the manifest file filename. Each line holds the switches
+   * and the input file of one job, as they would be given to nidhugg,
+   * separated by whitespace. Empty lines and lines starting with #
+   * are ignored.
+   *
+   * Returns the line number and the words of every job line. Throws
+   * std::logic_error if filename cannot be read.
+   */
+  std::vector<std::pair<int,std::vector<std::string> > >
+  read_manifest(const std::string &filename);
+
+  /* The number of threads of a pool of n_threads threads that job
+   * uses: min(job.conf.n_threads,n_threads), but at least 1.
+   */
+  unsigned job_threads(const Job &job, unsigned n_threads);
+
+  /* Explores jobs using a pool of n_threads threads. A job is
+   * explored with job_threads(job,n_threads) of them as its
+   * n_threads, and jobs are started in order whenever sufficiently
+   * many threads are idle. So small jobs run side by side, while a
+   * parallel job waits until it can have all its threads.
+   *
+   * When a job finishes, a result record for it is written to out as
+   * a JSON object on a single line. Records appear in order of
+   * completion; their "job" field is the index of the job in jobs.
+   */
+  Summary run(const std::vector<Job> &jobs, unsigned n_threads,
+              std::ostream &out);
+
+}
+
+#endif
@@ -0,0 +1,166 @@
+/* Copyright (C) 2026 agent
+ *
+ * This file is part of Nidhugg.
+ *
+ * Nidhugg is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nidhugg is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#ifdef HAVE_BOOST_UNIT_TEST_FRAMEWORK
+#include <boost/test/unit_test.hpp>
+
+#include "Batch.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+  /* A fresh temporary file holding contents, removed on
+   * destruction. */
+  struct TmpFile {
+    std::string path;
+    TmpFile(const std::string &contents, const std::string &suffix = ""){
+      char buf[] = "/tmp/nidhugg_Batch_test_XXXXXX";
+      int fd = mkstemp(buf);
+      close(fd);
+      unlink(buf);
+      path = std::string(buf) + suffix;
+      std::ofstream os(path);
+      os << contents;
+    }
+    ~TmpFile(){
+      unlink(path.c_str());
+    }
+  };
+
+  /* The records written by Batch::run, one per line. */
+  std::vector<std::string> lines_of(const std::string &s){
+    std::vector<std::string> lines;
+    std::stringstream ss(s);
+    std::string line;
+    while(std::getline(ss,line)){
+      lines.push_back(line);
+    }
+    return lines;
+  }
+
+  /* The record in records of the job with index index. */
+  std::string record_of(const std::vector<std::string> &records, int index){
+    std::string prefix = "{\"job\": " + std::to_string(index) + ",";
+    for(const std::string &r : records){
+      if(r.compare(0,prefix.size(),prefix) == 0) return r;
+    }
+    return "";
+  }
+
+  bool contains(const std::string &s, const std::string &t){
+    return s.find(t) != std::string::npos;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(Batch_test)
+
+BOOST_AUTO_TEST_CASE(Read_manifest){
+  TmpFile manifest("# A comment\n"
+                   "\n"
+                   "--sc a.ll\n"
+                   "   \n"
+                   "  # An indented comment\n"
+                   "  --tso\t--n-threads=2   b.ll  \n"
+                   "c.ll");
+  std::vector<std::pair<int,std::vector<std::string> > > lines =
+    Batch::read_manifest(manifest.path);
+  BOOST_REQUIRE_EQUAL(lines.size(), 3);
+  BOOST_CHECK_EQUAL(lines[0].first, 3);
+  BOOST_CHECK(lines[0].second == std::vector<std::string>({"--sc","a.ll"}));
+  BOOST_CHECK_EQUAL(lines[1].first, 6);
+  BOOST_CHECK(lines[1].second ==
+              std::vector<std::string>({"--tso","--n-threads=2","b.ll"}));
+  BOOST_CHECK_EQUAL(lines[2].first, 7);
+  BOOST_CHECK(lines[2].second == std::vector<std::string>({"c.ll"}));
+}
+
+BOOST_AUTO_TEST_CASE(Read_manifest_missing){
+  BOOST_CHECK_THROW(Batch::read_manifest("/nonexistent/nidhugg/manifest"),
+                    std::logic_error);
+}
+
+BOOST_AUTO_TEST_CASE(Job_threads){
+  Batch::Job job;
+  job.conf.n_threads = 1;
+  BOOST_CHECK_EQUAL(Batch::job_threads(job,8), 1);
+  job.conf.n_threads = 4;
+  BOOST_CHECK_EQUAL(Batch::job_threads(job,8), 4);
+  job.conf.n_threads = 64;
+  BOOST_CHECK_EQUAL(Batch::job_threads(job,8), 8);
+  job.conf.n_threads = 0;
+  BOOST_CHECK_EQUAL(Batch::job_threads(job,8), 1);
+}
+
+BOOST_AUTO_TEST_CASE(Run_thread_accounting){
+  /* Jobs that fail immediately, with more threads than the pool has */
+  std::vector<Batch::Job> jobs(3);
+  int n_threads[] = {1, 4, 64};
+  for(int i = 0; i < 3; ++i){
+    jobs[i].name = "manifest:" + std::to_string(i+1);
+    jobs[i].input = "/nonexistent/nidhugg/input" + std::to_string(i) + ".ll";
+    jobs[i].conf.n_threads = n_threads[i];
+  }
+  std::stringstream out;
+  Batch::Summary summary = Batch::run(jobs,8,out);
+  BOOST_CHECK_EQUAL(summary.ok, 0);
+  BOOST_CHECK_EQUAL(summary.errors, 0);
+  BOOST_CHECK_EQUAL(summary.failures, 3);
+  std::vector<std::string> records = lines_of(out.str());
+  BOOST_REQUIRE_EQUAL(records.size(), 3);
+  BOOST_CHECK(contains(record_of(records,0),"\"threads\": 1,"));
+  BOOST_CHECK(contains(record_of(records,1),"\"threads\": 4,"));
+  BOOST_CHECK(contains(record_of(records,2),"\"threads\": 8,"));
+  for(const std::string &r : records){
+    BOOST_CHECK(contains(r,"\"status\": \"failure\""));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Run_ok){
+  TmpFile input("define i32 @main(){\n"
+                "  ret i32 0\n"
+                "}\n",".ll");
+  std::vector<Batch::Job> jobs(2);
+  jobs[0].name = "manifest:1";
+  jobs[0].input = input.path;
+  jobs[1].name = "manifest:2";
+  jobs[1].input = "/nonexistent/nidhugg/input.ll";
+  std::stringstream out;
+  Batch::Summary summary = Batch::run(jobs,2,out);
+  BOOST_CHECK_EQUAL(summary.ok, 1);
+  BOOST_CHECK_EQUAL(summary.errors, 0);
+  BOOST_CHECK_EQUAL(summary.failures, 1);
+  std::vector<std::string> records = lines_of(out.str());
+  BOOST_REQUIRE_EQUAL(records.size(), 2);
+  BOOST_CHECK(contains(record_of(records,0),"\"status\": \"ok\""));
+  BOOST_CHECK(contains(record_of(records,0),"\"count\": 1,"));
+  BOOST_CHECK(contains(record_of(records,1),"\"name\": \"manifest:2\""));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
@@ -0,0 +1,107 @@
+/* Copyright (C) 2026 agent
+ *
+ * This file is part of Nidhugg.
+ *
+ * Nidhugg is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nidhugg is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include "BitRel.h"
+
+#include <algorithm>
+#include <cassert>
+
+void BitRel::clear(){
+  std::fill(bits.begin(),bits.end(),0);
+}
+
+BitRel &BitRel::operator|=(const BitRel &R){
+  assert(n == R.n);
+  uint64_t *dst = bits.data();
+  const uint64_t *src = R.bits.data();
+  const std::size_t sz = bits.size();
+  for(std::size_t w = 0; w < sz; ++w){
+    dst[w] |= src[w];
+  }
+  return *this;
+}
+
+BitRel BitRel::compose(const BitRel &R) const{
+  assert(n == R.n);
+  BitRel res(n);
+  for(int i = 0; i < n; ++i){
+    const uint64_t *ri = row(i);
+    uint64_t *dst = res.row(i);
+    for(int w = 0; w < row_words; ++w){
+      for(uint64_t word = ri[w]; word; word &= word-1){
+        const uint64_t *src = R.row(w*64 + __builtin_ctzll(word));
+        for(int v = 0; v < row_words; ++v){
+          dst[v] |= src[v];
+        }
+      }
+    }
+  }
+  return res;
+}
+
+void BitRel::transitive_closure(){
+  /* Warshall's algorithm: After iteration k, (i,j) is in the relation
+   * iff there is a path from i to j via elements smaller than or
+   * equal to k.
+   */
+  for(int k = 0; k < n; ++k){
+    const uint64_t *rk = row(k);
+    const uint64_t mask = uint64_t(1) << (k%64);
+    for(int i = 0; i < n; ++i){
+      uint64_t *ri = row(i);
+      if(ri[k/64] & mask){
+        for(int w = 0; w < row_words; ++w){
+          ri[w] |= rk[w];
+        }
+      }
+    }
+  }
+}
+
+bool BitRel::is_irreflexive(int *i) const{
+  for(int j = 0; j < n; ++j){
+    if((*this)(j,j)){
+      if(i) *i = j;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool BitRel::is_acyclic(int *i) const{
+  BitRel C(*this);
+  C.transitive_closure();
+  return C.is_irreflexive(i);
+}
+
+std::string BitRel::to_string() const{
+  std::string s = "{";
+  bool first = true;
+  for(int i = 0; i < n; ++i){
+    for(int j = 0; j < n; ++j){
+      if((*this)(i,j)){
+        if(!first) s += ",";
+        first = false;
+        s += "(" + std::to_string(i) + "," + std::to_string(j) + ")";
+      }
+    }
+  }
+  s += "}";
+  return s;
+}
@@ -0,0 +1,136 @@
+/* Copyright (C) 2026 agent
+ *
+ * This file is part of Nidhugg.
+ *
+ * Nidhugg is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nidhugg is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#ifndef __BIT_REL_H__
+#define __BIT_REL_H__
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <llvm/Support/raw_ostream.h>
+
+/* A BitRel is a binary relation over the elements 0, ..., n-1 for
+ * some fixed n, represented as a dense n*n bit matrix.
+ *
+ * Each row of the matrix (the successors of one element) is stored
+ * in 64-bit words, so that union, composition and closure operate on
+ * 64 elements at a time. This makes a BitRel suitable for whole
+ * relations over the events of a computation, where the closure would
+ * otherwise be computed over sparse sets.
+ */
+class BitRel{
+public:
+  /* Creates the empty relation over 0, ..., n-1. */
+  BitRel(int n = 0)
+    : n(n), row_words((n+63)/64), bits(std::size_t(n)*row_words,0) {};
+  BitRel(const BitRel&) = default;
+  BitRel(BitRel&&) = default;
+  BitRel &operator=(const BitRel&) = default;
+  BitRel &operator=(BitRel&&) = default;
+
+  /* The number of elements over which the relation is defined. */
+  int size() const { return n; };
+  /* Returns true iff (i,j) is in the relation. */
+  bool operator()(int i, int j) const{
+    return (row(i)[j/64] >> (j%64)) & 1;
+  };
+  /* Adds (i,j) to the relation. */
+  void insert(int i, int j){
+    row(i)[j/64] |= uint64_t(1) << (j%64);
+  };
+  /* Removes (i,j) from the relation. */
+  void erase(int i, int j){
+    row(i)[j/64] &= ~(uint64_t(1) << (j%64));
+  };
+  /* Removes all pairs from the relation. */
+  void clear();
+
+  /* Assigns this relation to the union of itself and R.
+   *
+   * Pre: R.size() == size()
+   */
+  BitRel &operator|=(const BitRel &R);
+  /* Returns the composition R1;R2 where R1 is this relation, i.e., the
+   * relation containing (i,k) iff there is some j such that (i,j) is
+   * in R1 and (j,k) is in R2.
+   *
+   * Pre: R.size() == size()
+   */
+  BitRel compose(const BitRel &R) const;
+  /* Assigns this relation to its transitive closure. */
+  void transitive_closure();
+  /* Returns true iff there is no i such that (i,i) is in the
+   * relation. Returns the smallest such i in *i otherwise, if i is
+   * non-null.
+   */
+  bool is_irreflexive(int *i = nullptr) const;
+  /* Returns true iff the relation is acyclic. Otherwise the smallest
+   * element which is part of a cycle is stored in *i, if i is
+   * non-null.
+   */
+  bool is_acyclic(int *i = nullptr) const;
+  /* Calls f(i,j) for each pair (i,j) in the relation, in
+   * lexicographic order.
+   */
+  template<typename F> void for_each(F f) const{
+    for(int i = 0; i < n; ++i){
+      const uint64_t *ri = row(i);
+      for(int w = 0; w < row_words; ++w){
+        for(uint64_t word = ri[w]; word; word &= word-1){
+          f(i,w*64 + __builtin_ctzll(word));
+        }
+      }
+    }
+  };
+
+  bool operator==(const BitRel &R) const { return n == R.n && bits == R.bits; };
+  bool operator!=(const BitRel &R) const { return !(*this == R); };
+
+  /* Returns a string representation of the relation, listing its
+   * pairs in lexicographic order. E.g. "{(0,1),(1,2)}".
+   */
+  std::string to_string() const;
+private:
+  /* The number of elements. */
+  int n;
+  /* The number of words in each row. */
+  int row_words;
+  /* Row i occupies bits[i*row_words, (i+1)*row_words). Bit j%64 of
+   * word j/64 of row i is set iff (i,j) is in the relation. All bits
+   * for columns from n onwards are 0.
+   */
+  std::vector<uint64_t> bits;
+
+  uint64_t *row(int i) { return bits.data() + std::size_t(i)*row_words; };
+  const uint64_t *row(int i) const { return bits.data() + std::size_t(i)*row_words; };
+};
+
+inline std::ostream &operator<<(std::ostream &os, const BitRel &R){
+  return os << R.to_string();
+}
+
+inline llvm::raw_ostream &operator<<(llvm::raw_ostream &os, const BitRel &R){
+  return os << R.to_string();
+}
+
+#endif
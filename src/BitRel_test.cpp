@@ -0,0 +1,122 @@
+/* Copyright (C) 2026 agent
+ *
+ * This file is part of Nidhugg.
+ *
+ * Nidhugg is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nidhugg is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#ifdef HAVE_BOOST_UNIT_TEST_FRAMEWORK
+#include <boost/test/unit_test.hpp>
+
+#include "BitRel.h"
+
+#include <utility>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(BitRel_test)
+
+BOOST_AUTO_TEST_CASE(Insert_and_access){
+  BitRel R(130);
+  BOOST_CHECK_EQUAL(R.size(), 130);
+  BOOST_CHECK(!R(0,0));
+  R.insert(0,129);
+  R.insert(129,64);
+  R.insert(3,63);
+  BOOST_CHECK(R(0,129));
+  BOOST_CHECK(R(129,64));
+  BOOST_CHECK(R(3,63));
+  BOOST_CHECK(!R(129,0));
+  BOOST_CHECK(!R(3,64));
+  R.erase(0,129);
+  BOOST_CHECK(!R(0,129));
+  R.clear();
+  BOOST_CHECK(R == BitRel(130));
+}
+
+BOOST_AUTO_TEST_CASE(To_string){
+  BitRel R(3);
+  BOOST_CHECK(R.to_string() == "{}");
+  R.insert(1,2);
+  R.insert(0,1);
+  BOOST_CHECK(R.to_string() == "{(0,1),(1,2)}");
+}
+
+BOOST_AUTO_TEST_CASE(For_each){
+  BitRel R(130);
+  R.insert(129,0);
+  R.insert(0,129);
+  R.insert(0,64);
+  R.insert(64,63);
+  std::vector<std::pair<int,int> > pairs;
+  R.for_each([&pairs](int i, int j){ pairs.emplace_back(i,j); });
+  BOOST_CHECK(pairs == (std::vector<std::pair<int,int> >{{0,64},{0,129},{64,63},{129,0}}));
+}
+
+BOOST_AUTO_TEST_CASE(Union){
+  BitRel A(70), B(70);
+  A.insert(0,1);
+  B.insert(69,68);
+  A |= B;
+  BOOST_CHECK(A(0,1));
+  BOOST_CHECK(A(69,68));
+  BOOST_CHECK(!B(0,1));
+}
+
+BOOST_AUTO_TEST_CASE(Compose){
+  BitRel A(100), B(100);
+  A.insert(0,70);
+  A.insert(1,2);
+  B.insert(70,99);
+  B.insert(70,3);
+  B.insert(5,6);
+  BitRel C = A.compose(B);
+  BitRel expected(100);
+  expected.insert(0,99);
+  expected.insert(0,3);
+  BOOST_CHECK(C == expected);
+}
+
+BOOST_AUTO_TEST_CASE(Transitive_closure){
+  BitRel R(200);
+  for(int i = 0; i < 199; ++i){
+    R.insert(i,i+1);
+  }
+  R.transitive_closure();
+  BOOST_CHECK(R(0,199));
+  BOOST_CHECK(R(63,64));
+  BOOST_CHECK(R(10,150));
+  BOOST_CHECK(!R(150,10));
+  BOOST_CHECK(R.is_irreflexive());
+}
+
+BOOST_AUTO_TEST_CASE(Acyclic){
+  BitRel R(80);
+  R.insert(5,70);
+  R.insert(70,20);
+  BOOST_CHECK(R.is_acyclic());
+  R.insert(20,5);
+  int i = -1;
+  BOOST_CHECK(!R.is_acyclic(&i));
+  BOOST_CHECK_EQUAL(i, 5);
+  /* is_acyclic does not modify the relation */
+  BOOST_CHECK(!R(5,5));
+  BOOST_CHECK(!R(5,20));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
@@ -19,67 +19,182 @@
 
 #include "CPid.h"
 
+#include <atomic>
 #include <cassert>
+#include <mutex>
 #include <sstream>
+#include <stdexcept>
 
-CPid::CPid() : aux_idx(-1) {}
+namespace {
 
-CPid::CPid(const std::vector<int> &pvec){
+  /* The global table of interned CPids.
+   *
+   * A CPid is either <0>, or the real child <p0.....pn.i> or the
+   * auxiliary child <p0.....pn/i> of some real CPid <p0.....pn>. The
+   * table maps each (parent,kind,i) to the id of that child, and
+   * stores a node for each id.
+   *
+   * Nodes are never moved or removed once created, so they can be
+   * read without locking. Nodes live in chunks of geometrically
+   * increasing size, where chunk k holds the ids
+   * [FIRST_CHUNK*(2^k-1), FIRST_CHUNK*(2^(k+1)-1)). Creating a node
+   * is done under a mutex.
+   */
+  class CPidTable{
+  public:
+    class Node{
+    public:
+      /* For <p0.p1.....pn> or <p0.p1.....pn/i>, proc_seq is
+       * [p1,...,pn]. */
+      std::vector<int> proc_seq;
+      /* -1 for real processes, i for <p0.....pn/i>. */
+      int aux_idx;
+      /* The id of the parent, or 0 for <0>. */
+      uint32_t parent;
+    };
+
+    static CPidTable &get(){
+      static CPidTable T;
+      return T;
+    };
+
+    const Node &operator[](uint32_t id) const {
+      int k;
+      uint32_t offset;
+      locate(id,&k,&offset);
+      const Node *chunk = chunks[k].load(std::memory_order_acquire);
+      assert(chunk);
+      return chunk[offset];
+    };
+
+    /* Returns the id of the real (if aux is false) or auxiliary (if
+     * aux is true) child i of the real CPid parent, creating it if
+     * necessary.
+     */
+    uint32_t child(uint32_t parent, bool aux, int i){
+      assert(0 <= i);
+      uint64_t key = (uint64_t(parent) << 32) | (uint64_t(i) << 1) | uint64_t(aux);
+      std::lock_guard<std::mutex> lock(mutex);
+      auto it = children.find(key);
+      if(it != children.end()) return it->second;
+      const Node &pn = (*this)[parent];
+      assert(pn.aux_idx < 0);
+      uint32_t id = add_node();
+      Node &n = node(id);
+      n.proc_seq = pn.proc_seq;
+      if(aux){
+        n.aux_idx = i;
+      }else{
+        n.proc_seq.push_back(i);
+        n.aux_idx = -1;
+      }
+      n.parent = parent;
+      children[key] = id;
+      return id;
+    };
+  private:
+    static const uint32_t FIRST_CHUNK = 64;
+    static const int MAX_CHUNKS = 26;
+
+    CPidTable() : size(0) {
+      for(int k = 0; k < MAX_CHUNKS; ++k) chunks[k].store(nullptr);
+      /* The root <0> */
+      uint32_t root = add_node();
+      assert(root == 0);
+      node(root).aux_idx = -1;
+      node(root).parent = 0;
+    };
+    ~CPidTable(){
+      for(int k = 0; k < MAX_CHUNKS; ++k) delete[] chunks[k].load();
+    };
+
+    static void locate(uint32_t id, int *k, uint32_t *offset){
+      uint32_t j = id / FIRST_CHUNK + 1;
+      *k = 31 - __builtin_clz(j);
+      *offset = id - FIRST_CHUNK * ((uint32_t(1) << *k) - 1);
+    };
+
+    Node &node(uint32_t id){
+      int k;
+      uint32_t offset;
+      locate(id,&k,&offset);
+      return chunks[k].load(std::memory_order_relaxed)[offset];
+    };
+
+    /* Allocates a new node and returns its id. Called under mutex. */
+    uint32_t add_node(){
+      uint32_t id = size++;
+      int k;
+      uint32_t offset;
+      locate(id,&k,&offset);
+      if(k >= MAX_CHUNKS){
+        throw std::logic_error("CPidTable: Too many distinct CPids.");
+      }
+      if(offset == 0){
+        chunks[k].store(new Node[FIRST_CHUNK << k],std::memory_order_release);
+      }
+      return id;
+    };
+
+    std::mutex mutex;
+    std::atomic<Node*> chunks[MAX_CHUNKS];
+    /* The number of nodes. */
+    uint32_t size;
+    /* See the class comment. */
+    std::unordered_map<uint64_t,uint32_t> children;
+  };
+
+}
+
+CPid::CPid() : id(0) {}
+
+CPid::CPid(const std::vector<int> &pvec) : id(0) {
   assert(pvec.size() > 0);
   assert(pvec[0] == 0);
-  auto b = pvec.begin();
-  ++b;
-  proc_seq = std::vector<int>(b,pvec.end());
-  aux_idx = -1;
+  for(unsigned i = 1; i < pvec.size(); ++i){
+    id = CPidTable::get().child(id,false,pvec[i]);
+  }
 }
 
-CPid::CPid(const std::initializer_list<int> &il){
+CPid::CPid(const std::initializer_list<int> &il) : id(0) {
   auto b = il.begin();
   assert(b != il.end());
   assert(*b == 0);
-  ++b;
-  proc_seq = std::vector<int>(b,il.end());
-  aux_idx = -1;
+  for(++b; b != il.end(); ++b){
+    id = CPidTable::get().child(id,false,*b);
+  }
 }
 
-CPid::CPid(const std::vector<int> &pvec, int i){
-  assert(pvec.size() > 0);
-  assert(pvec[0] == 0);
+CPid::CPid(const std::vector<int> &pvec, int i) : CPid(pvec) {
   assert(i >= 0);
-  auto b = pvec.begin();
-  ++b;
-  proc_seq = std::vector<int>(b,pvec.end());
-  aux_idx = i;
+  id = CPidTable::get().child(id,true,i);
 }
 
 CPid CPid::spawn(int pn1) const{
   assert(!is_auxiliary());
   assert(0 <= pn1);
-  CPid c = *this;
-  c.proc_seq.push_back(pn1);
-  return c;
+  return CPid(CPidTable::get().child(id,false,pn1));
 }
 
 CPid CPid::aux(int i) const{
   assert(!is_auxiliary());
   assert(0 <= i);
-  CPid c = *this;
-  c.aux_idx = i;
-  return c;
+  return CPid(CPidTable::get().child(id,true,i));
 }
 
 bool CPid::is_auxiliary() const{
-  return aux_idx >= 0;
+  return CPidTable::get()[id].aux_idx >= 0;
 }
 
 std::string CPid::to_string() const{
+  const CPidTable::Node &n = CPidTable::get()[id];
   std::stringstream ss;
   ss << "<0";
-  for(unsigned i = 0; i < proc_seq.size(); ++i){
-    ss << "." << proc_seq[i];
+  for(unsigned i = 0; i < n.proc_seq.size(); ++i){
+    ss << "." << n.proc_seq[i];
   }
-  if(is_auxiliary()){
-    ss << "/" << aux_idx;
+  if(n.aux_idx >= 0){
+    ss << "/" << n.aux_idx;
   }
   ss << ">";
   return ss.str();
@@ -87,38 +202,36 @@ std::string CPid::to_string() const{
 
 CPid CPid::parent() const{
   assert(has_parent());
-  CPid cp(*this);
-  if(is_auxiliary()){
-    cp.aux_idx = -1;
-  }else{
-    cp.proc_seq.pop_back();
-  }
-  return cp;
+  return CPid(CPidTable::get()[id].parent);
 }
 
 bool CPid::has_parent() const{
-  return proc_seq.size() || is_auxiliary();
+  return id != 0;
 }
 
 int CPid::compare(const CPid &c) const{
+  if(id == c.id) return 0;
+  const CPidTable &T = CPidTable::get();
+  const std::vector<int> &proc_seq = T[id].proc_seq;
+  const std::vector<int> &c_proc_seq = T[c.id].proc_seq;
   unsigned i = 0;
-  while(i < proc_seq.size() && i < c.proc_seq.size()){
-    if(proc_seq[i] < c.proc_seq[i]) return -1;
-    if(proc_seq[i] > c.proc_seq[i]) return 1;
+  while(i < proc_seq.size() && i < c_proc_seq.size()){
+    if(proc_seq[i] < c_proc_seq[i]) return -1;
+    if(proc_seq[i] > c_proc_seq[i]) return 1;
     ++i;
   }
-  if(i < c.proc_seq.size()) return -1;
+  if(i < c_proc_seq.size()) return -1;
   if(i < proc_seq.size()) return 1;
-  if(aux_idx == c.aux_idx || (!is_auxiliary() && !c.is_auxiliary())){
-    return 0;
-  }
-  if(aux_idx < c.aux_idx) return -1;
+  /* Same sequence, but distinct ids: At most one is real (aux_idx ==
+   * -1), and it is ordered first. */
+  assert(T[id].aux_idx != T[c.id].aux_idx);
+  if(T[id].aux_idx < T[c.id].aux_idx) return -1;
   return 1;
 }
 
 int CPid::get_aux_index() const{
   assert(is_auxiliary());
-  return aux_idx;
+  return CPidTable::get()[id].aux_idx;
 }
 
 CPidSystem::CPidSystem(){
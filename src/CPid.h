@@ -22,9 +22,12 @@
 #ifndef __CPID_H__
 #define __CPID_H__
 
+#include <cstdint>
+#include <functional>
 #include <initializer_list>
 #include <map>
 #include <ostream>
+#include <unordered_map>
 #include <vector>
 
 #include <llvm/Support/raw_ostream.h>
@@ -35,6 +38,12 @@
  * process with CPid <p0.....pn> has CPid <p0.....pn.i>. For
  * auxilliary processes, the CPid of the i:th auxilliary process of a
  * real process with CPid <p0.....pn> is <p0.....pn/i>.
+ *
+ * CPids are hash-consed: Each distinct CPid is interned in a global,
+ * thread-safe table and represented by its 32-bit index in that
+ * table. Copying CPids and comparing them for equality are therefore
+ * constant time and allocation free. The sequence <p0.....pn> is
+ * materialised only when a CPid is printed.
  */
 class CPid{
 public:
@@ -73,25 +82,39 @@ public:
 
   std::string to_string() const;
 
-  /* Comparison implements a total order over CPids. */
-  bool operator==(const CPid &c) const { return compare(c) == 0; };
-  bool operator!=(const CPid &c) const { return compare(c) != 0; };
+  /* The index of this CPid in the interning table. Equal CPids have
+   * equal ids. The id of <0> is 0; other ids depend on the order in
+   * which CPids are first created in this process, and should not be
+   * relied upon for ordering.
+   */
+  uint32_t get_id() const { return id; };
+
+  /* Comparison implements a total order over CPids. The order is the
+   * lexicographic order of the sequences, with a real process before
+   * its auxiliaries.
+   */
+  bool operator==(const CPid &c) const { return id == c.id; };
+  bool operator!=(const CPid &c) const { return id != c.id; };
   bool operator<(const CPid &c) const { return compare(c) < 0; };
   bool operator<=(const CPid &c) const { return compare(c) <= 0; };
   bool operator>(const CPid &c) const { return compare(c) > 0; };
   bool operator>=(const CPid &c) const { return compare(c) >= 0; };
 private:
-  /* For a CPid <p0.p1.....pn> or <p0.p1.....pn/i>, the vector
-   * proc_seq is [p1,...,pn]. */
-  std::vector<int> proc_seq;
-  /* For the CPid of a real process, aux_idx == -1. For the CPid
-   * <p0.....pn/i> of an auxilliary process, aux_idx == i.
-   */
-  int aux_idx;
+  explicit CPid(uint32_t id) : id(id) {};
+  /* The index of this CPid in the interning table (see CPid.cpp). */
+  uint32_t id;
 
   int compare(const CPid &c) const;
 };
 
+namespace std {
+template<> struct hash<CPid>{
+public:
+  hash() {}
+  std::size_t operator()(const CPid &c) const { return c.get_id(); }
+};
+}
+
 inline std::ostream &operator<<(std::ostream &os, const CPid &c){
   return os << c.to_string();
 }
@@ -147,7 +170,7 @@ private:
   std::vector<std::vector<int> > aux_children;
   std::vector<int> parent;
   std::vector<CPid> cpids;
-  std::map<CPid,int> identifiers;
+  std::unordered_map<CPid,int> identifiers;
 };
 
 #endif
@@ -24,6 +24,8 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <thread>
+
 BOOST_AUTO_TEST_SUITE(CPid_test)
 
 BOOST_AUTO_TEST_CASE(Spawn_Aux){
@@ -96,6 +98,50 @@ BOOST_AUTO_TEST_CASE(CPidSystem_copy_construct){
   BOOST_CHECK_EQUAL(CPS0.new_aux(CPid({0,0})),CPid({0,0},0));
 }
 
+BOOST_AUTO_TEST_CASE(Interning){
+  CPid p0;
+  BOOST_CHECK_EQUAL(p0.get_id(),0u);
+  BOOST_CHECK_EQUAL(CPid({0,3,1}).get_id(),p0.spawn(3).spawn(1).get_id());
+  BOOST_CHECK_EQUAL(CPid({0,3},2).get_id(),p0.spawn(3).aux(2).get_id());
+  BOOST_CHECK(CPid({0,3},2).get_id() != CPid({0,3,2}).get_id());
+  BOOST_CHECK_EQUAL(CPid({0,3,1}).to_string(),"<0.3.1>");
+  BOOST_CHECK_EQUAL(CPid({0,3},2).to_string(),"<0.3/2>");
+  BOOST_CHECK_EQUAL(CPid({0,3},2).get_aux_index(),2);
+}
+
+BOOST_AUTO_TEST_CASE(Order){
+  /* The order does not depend on the order of interning. */
+  CPid a = CPid({0,7,9,9});
+  CPid b = CPid({0,7,9});
+  BOOST_CHECK(b < a);
+  BOOST_CHECK(b < b.aux(0));
+  BOOST_CHECK(b.aux(0) < b.aux(1));
+  BOOST_CHECK(b.aux(1) < a);
+  BOOST_CHECK(CPid({0,7,8,9}) < b);
+  BOOST_CHECK(b <= b);
+  BOOST_CHECK(!(b < b));
+}
+
+BOOST_AUTO_TEST_CASE(Concurrent_interning){
+  const int N = 4;
+  std::vector<std::vector<CPid> > res(N);
+  std::vector<std::thread> threads;
+  for(int t = 0; t < N; ++t){
+    threads.emplace_back([t,&res](){
+        for(int i = 0; i < 200; ++i){
+          res[t].push_back(CPid({0,100+i%20,i}).aux(i%3));
+        }
+      });
+  }
+  for(std::thread &t : threads) t.join();
+  for(int t = 1; t < N; ++t){
+    for(int i = 0; i < 200; ++i){
+      BOOST_CHECK_EQUAL(res[t][i].get_id(),res[0][i].get_id());
+    }
+  }
+  BOOST_CHECK_EQUAL(res[0][5].to_string(),"<0.105.5/2>");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 #endif
@@ -33,8 +33,23 @@ cl_program_arguments(llvm::cl::desc("[-- <program arguments>...]"),
                      llvm::cl::ZeroOrMore);
 llvm::cl::opt<std::string>
 cl_transform("transform",llvm::cl::init(""),
-             llvm::cl::desc("Transform the input module and store it (as LLVM assembly) to OUTFILE."),
+             llvm::cl::desc("Transform the input module and store it to OUTFILE\n"
+                            "(as bitcode if OUTFILE ends in .bc, otherwise as LLVM assembly)."),
              llvm::cl::NotHidden,llvm::cl::value_desc("OUTFILE"));
+static llvm::cl::opt<bool>
+cl_transform_first("transform-first",llvm::cl::NotHidden,
+                   llvm::cl::desc("Transform the input module in memory, as with\n"
+                                  "--transform, and then analyze the result."));
+llvm::cl::opt<std::string>
+cl_batch("batch",llvm::cl::NotHidden,llvm::cl::value_desc("MANIFEST"),
+         llvm::cl::desc("Explore each job in MANIFEST, given one per line as\n"
+                        "switches and an input file, and print one JSON\n"
+                        "result record per job."));
+llvm::cl::opt<unsigned>
+cl_batch_threads("batch-threads",llvm::cl::NotHidden,llvm::cl::init(0),
+                 llvm::cl::value_desc("N"),
+                 llvm::cl::desc("Run the --batch jobs on N threads\n"
+                                "(default: the number of hardware threads)."));
 
 static llvm::cl::opt<bool> cl_keep_going("keep-going",llvm::cl::NotHidden,
                                           llvm::cl::desc("Continue exploring all traces,\n"
@@ -98,6 +113,20 @@ cl_sat(llvm::cl::NotHidden, llvm::cl::init(Configuration::SMTLIB),
 #endif
                                  ));
 
+static llvm::cl::opt<bool>
+cl_sat_portfolio("sat-portfolio",llvm::cl::NotHidden,
+                 llvm::cl::desc("With --rf, race the prefix heuristic against\n"
+                                "the SAT solver on idle threads."));
+
+static llvm::cl::opt<unsigned>
+cl_sat_cache_size("sat-cache-size",llvm::cl::NotHidden,llvm::cl::init(64),
+                  llvm::cl::value_desc("N"),
+                  llvm::cl::desc("With --rf, remember the answers to recent\n"
+                                 "satisfiability queries in at most about N MiB\n"
+                                 "(default 64). 0 disables the cache. Its hits\n"
+                                 "and misses are reported by --print-progress\n"
+                                 "and --stats-json."));
+
 
 static llvm::cl::opt<Configuration::DPORAlgorithm>
 cl_dpor_algorithm(llvm::cl::NotHidden, llvm::cl::init(Configuration::SOURCE),
@@ -131,6 +160,19 @@ cl_transform_loop_unroll("unroll",
                          llvm::cl::desc("Bound executions by allowing loops to iterate at\n"
                                         "most N times."));
 
+static llvm::cl::opt<std::string>
+cl_module_cache("module-cache",llvm::cl::NotHidden,llvm::cl::value_desc("DIR"),
+                llvm::cl::cat(cl_transformation_cat),
+                llvm::cl::desc("With --transform-first, cache transformed modules\n"
+                               "in the directory DIR, and reuse them when the\n"
+                               "same input is transformed with the same switches."));
+
+static llvm::cl::opt<unsigned>
+cl_module_cache_size("module-cache-size",llvm::cl::NotHidden,llvm::cl::init(1024),
+                     llvm::cl::value_desc("N"),llvm::cl::cat(cl_transformation_cat),
+                     llvm::cl::desc("Limit the size of the --module-cache directory\n"
+                                    "to N MiB (default 1024)."));
+
 static llvm::cl::opt<bool> cl_print_progress("print-progress",llvm::cl::NotHidden,
                                              llvm::cl::desc("Continually print analysis progress to stdout."));
 
@@ -138,6 +180,17 @@ static llvm::cl::opt<bool> cl_print_progress_estimate("print-progress-estimate",
                                                       llvm::cl::desc("Continually print analysis progress and trace\n"
                                                                      "number estimate to stdout."));
 
+static llvm::cl::opt<std::string>
+cl_stats_json("stats-json",llvm::cl::NotHidden,llvm::cl::value_desc("FILE"),
+              llvm::cl::desc("Write statistics of the analysis as JSON to FILE.\n"
+                             "Implies collecting the timing information of --time."));
+
+static llvm::cl::opt<int>
+cl_stats_json_interval("stats-json-interval",llvm::cl::NotHidden,llvm::cl::init(0),
+                       llvm::cl::value_desc("N"),
+                       llvm::cl::desc("With --stats-json, also rewrite FILE every N\n"
+                                      "seconds during the analysis."));
+
 static llvm::cl::list<std::string> cl_extfun_no_race("extfun-no-race",llvm::cl::NotHidden,
                                                          llvm::cl::value_desc("FUN"),
                                                          llvm::cl::desc("Assume that the external function FUN, when called\n"
@@ -178,13 +231,17 @@ const std::set<std::string> &Configuration::commandline_opts(){
     "n-threads",
     "no-cpubind","no-cpubind-singlify",
     "sc","tso","pso","power","arm","ccv","cm","cc",
-    "smtlib",
+    "smtlib","sat-portfolio","sat-cache-size",
     "source","optimal","observers","rf",
     "check-robustness",
     "no-spin-assume",
+    "transform-first",
+    "batch","batch-threads",
+    "module-cache","module-cache-size",
     "unroll",
     "print-progress",
-    "print-progress-estimate"
+    "print-progress-estimate",
+    "stats-json","stats-json-interval"
   };
   return opts;
 }
@@ -205,14 +262,21 @@ void Configuration::assign_by_commandline(){
   c11 = cl_c11;
   dpor_algorithm = cl_dpor_algorithm;
   check_robustness = cl_check_robustness;
+  transform_first = cl_transform_first;
   transform_spin_assume = !cl_transform_no_spin_assume;
   transform_loop_unroll = cl_transform_loop_unroll;
+  module_cache_dir = cl_module_cache;
+  module_cache_size = uint64_t(cl_module_cache_size) << 20;
   if (cl_verifier_nondet_int.getNumOccurrences())
     svcomp_nondet_int = (int)cl_verifier_nondet_int;
   print_progress = cl_print_progress || cl_print_progress_estimate;
   print_progress_estimate = cl_print_progress_estimate;
+  stats_json = cl_stats_json;
+  stats_json_interval = cl_stats_json_interval;
   debug_print_on_reset = cl_debug_print_on_reset;
   sat_solver = cl_sat;
+  sat_portfolio = cl_sat_portfolio;
+  sat_cache_size = uint64_t(cl_sat_cache_size) << 20;
   argv.resize(1);
   argv[0] = get_default_program_name();
   for(std::string a : cl_program_arguments){
@@ -255,6 +319,10 @@ void Configuration::check_commandline(){
       Debug::warn("Configuration::check_commandline:transform:print-progress-estimate")
         << "WARNING: --print-progress-estimate ignored in presence of --transform.\n";
     }
+    if(cl_stats_json.getNumOccurrences()){
+      Debug::warn("Configuration::check_commandline:transform:stats-json")
+        << "WARNING: --stats-json ignored in presence of --transform.\n";
+    }
     if(cl_check_robustness.getNumOccurrences()){
       Debug::warn("Configuration::check_commandline:transform:check_robustness")
         << "WARNING: --robustness ignored in presence of --transform.\n";
@@ -263,16 +331,40 @@ void Configuration::check_commandline(){
       Debug::warn("Configuration::check_commandline:transform:program_arguments")
         << "WARNING: Program arguments (argv for test case) ignored in presence of --transform.\n";
     }
+    if(cl_transform_first){
+      Debug::warn("Configuration::check_commandline:transform:transform-first")
+        << "WARNING: --transform-first ignored in presence of --transform.\n";
+    }
+    if(cl_module_cache.getNumOccurrences()){
+      Debug::warn("Configuration::check_commandline:transform:module-cache")
+        << "WARNING: --module-cache ignored in presence of --transform.\n";
+    }
   }else{
-    if(cl_transform_no_spin_assume.getNumOccurrences()){
+    if(cl_stats_json_interval.getNumOccurrences() && cl_stats_json == ""){
+      Debug::warn("Configuration::check_commandline:stats-json-interval")
+        << "WARNING: --stats-json-interval ignored in absence of --stats-json.\n";
+    }
+    if(cl_transform_no_spin_assume.getNumOccurrences() && !cl_transform_first){
       Debug::warn("Configuration::check_commandline:no:transform:transform-no-spin-assume")
-        << "WARNING: --no-spin-assume ignored in absence of --transform.\n";
+        << "WARNING: --no-spin-assume ignored in absence of --transform or --transform-first.\n";
     }
-    if(cl_transform_loop_unroll.getNumOccurrences()){
+    if(cl_transform_loop_unroll.getNumOccurrences() && !cl_transform_first){
       Debug::warn("Configuration::check_commandline:no:transform:transform_loop_unroll")
-        << "WARNING: --unroll ignored in absence of --transform.\n";
+        << "WARNING: --unroll ignored in absence of --transform or --transform-first.\n";
+    }
+    if(cl_module_cache.getNumOccurrences() && !cl_transform_first){
+      Debug::warn("Configuration::check_commandline:no:transform-first:module-cache")
+        << "WARNING: --module-cache ignored in absence of --transform-first.\n";
     }
   }
+  if(cl_batch_threads.getNumOccurrences() && cl_batch == ""){
+    Debug::warn("Configuration::check_commandline:batch-threads")
+      << "WARNING: --batch-threads ignored in absence of --batch.\n";
+  }
+  if(cl_module_cache_size.getNumOccurrences() && cl_module_cache == ""){
+    Debug::warn("Configuration::check_commandline:module-cache-size")
+      << "WARNING: --module-cache-size ignored in absence of --module-cache.\n";
+  }
   /* Check commandline switch compatibility with memory model. */
   {
     std::string mm;
@@ -315,6 +407,11 @@ void Configuration::check_commandline(){
         << "WARNING: Optimal Reads-From-SMC not implemented for memory model " << mm << ".\n";
     }
 
+    if (cl_sat_portfolio && cl_dpor_algorithm != Configuration::READS_FROM) {
+      Debug::warn("Configuration::check_commandline:sat-portfolio:dpor")
+        << "WARNING: --sat-portfolio ignored without --rf.\n";
+    }
+
     if (cl_c11 && cl_memory_model != Configuration::SC) {
       Debug::warn("Configuration::check_commandline:c11:mm")
         << "WARNING: --c11 is not yet implemented for memory model " << mm << ".\n";
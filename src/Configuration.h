@@ -29,6 +29,7 @@
 #include <set>
 #include <string>
 #include <memory>
+#include <cstdint>
 
 /* A Configuration object keeps track of all configuration options
  * that should be used during a program analysis. The configuration
@@ -95,13 +96,18 @@ public:
     debug_collect_all_traces = false;
     debug_print_on_reset = false;
     debug_print_on_error = false;
+    transform_first = false;
     transform_spin_assume = true;
     transform_loop_unroll = -1;
+    module_cache_size = uint64_t(1024) << 20;
     svcomp_nondet_int = nullptr;
     print_progress = false;
     print_progress_estimate = false;
+    stats_json_interval = 0;
     exploration_scheduler = WORKSTEALING;
     sat_solver = SMTLIB;
+    sat_portfolio = false;
+    sat_cache_size = uint64_t(64) << 20;
     argv.push_back(get_default_program_name());
   };
   /* Read the switches given to the program by the user. Assign
@@ -171,7 +177,8 @@ public:
    *
    * WARNING: This quickly grows out of hand. Should be used only
    * for modules known to have few traces. Automated testing is the
-   * intended usage.
+   * intended usage. To process the traces of larger modules, pass a
+   * DPORDriver::TraceSink to DPORDriver::run instead.
    */
   bool debug_collect_all_traces;
   /* If set, the trace builder is instructed to debug print its state
@@ -182,6 +189,10 @@ public:
    * when an error is reported.
    */
   bool debug_print_on_error;
+  /* If set, DPORDriver::fromInput transforms the input module (see
+   * Transform::transform) before it is explored.
+   */
+  bool transform_first;
   /* In module transformation, enable the SpinAssume pass. */
   bool transform_spin_assume;
   /* If transform_loop_unroll is non-negative, in module
@@ -189,6 +200,14 @@ public:
    * transform_loop_unroll.
    */
   int transform_loop_unroll;
+  /* If non-empty, the modules transformed due to transform_first are
+   * cached as bitcode in the directory module_cache_dir, keyed by the
+   * input module and the transformation settings. Least recently used
+   * modules are evicted when the cache exceeds module_cache_size
+   * bytes.
+   */
+  std::string module_cache_dir;
+  uint64_t module_cache_size;
   /* Number to return from __VERIFIER_nondet_u?int() */
   Option<int> svcomp_nondet_int;
   /* If set, DPORDriver will continually print its progress to stdout. */
@@ -198,10 +217,24 @@ public:
    * traces.
    */
   bool print_progress_estimate;
+  /* If non-empty, DPORDriver writes statistics of the exploration as a
+   * JSON document to the file stats_json when the exploration ends,
+   * and, if stats_json_interval > 0, also every stats_json_interval
+   * seconds during the exploration. Each document replaces the
+   * previous one.
+   */
+  std::string stats_json;
+  int stats_json_interval;
 
   /* When running RFSC, Set the amount of threads that does the exploration.
    * The main thread will only consume results from the n-1 worker threads.
    * If n=1 the algorithm operates purely sequential.
+   *
+   * With Optimal-DPOR under SC or TSO, n>1 instead makes race
+   * detection compute wakeup sequences using n threads.
+   *
+   * Under POWER and ARM, n>1 makes n threads explore disjoint parts
+   * of the execution tree.
    */
   int n_threads;
 
@@ -216,6 +249,17 @@ public:
         SMTLIB,
   } sat_solver;
   std::unique_ptr<SatSolver> get_sat_solver() const;
+  /* If set, RFSC decides each candidate sibling by racing the prefix
+   * heuristic against the SAT solver, using the first definitive
+   * answer, rather than only calling the solver when the heuristic
+   * fails.
+   */
+  bool sat_portfolio;
+  /* The approximate number of bytes used by the cache of answers to
+   * satisfiability queries of RFSC (RFSCSatCache). Least recently used
+   * answers are evicted when it is full. 0 disables the cache.
+   */
+  uint64_t sat_cache_size;
   /* The arguments that will be passed to the program under test */
   std::vector<std::string> argv;
   /* The default program name to send to the program under test as
@@ -48,6 +48,10 @@ cl_pack("cpubind-pack", llvm::cl::NotHidden, llvm::cl::init(HWLOC_OBJ_CORE),
 #endif
                         ));
 
+  bool disabled = false;
+
+  bool nobind() { return cl_nobind || disabled; }
+
   std::string bitmap_to_string(hwloc_bitmap_t bitmap) {
     std::string str;
     int length = hwloc_bitmap_list_snprintf(NULL, 0, bitmap);
@@ -68,7 +72,7 @@ cl_pack("cpubind-pack", llvm::cl::NotHidden, llvm::cl::init(HWLOC_OBJ_CORE),
 }
 
 Cpubind::Cpubind(int n) {
-  if (cl_nobind) return;
+  if (nobind()) return;
   if (hwloc_topology_load(topo) == -1)
     throw std::logic_error("Hwloc failed to load");
       hwloc_obj_type_t root_type = cl_pack;
@@ -106,19 +110,23 @@ Cpubind::Cpubind(int n) {
 }
 
 void Cpubind::bind(int i) {
-  if (cl_nobind) return;
+  if (nobind()) return;
   if (hwloc_set_cpubind(topo, binds[i], HWLOC_CPUBIND_THREAD) == -1) {
     std::cerr << "Failed to cpubind: " << strerror(errno) << "\n";
   }
 }
 
 void Cpubind::bind(std::thread &thread, int i) {
-  if (cl_nobind) return;
+  if (nobind()) return;
   if (hwloc_set_thread_cpubind(topo, thread.native_handle(), binds[i], 0) == -1) {
     std::cerr << "Failed to cpubind: " << strerror(errno) << "\n";
   }
 }
 
+void Cpubind::disable() {
+  disabled = true;
+}
+
 Cpubind::~Cpubind() {
   for (hwloc_cpuset_t cpuset : binds)
     hwloc_bitmap_free(cpuset);
@@ -29,6 +29,7 @@ public:
   Cpubind(int n) {}
   void bind(int i) {}
   void bind(std::thread &thread, int i) {}
+  static void disable() {}
 };
 
 #else
@@ -42,6 +43,11 @@ public:
   ~Cpubind();
   void bind(int i);
   void bind(std::thread &thread, int i);
+  /* Make all Cpubinds created after the call leave threads unbound,
+   * as with --no-cpubind. For when several explorations run
+   * concurrently, and would otherwise bind to the same CPUs.
+   */
+  static void disable();
 private:
   /* Owning hwloc_topology_t */
   class Topology {
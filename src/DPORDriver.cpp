@@ -22,6 +22,8 @@
 #include "CheckModule.h"
 #include "Debug.h"
 #include "Interpreter.h"
+#include "Json.h"
+#include "ModuleCache.h"
 #include "POWERInterpreter.h"
 #include "POWERARMTraceBuilder.h"
 #include "PSOInterpreter.h"
@@ -29,17 +31,26 @@
 #include "StrModule.h"
 #include "TSOInterpreter.h"
 #include "TSOTraceBuilder.h"
+#include "Timing.h"
+#include "Transform.h"
 #include "RFSCTraceBuilder.h"
 #include "CCTraceBuilder.h"
 #include "RFSCUnfoldingTree.h"
 #include "Cpubind.h"
 
 #include <fstream>
+#include <sstream>
 #include <stdexcept>
 #include <iomanip>
 #include <cfloat>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
 #include <thread>
 
+#include <sys/resource.h>
+
 #if defined(HAVE_LLVM_IR_LLVMCONTEXT_H)
 #include <llvm/IR/LLVMContext.h>
 #elif defined(HAVE_LLVM_LLVMCONTEXT_H)
@@ -51,6 +62,8 @@
 #include <llvm/Support/MemoryBuffer.h>
 #include <llvm/Support/SourceMgr.h>
 
+static Timing::Context replay_context("replay");
+
 namespace {
   const char ESC_char = 27;
 
@@ -86,9 +99,14 @@ namespace {
 }
 
 DPORDriver::DPORDriver(const Configuration &C) :
-  conf(C) {
-  std::string ErrorMsg;
-  llvm::sys::DynamicLibrary::LoadLibraryPermanently(0,&ErrorMsg);
+  conf(C), sink(nullptr) {
+  /* Make the symbols of the process available to the interpreters,
+   * once for all drivers. */
+  static bool loaded = [](){
+    std::string ErrorMsg;
+    return !llvm::sys::DynamicLibrary::LoadLibraryPermanently(0,&ErrorMsg);
+  }();
+  (void)loaded;
 }
 
 DPORDriver *DPORDriver::parseIRFile(const std::string &filename,
@@ -107,6 +125,44 @@ DPORDriver *DPORDriver::parseIR(const std::string &llvm_asm,
   return driver;
 }
 
+DPORDriver *DPORDriver::fromModule(std::unique_ptr<llvm::Module> mod,
+                                   std::unique_ptr<llvm::LLVMContext> context,
+                                   const Configuration &C){
+  DPORDriver *driver =
+    new DPORDriver(C);
+  driver->module_context = std::move(context);
+  driver->module = std::move(mod);
+  return driver;
+}
+
+DPORDriver *DPORDriver::fromInput(const std::string &filename,
+                                  const Configuration &C){
+  if(!C.transform_first){
+    return parseIRFile(filename,C);
+  }
+  if(C.module_cache_dir == ""){
+    auto context = std::make_unique<llvm::LLVMContext>();
+    std::unique_ptr<llvm::Module> mod(StrModule::read_module(filename,*context));
+    Transform::transform(*mod,C);
+    return fromModule(std::move(mod),std::move(context),C);
+  }
+  /* Look the transformed module up by the contents of the input
+   * file, and transform and cache it on a miss. */
+  std::string input;
+  read_file(filename,input);
+  ModuleCache cache(C.module_cache_dir,C.module_cache_size);
+  std::string key = ModuleCache::key(input,C);
+  std::string bitcode;
+  if(!cache.lookup(key,bitcode)){
+    llvm::LLVMContext context;
+    std::unique_ptr<llvm::Module> mod(StrModule::read_module_src(input,context));
+    Transform::transform(*mod,C);
+    bitcode = StrModule::write_module_bitcode_str(mod.get());
+    cache.store(key,bitcode);
+  }
+  return parseIR(bitcode,C);
+}
+
 void DPORDriver::read_file(const std::string &filename, std::string &tgt){
   std::ifstream is(filename);
   if(!is){
@@ -122,8 +178,13 @@ void DPORDriver::read_file(const std::string &filename, std::string &tgt){
 std::unique_ptr<llvm::Module> DPORDriver::
 parse(ParseOptions opts, llvm::LLVMContext &context){
   std::unique_ptr<llvm::Module> mod(StrModule::read_module_src(src,context));
+  prepare(mod.get(), opts);
+  return mod;
+}
+
+void DPORDriver::prepare(llvm::Module *mod, ParseOptions opts){
   if (opts == PARSE_AND_CHECK) {
-    CheckModule::check_functions(mod.get());
+    CheckModule::check_functions(mod);
   }
   if(mod->LLVM_MODULE_GET_DATA_LAYOUT_STRING().empty()){
     if(llvm::sys::IsLittleEndianHost){
@@ -132,7 +193,12 @@ parse(ParseOptions opts, llvm::LLVMContext &context){
       mod->setDataLayout("E");
     }
   }
-  return mod;
+}
+
+void DPORDriver::share_src(llvm::Module *mod){
+  if(!StrModule::is_bitcode(src)){
+    src = StrModule::write_module_bitcode_str(mod);
+  }
 }
 
 std::unique_ptr<DPORInterpreter> DPORDriver::
@@ -191,6 +257,7 @@ create_execution_engine(TraceBuilder &TB, llvm::Module *mod,
 
 Trace *DPORDriver::run_once(TraceBuilder &TB, llvm::Module *mod,
                             bool &assume_blocked) const{
+  Timing::Guard timing_guard(replay_context);
   std::unique_ptr<DPORInterpreter> EE(create_execution_engine(TB,mod,conf));
 
   // Run main.
@@ -200,15 +267,17 @@ Trace *DPORDriver::run_once(TraceBuilder &TB, llvm::Module *mod,
   EE->runStaticConstructorsDestructors(true);
 
   if(conf.check_robustness){
-    static_cast<llvm::Interpreter*>(EE.get())->checkForCycles();
+    EE->checkForCycles();
   }
 
   assume_blocked = EE->assumeBlocked();
+  stats.event_count.fetch_add(EE->eventCount(), std::memory_order_relaxed);
 
   EE.reset();
 
   Trace *t = 0;
-  if(TB.has_error() || conf.debug_collect_all_traces){
+  if(TB.has_error() || conf.debug_collect_all_traces ||
+     (sink && sink->wants_traces())){
     if(TB.has_error() &&
        (conf.memory_model == Configuration::ARM ||
         conf.memory_model == Configuration::POWER)){
@@ -219,7 +288,7 @@ Trace *DPORDriver::run_once(TraceBuilder &TB, llvm::Module *mod,
       E->runFunctionAsMain(mod->getFunction("main"), conf.argv, 0);
       E->runStaticConstructorsDestructors(true);
       if(conf.check_robustness){
-        static_cast<llvm::Interpreter*>(E.get())->checkForCycles();
+        E->checkForCycles();
       }
       t = TB.get_trace();
     }else{
@@ -232,24 +301,30 @@ Trace *DPORDriver::run_once(TraceBuilder &TB, llvm::Module *mod,
 
 void DPORDriver::print_progress(uint64_t computation_count, long double estimate, Result &res, int tasks_left) {
   if(computation_count % 100 == 0){
-    llvm::dbgs() << ESC_char << "[K" // Erase the line
-                 << "Traces: " << res.trace_count;
-    if(res.sleepset_blocked_trace_count)
-      llvm::dbgs() << ", " << res.sleepset_blocked_trace_count << " ssb";
-    if(res.assume_blocked_trace_count)
-      llvm::dbgs() << ", " << res.assume_blocked_trace_count << " ab";
-    if(tasks_left != -1)
-      llvm::dbgs() << " (" << tasks_left << " jobs)";
-    if(conf.print_progress_estimate){
-      std::stringstream ss;
-      ss << std::setprecision(LDBL_DIG) << estimate;
-      llvm::dbgs() << " ("
-                   << int(100.0*(long double)(computation_count+1)/estimate)
-                   << "% of total estimate: "
-                   << ss.str() << ")";
-    }
-    llvm::dbgs() << "\r"; // Move cursor to start of line
+    print_progress_line(computation_count, estimate, res, tasks_left);
+  }
+}
+
+void DPORDriver::print_progress_line(uint64_t computation_count,
+                                     long double estimate,
+                                     const Result &res, int tasks_left) {
+  llvm::dbgs() << ESC_char << "[K" // Erase the line
+               << "Traces: " << res.trace_count;
+  if(res.sleepset_blocked_trace_count)
+    llvm::dbgs() << ", " << res.sleepset_blocked_trace_count << " ssb";
+  if(res.assume_blocked_trace_count)
+    llvm::dbgs() << ", " << res.assume_blocked_trace_count << " ab";
+  if(tasks_left != -1)
+    llvm::dbgs() << " (" << tasks_left << " jobs)";
+  if(conf.print_progress_estimate){
+    std::stringstream ss;
+    ss << std::setprecision(LDBL_DIG) << estimate;
+    llvm::dbgs() << " ("
+                 << int(100.0*(long double)(computation_count+1)/estimate)
+                 << "% of total estimate: "
+                 << ss.str() << ")";
   }
+  llvm::dbgs() << "\r"; // Move cursor to start of line
 }
 
 bool DPORDriver::handle_trace(TraceBuilder *TB, Trace *t, uint64_t *computation_count, Result &res, bool assume_blocked) {
@@ -258,13 +333,18 @@ bool DPORDriver::handle_trace(TraceBuilder *TB, Trace *t, uint64_t *computation_
     res.all_traces.push_back(t);
     t_used = true;
   }
+  TraceSink::Kind kind;
   if(!TB->sleepset_is_empty()) {
     ++res.sleepset_blocked_trace_count;
+    kind = TraceSink::SLEEPSET_BLOCKED;
   }else if(assume_blocked){
     ++res.assume_blocked_trace_count;
+    kind = TraceSink::ASSUME_BLOCKED;
   }else{
     ++res.trace_count;
+    kind = TraceSink::COMPLETE;
   }
+  bool stop = sink && !sink->consume(*computation_count, kind, t);
   ++*computation_count;
   if(t && t->has_errors() && !res.has_errors()){
     res.error_trace = t;
@@ -275,7 +355,102 @@ bool DPORDriver::handle_trace(TraceBuilder *TB, Trace *t, uint64_t *computation_
     delete t;
   }
 
-  return has_errors && !conf.explore_all_traces;
+  if(conf.stats_json != "" && 0 < conf.stats_json_interval &&
+     std::chrono::steady_clock::now() - stats.last_write
+     >= std::chrono::seconds(conf.stats_json_interval)){
+    write_stats(res, false);
+  }
+
+  return stop || (has_errors && !conf.explore_all_traces);
+}
+
+void DPORDriver::note_queue_depth(uint64_t depth){
+  stats.queue_depth = depth;
+  stats.peak_queue_depth = std::max(stats.peak_queue_depth, depth);
+}
+
+namespace {
+  /* The peak resident set size of this process in kilobytes. */
+  long peak_rss_kb(){
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage)) return -1;
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024; // Bytes on macOS
+#else
+    return usage.ru_maxrss;
+#endif
+  }
+}
+
+void DPORDriver::write_stats(const Result &res, bool final){
+  using namespace std::chrono;
+  steady_clock::time_point now = steady_clock::now();
+  stats.last_write = now;
+  double elapsed = duration_cast<duration<double>>(now - stats.start).count();
+  uint64_t events = stats.event_count.load(std::memory_order_relaxed);
+
+  std::stringstream ss;
+  ss << std::setprecision(6) << std::fixed;
+  ss << "{\n"
+     << "  \"final\": " << (final ? "true" : "false") << ",\n"
+     << "  \"elapsed_seconds\": " << elapsed << ",\n"
+     << "  \"traces\": {\"count\": " << res.trace_count
+     << ", \"sleepset_blocked\": " << res.sleepset_blocked_trace_count
+     << ", \"assume_blocked\": " << res.assume_blocked_trace_count << "},\n"
+     << "  \"events\": {\"count\": " << events
+     << ", \"per_second\": " << (0 < elapsed ? events / elapsed : 0.0) << "},\n"
+     << "  \"queue_depth\": {\"current\": " << stats.queue_depth
+     << ", \"peak\": " << stats.peak_queue_depth << "},\n"
+     << "  \"sat\": {\"solver_calls\": " << res.sat_solver_calls
+     << ", \"sat\": " << res.sat_solver_sat
+     << ", \"unsat\": " << res.sat_solver_unsat
+     << ", \"interrupted\": " << res.sat_solver_interrupted
+     << ", \"cache_hits\": " << res.sat_cache_hits
+     << ", \"cache_misses\": " << res.sat_cache_misses
+     << ", \"portfolio\": {\"saturation\": " << res.portfolio_saturation_count
+     << ", \"heuristic\": " << res.portfolio_heuristic_count
+     << ", \"solver\": " << res.portfolio_solver_count << "}},\n"
+     << "  \"peak_rss_kb\": " << peak_rss_kb() << ",\n"
+     << "  \"timing\": [";
+  bool first = true;
+  for(const Timing::Sample &s : Timing::sample()){
+    ss << (first ? "\n" : ",\n")
+       << "    {\"context\": " << Json::quote(s.name)
+       << ", \"thread\": " << s.thread
+       << ", \"count\": " << s.count
+       << ", \"inclusive_seconds\": " << s.inclusive
+       << ", \"exclusive_seconds\": " << s.exclusive;
+    if(Timing::perf_enabled()){
+      const char *names[Timing::PERF_COUNTER_COUNT] =
+        {"cycles", "instructions", "llc_misses", "branch_misses"};
+      ss << ", \"perf_exclusive\": {";
+      for(int i = 0; i < Timing::PERF_COUNTER_COUNT; ++i){
+        ss << (i ? ", " : "") << "\"" << names[i] << "\": " << s.perf_exclusive[i];
+      }
+      ss << "}";
+    }
+    ss << "}";
+    first = false;
+  }
+  ss << (first ? "]\n" : "\n  ]\n") << "}\n";
+
+  /* Write to a temporary file and rename it, so that readers never
+   * see a partially written document.
+   */
+  std::string tmp = conf.stats_json + ".tmp";
+  {
+    std::ofstream out(tmp);
+    out << ss.str();
+    if(!out){
+      Debug::warn("DPORDriver::write_stats")
+        << "WARNING: Failed to write statistics to " << tmp << ".\n";
+      return;
+    }
+  }
+  if(std::rename(tmp.c_str(), conf.stats_json.c_str())){
+    Debug::warn("DPORDriver::write_stats:rename")
+      << "WARNING: Failed to write statistics to " << conf.stats_json << ".\n";
+  }
 }
 
 
@@ -290,14 +465,34 @@ namespace{
       abort();
     }
   }
+
+  void add_portfolio_stats(DPORDriver::Result &res, const RFSCTraceBuilder &TB) {
+    res.portfolio_saturation_count += TB.portfolio_stats.saturation;
+    res.portfolio_heuristic_count += TB.portfolio_stats.heuristic;
+    res.portfolio_solver_count += TB.portfolio_stats.solver;
+  }
+
+  void add_solver_stats(DPORDriver::Result &res, const RFSCTraceBuilder &TB) {
+    res.sat_solver_calls += TB.solver_stats.calls;
+    res.sat_solver_sat += TB.solver_stats.sat;
+    res.sat_solver_unsat += TB.solver_stats.unsat;
+    res.sat_solver_interrupted += TB.solver_stats.interrupted;
+  }
+
+  void add_sat_cache_stats(DPORDriver::Result &res, const RFSCSatCache &cache) {
+    res.sat_cache_hits += cache.hits;
+    res.sat_cache_misses += cache.misses;
+  }
 }
 
-DPORDriver::Result DPORDriver::run_rfsc_sequential() {
+DPORDriver::Result DPORDriver::
+run_rfsc_sequential(llvm::Module *mod) {
   Result res;
-  std::unique_ptr<llvm::Module> mod = parse(PARSE_AND_CHECK);
   RFSCDecisionTree decision_tree(make_scheduler(conf));
   RFSCUnfoldingTree unfolding_tree;
-  RFSCTraceBuilder TB(decision_tree, unfolding_tree, conf);
+  RFSCSatCache sat_cache(conf.sat_cache_size);
+  RFSCTraceBuilder TB(decision_tree, unfolding_tree, sat_cache, conf);
+  RFSCTraceEstimator estimator;
 
   uint64_t computation_count = 0;
   long double estimate = 1;
@@ -310,27 +505,30 @@ DPORDriver::Result DPORDriver::run_rfsc_sequential() {
 
     bool assume_blocked = false;
     TB.reset();
-    Trace *t= this->run_once(TB, mod.get(), assume_blocked);
+    Trace *t= this->run_once(TB, mod, assume_blocked);
     tasks_left--;
 
     int to_create = TB.tasks_created;
 
 
     tasks_left += to_create;
+    note_queue_depth(tasks_left);
+    if(conf.print_progress_estimate){
+      estimator.add_sample(TB.branching_factors());
+    }
 
     if (handle_trace(&TB, t, &computation_count, res, assume_blocked)) {
       break;
     }
     if(conf.print_progress_estimate && (computation_count+1) % 100 == 0){
-      estimate = std::round(TB.estimate_trace_count());
-    }
-    if((computation_count+1) % 1000 == 0){
-      /* llvm::ExecutionEngine leaks global variables until the Module is
-       * destructed */
-      mod = parse();
+      estimate = std::round
+        (estimator.estimate(computation_count,
+                            decision_tree.queued_depth_profile()));
     }
-
   } while(tasks_left);
+  add_portfolio_stats(res, TB);
+  add_solver_stats(res, TB);
+  add_sat_cache_stats(res, sat_cache);
 
   if(conf.print_progress){
     llvm::dbgs() << ESC_char << "[K\n";
@@ -339,60 +537,218 @@ DPORDriver::Result DPORDriver::run_rfsc_sequential() {
   return res;
 }
 
-DPORDriver::Result DPORDriver::run_rfsc_parallel() {
+DPORDriver::Result DPORDriver::
+run_rfsc_parallel(llvm::Module *main_mod) {
   Result res;
+  share_src(main_mod);
   unsigned n_threads = conf.n_threads-1;
   std::vector<std::thread> threads;
   threads.reserve(n_threads);
   Cpubind cpubind(conf.n_threads);
 
   struct state {
-    state(const Configuration &conf) : decision_tree(make_scheduler(conf)) {}
+    state(const Configuration &conf)
+      : decision_tree(make_scheduler(conf)), sat_cache(conf.sat_cache_size) {}
     RFSCDecisionTree decision_tree;
     RFSCUnfoldingTree unfolding_tree;
+    RFSCSatCache sat_cache;
+    RFSCTraceEstimator estimator;
     uint64_t computation_count = 0;
     std::mutex mutex;
   } state(conf);
 
-  auto thread = [this, &res, &state] (unsigned id) {
-    auto context = std::make_unique<llvm::LLVMContext>();
-    std::unique_ptr<llvm::Module> mod = parse(id ? PARSE_ONLY : PARSE_AND_CHECK,
-                                              *context);
+  auto thread = [this, &res, &state] (llvm::Module *main_mod, unsigned id) {
+    /* An llvm::Module cannot be used concurrently, so every worker
+     * but the first decodes its own copy from the shared bitcode. */
+    std::unique_ptr<llvm::LLVMContext> context;
+    std::unique_ptr<llvm::Module> own_mod;
+    llvm::Module *mod = main_mod;
+    if(!mod){
+      context = std::make_unique<llvm::LLVMContext>();
+      own_mod = parse(PARSE_ONLY, *context);
+      mod = own_mod.get();
+    }
     RFSCScheduler &sched = state.decision_tree.get_scheduler();
     sched.register_thread(id);
-    RFSCTraceBuilder TB(state.decision_tree, state.unfolding_tree, conf);
-    unsigned int my_computation_count = 0;
+    RFSCTraceBuilder TB(state.decision_tree, state.unfolding_tree,
+                        state.sat_cache, conf);
     while (TB.reset()) {
       bool assume_blocked = false;
-      Trace *t = this->run_once(TB, mod.get(), assume_blocked);
+      Trace *t = this->run_once(TB, mod, assume_blocked);
+      if(conf.print_progress_estimate){
+        state.estimator.add_sample(TB.branching_factors());
+      }
       TB.work_item.reset();
 
       std::lock_guard<std::mutex> lock(state.mutex);
       uint64_t remain =
         sched.outstanding_jobs.fetch_sub(1, std::memory_order_relaxed)
         - 1;
+      note_queue_depth(remain);
       if (handle_trace(&TB, t, &state.computation_count, res, assume_blocked)
           || remain == 0) {
         sched.halt();
       }
-      if(conf.print_progress){
-        const long double estimate = 1;
-        print_progress(state.computation_count, estimate, res, remain);
+    }
+    std::lock_guard<std::mutex> lock(state.mutex);
+    add_portfolio_stats(res, TB);
+    add_solver_stats(res, TB);
+  };
+
+  /* Progress is printed periodically by a separate thread, so that
+   * the workers never wait for the output. */
+  std::thread reporter;
+  std::mutex reporter_mutex;
+  std::condition_variable reporter_cv;
+  bool reporter_stop = false;
+  if(conf.print_progress){
+    reporter = std::thread([&] () {
+      std::unique_lock<std::mutex> reporter_lock(reporter_mutex);
+      while (!reporter_cv.wait_for(reporter_lock,
+                                   std::chrono::milliseconds(200),
+                                   [&] { return reporter_stop; })) {
+        Result snapshot;
+        uint64_t computation_count;
+        {
+          std::lock_guard<std::mutex> lock(state.mutex);
+          snapshot.trace_count = res.trace_count;
+          snapshot.sleepset_blocked_trace_count
+            = res.sleepset_blocked_trace_count;
+          snapshot.assume_blocked_trace_count
+            = res.assume_blocked_trace_count;
+          computation_count = state.computation_count;
+        }
+        uint64_t remain = state.decision_tree.get_scheduler()
+          .outstanding_jobs.load(std::memory_order_relaxed);
+        long double estimate = 1;
+        if(conf.print_progress_estimate){
+          estimate = std::round
+            (state.estimator.estimate
+             (computation_count, state.decision_tree.queued_depth_profile()));
+        }
+        print_progress_line(computation_count, estimate, snapshot, remain);
       }
-      if (++my_computation_count % 1024 == 0) {
-        /* llvm::ExecutionEngine leaks global variables until the Module is
-         * destructed */
-        mod = parse(PARSE_ONLY, *context);
+    });
+  }
+
+  for (unsigned i = 0; i < n_threads; ++i) {
+    threads.emplace_back(thread, nullptr, i+1);
+    cpubind.bind(threads.back(), i+1);
+  }
+  cpubind.bind(0);
+  thread(main_mod, 0);
+  for (unsigned i = 0; i < n_threads; ++i) {
+    threads[i].join();
+  }
+  add_sat_cache_stats(res, state.sat_cache);
+
+  if(conf.print_progress){
+    {
+      std::lock_guard<std::mutex> lock(reporter_mutex);
+      reporter_stop = true;
+    }
+    reporter_cv.notify_one();
+    reporter.join();
+    llvm::dbgs() << ESC_char << "[K\n";
+  }
+
+  return res;
+}
+
+DPORDriver::Result DPORDriver::
+run_powerarm_parallel(std::unique_ptr<POWERARMTraceBuilder> TB,
+                      llvm::Module *main_mod) {
+  Result res;
+  share_src(main_mod);
+  unsigned n_threads = conf.n_threads-1;
+  std::vector<std::thread> threads;
+  threads.reserve(n_threads);
+  Cpubind cpubind(conf.n_threads);
+
+  struct state {
+    /* Trace builders that have been split off, but not yet picked up
+     * by any thread. */
+    std::deque<std::unique_ptr<POWERARMTraceBuilder>> queue;
+    /* The number of threads waiting for a trace builder. */
+    int idle = 0;
+    bool halted = false;
+    uint64_t computation_count = 0;
+    std::mutex mutex;
+    std::condition_variable cv;
+  } state;
+
+  auto thread = [this, &res, &state]
+    (std::unique_ptr<POWERARMTraceBuilder> TB,
+     llvm::Module *main_mod) {
+    /* As in run_rfsc_parallel, every worker but the first decodes its
+     * own copy of the module. */
+    std::unique_ptr<llvm::LLVMContext> context;
+    std::unique_ptr<llvm::Module> own_mod;
+    llvm::Module *mod = main_mod;
+    if(!mod){
+      context = std::make_unique<llvm::LLVMContext>();
+      own_mod = parse(PARSE_ONLY, *context);
+      mod = own_mod.get();
+    }
+    while (true) {
+      if (!TB) {
+        std::unique_lock<std::mutex> lock(state.mutex);
+        if (++state.idle == conf.n_threads && state.queue.empty()) {
+          /* No thread has anything left to explore */
+          state.halted = true;
+          state.cv.notify_all();
+        }
+        state.cv.wait(lock, [&state] {
+          return state.halted || !state.queue.empty();
+        });
+        --state.idle;
+        if (state.halted) return;
+        TB = std::move(state.queue.front());
+        state.queue.pop_front();
+        note_queue_depth(state.queue.size());
+      }
+
+      bool assume_blocked = false;
+      Trace *t = this->run_once(*TB, mod, assume_blocked);
+
+      bool split_work;
+      {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (handle_trace(TB.get(), t, &state.computation_count, res,
+                         assume_blocked)) {
+          state.halted = true;
+          state.cv.notify_all();
+        }
+        if (state.halted) return;
+        if (conf.print_progress) {
+          print_progress(state.computation_count,
+                         TB->estimate_trace_count(), res,
+                         state.queue.size());
+        }
+        split_work = state.idle > int(state.queue.size());
+      }
+
+      if (!TB->reset()) {
+        TB = nullptr;
+      } else if (split_work) {
+        std::unique_ptr<POWERARMTraceBuilder> other = TB->split();
+        if (other) {
+          std::lock_guard<std::mutex> lock(state.mutex);
+          state.queue.push_back(std::move(other));
+          note_queue_depth(state.queue.size());
+          state.cv.notify_one();
+        }
       }
     }
   };
 
   for (unsigned i = 0; i < n_threads; ++i) {
-    threads.emplace_back(thread, i+1);
+    threads.emplace_back(thread, std::unique_ptr<POWERARMTraceBuilder>(),
+                         nullptr);
     cpubind.bind(threads.back(), i+1);
   }
   cpubind.bind(0);
-  thread(0);
+  thread(std::move(TB), main_mod);
   for (unsigned i = 0; i < n_threads; ++i) {
     threads[i].join();
   }
@@ -405,9 +761,9 @@ DPORDriver::Result DPORDriver::run_rfsc_parallel() {
 }
 
 template<class CausalTraceBuilder>
-DPORDriver::Result DPORDriver::run_causal_sequential() {
+DPORDriver::Result DPORDriver::
+run_causal_sequential(llvm::Module *mod) {
   Result res;
-  std::unique_ptr<llvm::Module> mod = parse(PARSE_AND_CHECK);
   RFSCDecisionTree decision_tree(make_scheduler(conf));
   RFSCUnfoldingTree unfolding_tree;
   CausalTraceBuilder TB(decision_tree, unfolding_tree, conf);
@@ -423,13 +779,14 @@ DPORDriver::Result DPORDriver::run_causal_sequential() {
 
     bool assume_blocked = false;
     TB.reset();
-    Trace *t= this->run_once(TB, mod.get(), assume_blocked);
+    Trace *t= this->run_once(TB, mod, assume_blocked);
     tasks_left--;
 
     int to_create = TB.tasks_created;
 
 
     tasks_left += to_create;
+    note_queue_depth(tasks_left);
 
     if (handle_trace(&TB, t, &computation_count, res, assume_blocked)) {
       break;
@@ -437,12 +794,6 @@ DPORDriver::Result DPORDriver::run_causal_sequential() {
     if(conf.print_progress_estimate && (computation_count+1) % 100 == 0){
       estimate = std::round(TB.estimate_trace_count());
     }
-    if((computation_count+1) % 1000 == 0){
-      /* llvm::ExecutionEngine leaks global variables until the Module is
-       * destructed */
-      mod = parse();
-    }
-
   } while(tasks_left);
 
   if(conf.print_progress){
@@ -452,9 +803,30 @@ DPORDriver::Result DPORDriver::run_causal_sequential() {
   return res;
 }
 
-DPORDriver::Result DPORDriver::run(){
+DPORDriver::Result DPORDriver::run(TraceSink *sink){
+  this->sink = sink;
+  stats.start = stats.last_write = std::chrono::steady_clock::now();
+  Result res = explore();
+  this->sink = nullptr;
+  if(conf.stats_json != ""){
+    write_stats(res, true);
+  }
+  return res;
+}
+
+DPORDriver::Result DPORDriver::explore(){
   Result res;
-  std::unique_ptr<llvm::Module> mod = parse(PARSE_AND_CHECK);
+  /* Not GlobalContext, so that several drivers may explore
+   * concurrently (see Batch). */
+  llvm::LLVMContext context;
+  std::unique_ptr<llvm::Module> parsed;
+  llvm::Module *mod = module.get();
+  if(mod){
+    prepare(mod, PARSE_AND_CHECK);
+  }else{
+    parsed = parse(PARSE_AND_CHECK, context);
+    mod = parsed.get();
+  }
 
   TraceBuilder *TB = nullptr;
 
@@ -464,9 +836,9 @@ DPORDriver::Result DPORDriver::run(){
       TB = new TSOTraceBuilder(conf);
     }else{
       if (conf.n_threads == 1){
-        res = run_rfsc_sequential();
+        res = run_rfsc_sequential(mod);
       } else {
-        res = run_rfsc_parallel();
+        res = run_rfsc_parallel(mod);
       }
       return res;
     }
@@ -478,14 +850,24 @@ DPORDriver::Result DPORDriver::run(){
     TB = new PSOTraceBuilder(conf);
     break;
   case Configuration::ARM:
+    if(conf.n_threads > 1){
+      return run_powerarm_parallel
+        (std::unique_ptr<POWERARMTraceBuilder>(new ARMTraceBuilder(conf)),
+         mod);
+    }
     TB = new ARMTraceBuilder(conf);
     break;
   case Configuration::CCV:
   case Configuration::CM:
   case Configuration::CC:
-    return run_causal_sequential<CCTraceBuilder>();
+    return run_causal_sequential<CCTraceBuilder>(mod);
     break;
   case Configuration::POWER:
+    if(conf.n_threads > 1){
+      return run_powerarm_parallel
+        (std::unique_ptr<POWERARMTraceBuilder>(new POWERTraceBuilder(conf)),
+         mod);
+    }
     TB = new POWERTraceBuilder(conf);
     break;
   case Configuration::MM_UNDEF:
@@ -501,14 +883,9 @@ DPORDriver::Result DPORDriver::run(){
     if(conf.print_progress){
       print_progress(computation_count, estimate, res);
     }
-    if((computation_count+1) % 1000 == 0){
-      /* llvm::ExecutionEngine leaks global variables until the Module is
-       * destructed */
-      mod = parse();
-    }
 
     bool assume_blocked = false;
-    Trace *t = run_once(*TB, mod.get(), assume_blocked);
+    Trace *t = run_once(*TB, mod, assume_blocked);
 
     if (handle_trace(TB, t, &computation_count, res, assume_blocked)) break;
     if(conf.print_progress_estimate && (computation_count+1) % 100 == 0){
@@ -34,12 +34,17 @@
 #include <llvm/Module.h>
 #endif
 
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <string>
 
 namespace llvm{
   class ExecutionEngine;
 }
 
+class POWERARMTraceBuilder;
+
 /* The DPORDriver is the main driver of the trace exploration. It
  * takes an LLVM Module, and repeatedly explores its different traces.
  */
@@ -51,10 +56,26 @@ public:
   static DPORDriver *parseIRFile(const std::string &filename,
                                  const Configuration &conf);
   /* Create and return a new DPORDriver with a module as defined by
-   * the LLVM assembly given in llvm_asm.
+   * the LLVM assembly or bitcode given in llvm_asm.
    */
   static DPORDriver *parseIR(const std::string &llvm_asm,
                              const Configuration &conf);
+  /* Create and return a new DPORDriver with the module mod, which
+   * belongs to context. The driver takes ownership of both, and
+   * explores mod itself. mod is serialised only if worker threads
+   * need their own copies (conf.n_threads > 1).
+   */
+  static DPORDriver *fromModule(std::unique_ptr<llvm::Module> mod,
+                                std::unique_ptr<llvm::LLVMContext> context,
+                                const Configuration &conf);
+  /* Create and return a new DPORDriver with a module as defined in
+   * the LLVM assembly or bitcode file filename. If
+   * conf.transform_first is set, the module is first transformed
+   * according to conf, or fetched from conf.module_cache_dir if it
+   * has been transformed before.
+   */
+  static DPORDriver *fromInput(const std::string &filename,
+                               const Configuration &conf);
   virtual ~DPORDriver() {}
   DPORDriver(const DPORDriver&) = delete;
   DPORDriver &operator=(const DPORDriver&) = delete;
@@ -110,29 +131,115 @@ public:
   public:
     /* Empty result */
     Result() : trace_count(0), sleepset_blocked_trace_count(0),
-               assume_blocked_trace_count(0) {};
+               assume_blocked_trace_count(0), portfolio_saturation_count(0),
+               portfolio_heuristic_count(0), portfolio_solver_count(0),
+               sat_cache_hits(0), sat_cache_misses(0), sat_solver_calls(0),
+               sat_solver_sat(0), sat_solver_unsat(0),
+               sat_solver_interrupted(0) {};
     /* The number of explored (non-sleepset-blocked) traces */
     uint64_t trace_count;
     /* The number of explored sleepset-blocked traces */
     uint64_t sleepset_blocked_trace_count;
     /* The number of explored assume-blocked traces */
     uint64_t assume_blocked_trace_count;
+    /* With --sat-portfolio, the number of candidate siblings that
+     * were decided by saturation, by the prefix heuristic and by the
+     * SAT solver, respectively. */
+    uint64_t portfolio_saturation_count;
+    uint64_t portfolio_heuristic_count;
+    uint64_t portfolio_solver_count;
+    /* The number of lookups in the RFSC satisfiability cache that
+     * succeeded and failed, respectively. */
+    uint64_t sat_cache_hits;
+    uint64_t sat_cache_misses;
+    /* The number of calls to the SAT solver in RFSC, and of those the
+     * number that answered satisfiable, answered unsatisfiable, and
+     * were overtaken by the prefix heuristic (with --sat-portfolio),
+     * respectively. */
+    uint64_t sat_solver_calls;
+    uint64_t sat_solver_sat;
+    uint64_t sat_solver_unsat;
+    uint64_t sat_solver_interrupted;
 
     bool has_errors() const { return error_trace && error_trace->has_errors(); };
   };
 
+  /* A TraceSink receives every execution as soon as it has been
+   * explored, so that the traces of a module can be processed without
+   * keeping them in memory (as conf.debug_collect_all_traces does).
+   */
+  class TraceSink{
+  public:
+    virtual ~TraceSink() {}
+    enum Kind {
+      /* A complete execution. Counted in Result::trace_count. */
+      COMPLETE,
+      /* Counted in Result::sleepset_blocked_trace_count. */
+      SLEEPSET_BLOCKED,
+      /* Counted in Result::assume_blocked_trace_count. */
+      ASSUME_BLOCKED
+    };
+    /* Should consume be given the Trace of every execution? Building
+     * a Trace costs time, so by default it is only built for
+     * executions that contain errors.
+     */
+    virtual bool wants_traces() const { return false; }
+    /* Called once for every execution. index counts the executions
+     * from 0, in the order they are explored. trace is the Trace of
+     * the execution, or null if it was not built (see
+     * wants_traces). It is owned by the driver and valid only during
+     * the call.
+     *
+     * Calls are never concurrent, but with conf.n_threads > 1 they
+     * may come from different threads.
+     *
+     * Return false to end the exploration early, as when an error
+     * has been found and conf.explore_all_traces is not set.
+     */
+    virtual bool consume(uint64_t index, Kind kind, const Trace *trace) = 0;
+  };
+
   /* Explore the traces of the given module, and return the result.
+   *
+   * If sink is non-null, every explored execution is passed to it.
+   *
+   * If conf.stats_json is set, the statistics of the exploration are
+   * written to that file before returning.
    */
-  Result run();
+  Result run(TraceSink *sink = nullptr);
 private:
   /* Configuration */
   const Configuration &conf;
+  /* The sink given to run, or null. */
+  TraceSink *sink;
   /* The source code of the module to explore. Expressed as LLVM
-   * assembly or as LLVM bitcode.
+   * assembly or as LLVM bitcode. Empty for a driver created by
+   * fromModule, until worker threads need it (see share_src).
    */
   std::string src;
+  /* For a driver created by fromModule: The module to explore, and
+   * its context. Otherwise null.
+   */
+  std::unique_ptr<llvm::LLVMContext> module_context;
+  std::unique_ptr<llvm::Module> module;
+
+  /* Statistics for conf.stats_json, beyond those in Result. */
+  struct Stats {
+    Stats() : event_count(0), queue_depth(0), peak_queue_depth(0) {};
+    /* The total number of events in all executions so far. */
+    std::atomic<uint64_t> event_count;
+    /* The current and the largest number of pending exploration
+     * tasks, for the exploration modes that keep a queue of tasks.
+     */
+    uint64_t queue_depth;
+    uint64_t peak_queue_depth;
+    std::chrono::steady_clock::time_point start, last_write;
+  };
+  mutable Stats stats;
 
   DPORDriver(const Configuration &conf);
+  /* Explores the traces of the module according to conf. See run(). */
+  Result explore();
   Trace *run_once(TraceBuilder &TB, llvm::Module *mod, bool &assume_blocked) const;
   /* Parse the module in a given LLVMContext,
    * optionally checking validity (should be done the first time) */
@@ -140,6 +247,16 @@ private:
   std::unique_ptr<llvm::Module> parse
   (ParseOptions opts = PARSE_ONLY,
    llvm::LLVMContext &context = GlobalContext::get());
+  /* Checks the validity of mod if opts == PARSE_AND_CHECK, and gives
+   * it a default data layout if it has none. Done by parse. */
+  static void prepare(llvm::Module *mod, ParseOptions opts);
+  /* Replaces src by the bitcode of mod, unless src is bitcode
+   * already. To be called before worker threads parse their own
+   * copies of src, since bitcode is much faster to parse than
+   * assembly, and since src is empty with fromModule. mod must be
+   * the module of this driver, before any execution.
+   */
+  void share_src(llvm::Module *mod);
   /* Opens and reads the file filename. Stores the entire content in
    * tgt. Throws an exception on failure.
    */
@@ -154,24 +271,50 @@ private:
 
   /* Prints the progress of exploration if argument --print-progress was given. */
   void print_progress(uint64_t computation_count, long double estimate, Result &res, int tasks_left = -1);
+  /* Prints the progress of exploration, regardless of computation_count. */
+  void print_progress_line(uint64_t computation_count, long double estimate,
+                           const Result &res, int tasks_left = -1);
+  /* Records that there are depth pending exploration tasks. Should be
+   * called under the same lock as handle_trace.
+   */
+  void note_queue_depth(uint64_t depth);
+  /* Writes the statistics of the exploration so far to
+   * conf.stats_json. final tells whether the exploration is done.
+   */
+  void write_stats(const Result &res, bool final);
   /* Updates the result based on the given tracecount and TraceBuilder. */
   bool handle_trace(TraceBuilder *TB, Trace *t, uint64_t *computation_count, Result &res, bool assume_blocked);
 
   /* Separate run-function for RFSC since it breaks the default
    * algorithm in DPORDriver::run(). This will spawn a threadpool
    * where eash thread will explore the execution tree concurrently.
+   *
+   * The calling thread explores mod, which must be checked already.
+   * The other threads parse their own copies of src.
    */
-  Result run_rfsc_parallel();
+  Result run_rfsc_parallel(llvm::Module *mod);
   /* As rfsc explores asyncronosly with a threadpool,
    * an alternate function is given without overhead
    * if it should be run strictly sequential.
    */
-  Result run_rfsc_sequential();
+  Result run_rfsc_sequential(llvm::Module *mod);
+  /* Explores the traces under POWER or ARM concurrently with
+   * conf.n_threads threads, starting from the trace builder TB. Each
+   * thread explores with its own trace builder and POWERInterpreter.
+   * Whenever some thread is out of work, another thread splits off a
+   * part of its remaining exploration for it (see
+   * POWERARMTraceBuilder::split).
+   *
+   * The calling thread explores mod, which must be checked already.
+   * The other threads parse their own copies of src.
+   */
+  Result run_powerarm_parallel(std::unique_ptr<POWERARMTraceBuilder> TB,
+                               llvm::Module *mod);
   /* Template function for running any TraceBuilder 
    * written per operational semantics, such as CCTraceBuilder
    */
   template<class CausalTraceBuilder>
-  Result run_causal_sequential();
+  Result run_causal_sequential(llvm::Module *mod);
 };
 
 #endif
@@ -21,6 +21,7 @@
 #ifdef HAVE_BOOST_UNIT_TEST_FRAMEWORK
 
 #include "DPORDriver_test.h"
+#include "StrModule.h"
 #include "VClock.h"
 
 #include <sstream>
@@ -291,6 +292,30 @@ namespace DPORDriver_test {
 
     return retval;
   }
+
+  void check_parallel_equiv(const std::string &module,
+                            const Configuration &C,
+                            uint64_t traces, int n_threads){
+    Configuration conf = C;
+    std::string src = StrModule::portasm(module);
+    conf.n_threads = 1;
+    DPORDriver *driver = DPORDriver::parseIR(src,conf);
+    DPORDriver::Result seq = driver->run();
+    delete driver;
+
+    conf.n_threads = n_threads;
+    driver = DPORDriver::parseIR(src,conf);
+    DPORDriver::Result par = driver->run();
+    delete driver;
+
+    BOOST_CHECK_EQUAL(seq.trace_count, traces);
+    BOOST_CHECK_EQUAL(par.trace_count, seq.trace_count);
+    BOOST_CHECK_EQUAL(par.sleepset_blocked_trace_count,
+                      seq.sleepset_blocked_trace_count);
+    BOOST_CHECK_EQUAL(par.assume_blocked_trace_count,
+                      seq.assume_blocked_trace_count);
+    BOOST_CHECK_EQUAL(par.has_errors(), seq.has_errors());
+  }
 }
 
 #endif
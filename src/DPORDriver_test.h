@@ -103,6 +103,17 @@ namespace DPORDriver_test {
                            const DPORDriver::Result &optimal_res,
                            const Configuration &conf);
 
+  /* Explores the LLVM assembly module (after StrModule::portasm)
+   * under conf, once with conf.n_threads set to 1 and once with it set
+   * to n_threads. Checks, using BOOST_CHECK, that the sequential
+   * exploration finds traces complete traces, and that both
+   * explorations agree on the numbers of complete, sleepset-blocked
+   * and assume-blocked traces, and on whether errors were found.
+   */
+  void check_parallel_equiv(const std::string &module,
+                            const Configuration &conf,
+                            uint64_t traces, int n_threads);
+
 }
 
 #endif
@@ -23,14 +23,47 @@
 #define __DPOR_INTERPRETER_H__
 
 #include <llvm/ExecutionEngine/ExecutionEngine.h>
+#if defined(HAVE_LLVM_IR_DATALAYOUT_H)
+#include <llvm/IR/DataLayout.h>
+#elif defined(HAVE_LLVM_DATALAYOUT_H)
+#include <llvm/DataLayout.h>
+#endif
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
 
 /* Common base class for all Interpreter instances used in nidhugg */
 class DPORInterpreter : public llvm::ExecutionEngine {
   /* True if we have executed a false assume statement.
    */
   bool AssumeBlocked;
+  /* The number of events scheduled by the TraceBuilder so far. */
+  uint64_t EventCount;
+  /* The memory of the global variables, allocated by getMemoryForGV. */
+  std::vector<void*> GlobalMemory;
 protected:
   void setAssumeBlocked(bool value) { AssumeBlocked = value; }
+  void countEvent() { ++EventCount; }
+  /* llvm::ExecutionEngine allocates the global variables in memory
+   * that is owned by the Module, and freed only when the Module is
+   * destroyed. Instead allocate them in memory owned by the
+   * interpreter, so that a Module can be reused for any number of
+   * executions.
+   */
+  char *getMemoryForGV(const llvm::GlobalVariable *GV) override {
+#ifdef LLVM_EXECUTIONENGINE_DATALAYOUT_PTR
+    const llvm::DataLayout &DL = *getDataLayout();
+#else
+    const llvm::DataLayout &DL = getDataLayout();
+#endif
+    size_t size = DL.getTypeAllocSize(GV->getType()->getElementType());
+    void *ptr = std::calloc(size ? size : 1, 1);
+    if(!ptr) throw std::bad_alloc();
+    GlobalMemory.push_back(ptr);
+    return static_cast<char*>(ptr);
+  }
 public:
   DPORInterpreter(llvm::Module *M)
 #ifdef LLVM_EXECUTIONENGINE_MODULE_UNIQUE_PTR
@@ -40,8 +73,23 @@ public:
 #endif
   {
     AssumeBlocked = false;
+    EventCount = 0;
+  }
+  virtual ~DPORInterpreter(){
+    for(void *ptr : GlobalMemory){
+      std::free(ptr);
+    }
   }
   bool assumeBlocked() const { return AssumeBlocked; }
+  uint64_t eventCount() const { return EventCount; }
+  /* Returns true iff this trace contains any happens-before cycle.
+   *
+   * If there is a happens-before cycle, and conf.check_robustness is
+   * set, then a corresponding error is added to errors.
+   *
+   * Call this method only at the end of execution.
+   */
+  virtual bool checkForCycles() const = 0;
 };
 
 #endif
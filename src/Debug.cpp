@@ -21,14 +21,19 @@
 
 #include "vecset.h"
 
+#include <mutex>
+
 llvm::raw_ostream &Debug::warn(){
   return llvm::errs();
 }
 
 llvm::raw_ostream &Debug::warn(const std::string &wid){
   static VecSet<std::string> seen_wids;
-  static std::string dummy_str;
-  static llvm::raw_string_ostream dummy_os(dummy_str);
+  static std::mutex seen_wids_mutex;
+  /* Per thread, since warnings may be issued concurrently */
+  static thread_local std::string dummy_str;
+  static thread_local llvm::raw_string_ostream dummy_os(dummy_str);
+  std::lock_guard<std::mutex> lock(seen_wids_mutex);
   if(seen_wids.count(wid)){
     dummy_str.clear();
     return dummy_os;
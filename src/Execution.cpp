@@ -3257,6 +3257,7 @@ void Interpreter::run() {
   bool rerun = false;
   while(rerun || TB.schedule(&CurrentThread,&aux,&CurrentAlt,&DryRun)){
     assert(0 <= CurrentThread && CurrentThread < long(Threads.size()));
+    if(!rerun) countEvent();
     rerun = false;
     if(0 <= aux){ // Run some auxiliary thread
       runAux(CurrentThread,aux);
@@ -21,31 +21,11 @@
 
 #include <cassert>
 
-std::vector<FBVClock::ClockSystem> FBVClock::sys;
-
-FBVClock::ClockSystemID FBVClock::new_clock_system(){
-  for(int i = 0; i < int(sys.size()); ++i){
-    if(!sys[i].allocated){
-      sys[i].allocated = true;
-      return i;
-    }
-  }
-  sys.emplace_back();
-  return int(sys.size())-1;
-}
-
-void FBVClock::delete_clock_system(ClockSystemID cid){
-  sys[cid] = ClockSystem(); // Clear old data
-  sys[cid].allocated = false;
-}
-
-FBVClock::FBVClock(ClockSystemID cid, int idx) : cid(cid), idx(idx) {
-  assert(0 <= cid && cid < int(sys.size()));
-  ClockSystem &CS = sys[cid];
+FBVClock::FBVClock(ClockSystem &cs, int idx) : sys(&cs), idx(idx) {
+  ClockSystem &CS = cs;
   id = int(CS.clocks.size());
   CS.clocks.emplace_back();
-  CS.clocks.back().resize(idx+1,false);
-  CS.clocks.back()[idx] = true;
+  CS.clocks.back().set(idx);
   if(int(CS.idx_to_id.size()) <= idx) CS.idx_to_id.resize(idx+1);
   CS.idx_to_id[idx] = id;
   CS.change_ts.push_back(CS.time);
@@ -53,60 +33,55 @@ FBVClock::FBVClock(ClockSystemID cid, int idx) : cid(cid), idx(idx) {
 }
 
 bool FBVClock::operator[](int i){
+  return get()[i];
+}
+
+const BVClock &FBVClock::get(){
   update();
-  return i < int(sys[cid].clocks[id].size()) && sys[cid].clocks[id][i];
+  return sys->clocks[id];
 }
 
 FBVClock &FBVClock::operator+=(FBVClock &c){
-  ClockSystem &CS = sys[cid];
-  if(c.idx < int(CS.clocks[id].size()) && CS.clocks[id][c.idx]){
+  ClockSystem &CS = *sys;
+  assert(c.sys == sys);
+  if(CS.clocks[id][c.idx]){
     // Already added
     return *this;
   }
   c.update();
   ++CS.time;
   CS.update_ts[c.id] = CS.time;
-  std::vector<bool> &clk = CS.clocks[id];
-  add_clock(clk,CS.clocks[c.id]);
+  CS.clocks[id] += CS.clocks[c.id];
   CS.change_ts[id] = CS.time;
   return *this;
 }
 
-void FBVClock::update(ClockSystemID cid, int id){
-  assert(0 <= cid && cid < int(sys.size()));
-  ClockSystem &CS = sys[cid];
+void FBVClock::update(ClockSystem &CS, int id){
   assert(0 <= id && id < int(CS.clocks.size()));
-  std::vector<bool> &clk = CS.clocks[id];
-  assert(clk.size() <= CS.idx_to_id.size());
+  BVClock &clk = CS.clocks[id];
+  assert(clk.size() <= int(CS.idx_to_id.size()));
   const int upd_ts = CS.update_ts[id];
   if(upd_ts == CS.time) return;
 
-  for(unsigned i = 0; i < clk.size(); ++i){
+  for(int i = 0; i < clk.size(); ++i){
     int i_id = CS.idx_to_id[i];
-    if(i_id != id && CS.clocks[id][i] && upd_ts < CS.change_ts[i_id]){
-      update(cid,i_id);
-      add_clock(clk,CS.clocks[i_id]);
+    if(i_id != id && clk[i] && upd_ts < CS.change_ts[i_id]){
+      update(CS,i_id);
+      clk += CS.clocks[i_id];
     }
   }
 
   CS.update_ts[id] = CS.time;
 }
 
-void FBVClock::add_clock(std::vector<bool> &dst, std::vector<bool> &src){
-  if(dst.size() < src.size()) dst.resize(src.size(),false);
-  for(unsigned i = 0; i < src.size(); ++i){
-    dst[i] = dst[i] || src[i];
-  }
-}
-
 std::string FBVClock::to_string() const{
   if(id < 0){
     return "";
   }
   update();
-  const std::vector<bool> &clk = sys[cid].clocks[id];
-  std::string s(sys[cid].idx_to_id.size(),'0');
-  for(unsigned i = 0; i < clk.size(); ++i){
+  const BVClock &clk = sys->clocks[id];
+  std::string s(sys->idx_to_id.size(),'0');
+  for(int i = 0; i < clk.size(); ++i){
     if(clk[i]) s[i] = '1';
   }
   return s;
@@ -22,6 +22,8 @@
 #ifndef __FBVCLOCK_H__
 #define __FBVCLOCK_H__
 
+#include "BVClock.h"
+
 #include <llvm/Support/raw_ostream.h>
 
 #include <string>
@@ -29,41 +31,48 @@
 
 class FBVClock{
 public:
-  typedef int ClockSystemID;
-  static ClockSystemID new_clock_system();
-  static void delete_clock_system(ClockSystemID cid);
-  FBVClock(ClockSystemID cid, int idx);
+  /* A ClockSystem holds the clocks of a set of FBVClocks that may be
+   * added to each other. It is owned by its user (e.g. a trace
+   * builder), so clock systems of different users are independent
+   * and can be used from different threads. A ClockSystem must
+   * outlive its FBVClocks.
+   */
+  class ClockSystem{
+  public:
+    ClockSystem() : time(0) {};
+    ClockSystem(const ClockSystem &) = delete;
+    ClockSystem &operator=(const ClockSystem &) = delete;
+  private:
+    friend class FBVClock;
+    int time;
+    std::vector<int> change_ts;
+    std::vector<int> update_ts;
+    std::vector<BVClock> clocks;
+    std::vector<int> idx_to_id;
+  };
+  FBVClock(ClockSystem &cs, int idx);
   FBVClock(const FBVClock &) = default;
   bool operator[](int i);
   FBVClock &operator+=(FBVClock &c);
+  /* The current value of this clock. */
+  const BVClock &get();
   std::string to_string() const;
-  void invalidate() { cid = id = -1; };
+  void invalidate() { sys = nullptr; id = -1; };
   /* Returns some natural number i such that for all j s.t. i<=j, it
    * holds that (*this)[j] == false.
    *
    * In particular i will be the number of clock elements currently
    * kept track of by this clock.
    */
-  int size() const { return sys[cid].idx_to_id.size(); };
+  int size() const { return sys->idx_to_id.size(); };
 private:
-  ClockSystemID cid;
+  ClockSystem *sys;
   int id;
   int idx;
-  struct ClockSystem{
-    ClockSystem() : allocated(true), time(0) {};
-    bool allocated;
-    int time;
-    std::vector<int> change_ts;
-    std::vector<int> update_ts;
-    std::vector<std::vector<bool> > clocks;
-    std::vector<int> idx_to_id;
-  };
-  static std::vector<ClockSystem> sys;
 
-  void update() const { update(cid,id); };
+  void update() const { update(*sys,id); };
 
-  static void update(ClockSystemID cid, int id);
-  static void add_clock(std::vector<bool> &dst, std::vector<bool> &src);
+  static void update(ClockSystem &CS, int id);
 };
 
 inline std::ostream &operator<<(std::ostream &os, FBVClock &c){
@@ -27,11 +27,11 @@
 BOOST_AUTO_TEST_SUITE(FBVClock_test)
 
 BOOST_AUTO_TEST_CASE(Initialization){
-  FBVClock::ClockSystemID cid = FBVClock::new_clock_system();
-  FBVClock a(cid,0);
-  FBVClock b(cid,1);
-  FBVClock c(cid,2);
-  FBVClock b2(cid,1);
+  FBVClock::ClockSystem cs;
+  FBVClock a(cs,0);
+  FBVClock b(cs,1);
+  FBVClock c(cs,2);
+  FBVClock b2(cs,1);
   BOOST_CHECK(a.to_string() == "100");
   BOOST_CHECK(b.to_string() == "010");
   BOOST_CHECK(c.to_string() == "001");
@@ -39,10 +39,10 @@ BOOST_AUTO_TEST_CASE(Initialization){
 }
 
 BOOST_AUTO_TEST_CASE(Addition_1){
-  FBVClock::ClockSystemID cid = FBVClock::new_clock_system();
-  FBVClock a(cid,0);
-  FBVClock b(cid,1);
-  FBVClock c(cid,2);
+  FBVClock::ClockSystem cs;
+  FBVClock a(cs,0);
+  FBVClock b(cs,1);
+  FBVClock c(cs,2);
   c += a;
   BOOST_CHECK(a.to_string() == "100");
   BOOST_CHECK(b.to_string() == "010");
@@ -50,10 +50,10 @@ BOOST_AUTO_TEST_CASE(Addition_1){
 }
 
 BOOST_AUTO_TEST_CASE(Addition_2){
-  FBVClock::ClockSystemID cid = FBVClock::new_clock_system();
-  FBVClock a(cid,0);
-  FBVClock b(cid,1);
-  FBVClock c(cid,2);
+  FBVClock::ClockSystem cs;
+  FBVClock a(cs,0);
+  FBVClock b(cs,1);
+  FBVClock c(cs,2);
   c += b;
   b += a;
   BOOST_CHECK(a.to_string() == "100");
@@ -62,11 +62,11 @@ BOOST_AUTO_TEST_CASE(Addition_2){
 }
 
 BOOST_AUTO_TEST_CASE(Addition_3){
-  FBVClock::ClockSystemID cid = FBVClock::new_clock_system();
-  FBVClock a(cid,0);
-  FBVClock b(cid,1);
-  FBVClock c(cid,2);
-  FBVClock d(cid,3);
+  FBVClock::ClockSystem cs;
+  FBVClock a(cs,0);
+  FBVClock b(cs,1);
+  FBVClock c(cs,2);
+  FBVClock d(cs,3);
   d += c;
   c += b;
   b += a;
@@ -77,10 +77,10 @@ BOOST_AUTO_TEST_CASE(Addition_3){
 }
 
 BOOST_AUTO_TEST_CASE(Addition_4){
-  FBVClock::ClockSystemID cid = FBVClock::new_clock_system();
-  FBVClock a(cid,0);
-  FBVClock b(cid,1);
-  FBVClock c(cid,2);
+  FBVClock::ClockSystem cs;
+  FBVClock a(cs,0);
+  FBVClock b(cs,1);
+  FBVClock c(cs,2);
   b += a;
   BOOST_CHECK(a.to_string() == "100");
   BOOST_CHECK(b.to_string() == "110");
@@ -88,10 +88,10 @@ BOOST_AUTO_TEST_CASE(Addition_4){
 }
 
 BOOST_AUTO_TEST_CASE(Elem_access_1){
-  FBVClock::ClockSystemID cid = FBVClock::new_clock_system();
-  FBVClock a(cid,0);
-  FBVClock b(cid,1);
-  FBVClock c(cid,2);
+  FBVClock::ClockSystem cs;
+  FBVClock a(cs,0);
+  FBVClock b(cs,1);
+  FBVClock c(cs,2);
   b += c;
   BOOST_CHECK(a[0]);
   BOOST_CHECK(!a[1]);
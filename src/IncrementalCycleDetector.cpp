@@ -0,0 +1,131 @@
+/* Copyright (C) 2026 agent
+ *
+ * This file is part of Nidhugg.
+ *
+ * Nidhugg is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nidhugg is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include "IncrementalCycleDetector.h"
+
+#include <algorithm>
+#include <cassert>
+
+int IncrementalCycleDetector::add_node(){
+  if(sz == int(fwd.size())){
+    fwd.emplace_back();
+    bwd.emplace_back();
+    ord.push_back(0);
+    visited.push_back(false);
+  }else{
+    fwd[sz].clear();
+    bwd[sz].clear();
+  }
+  ord[sz] = next_ord++;
+  return sz++;
+}
+
+void IncrementalCycleDetector::remove_last_node(){
+  assert(0 < sz);
+  const int n = sz-1;
+  for(int p : bwd[n]){
+    std::vector<int> &succ = fwd[p];
+    succ.erase(std::remove(succ.begin(),succ.end(),n),succ.end());
+  }
+  for(int s : fwd[n]){
+    std::vector<int> &pred = bwd[s];
+    pred.erase(std::remove(pred.begin(),pred.end(),n),pred.end());
+  }
+  --sz;
+}
+
+bool IncrementalCycleDetector::add_edge(int from, int to){
+  assert(0 <= from && from < sz);
+  assert(0 <= to && to < sz);
+  if(from == to) return false;
+  if(ord[to] < ord[from]){
+    /* The edge disagrees with the current order. */
+    const int64_t lb = ord[to], ub = ord[from];
+    delta_fwd.clear();
+    if(!search_fwd(to,ub)){
+      for(int n : delta_fwd) visited[n] = false;
+      return false;
+    }
+    delta_bwd.clear();
+    search_bwd(from,lb);
+    reorder();
+  }
+  if(fwd[from].empty() || fwd[from].back() != to){
+    fwd[from].push_back(to);
+    bwd[to].push_back(from);
+  }
+  return true;
+}
+
+bool IncrementalCycleDetector::search_fwd(int n, int64_t ub){
+  stack.clear();
+  stack.push_back(n);
+  visited[n] = true;
+  delta_fwd.push_back(n);
+  while(stack.size()){
+    int m = stack.back();
+    stack.pop_back();
+    for(int s : fwd[m]){
+      if(ord[s] == ub) return false;
+      if(!visited[s] && ord[s] < ub){
+        visited[s] = true;
+        delta_fwd.push_back(s);
+        stack.push_back(s);
+      }
+    }
+  }
+  return true;
+}
+
+void IncrementalCycleDetector::search_bwd(int n, int64_t lb){
+  stack.clear();
+  stack.push_back(n);
+  visited[n] = true;
+  delta_bwd.push_back(n);
+  while(stack.size()){
+    int m = stack.back();
+    stack.pop_back();
+    for(int p : bwd[m]){
+      if(!visited[p] && lb < ord[p]){
+        visited[p] = true;
+        delta_bwd.push_back(p);
+        stack.push_back(p);
+      }
+    }
+  }
+}
+
+void IncrementalCycleDetector::reorder(){
+  auto by_ord = [this](int a, int b){ return ord[a] < ord[b]; };
+  std::sort(delta_bwd.begin(),delta_bwd.end(),by_ord);
+  std::sort(delta_fwd.begin(),delta_fwd.end(),by_ord);
+  pool.clear();
+  for(int n : delta_bwd) pool.push_back(ord[n]);
+  for(int n : delta_fwd) pool.push_back(ord[n]);
+  std::sort(pool.begin(),pool.end());
+  unsigned i = 0;
+  for(int n : delta_bwd){
+    ord[n] = pool[i++];
+    visited[n] = false;
+  }
+  for(int n : delta_fwd){
+    ord[n] = pool[i++];
+    visited[n] = false;
+  }
+}
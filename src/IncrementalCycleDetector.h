@@ -0,0 +1,106 @@
+/* Copyright (C) 2026 agent
+ *
+ * This file is part of Nidhugg.
+ *
+ * Nidhugg is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nidhugg is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#ifndef __INCREMENTAL_CYCLE_DETECTOR_H__
+#define __INCREMENTAL_CYCLE_DETECTOR_H__
+
+#include <cstdint>
+#include <vector>
+
+/* An IncrementalCycleDetector maintains a directed acyclic graph
+ * under insertion of nodes and edges, and detects the first edge
+ * which would close a cycle.
+ *
+ * A topological order of the graph is maintained as in [Pearce,
+ * Kelly, JEA 2007]: Inserting an edge which agrees with the current
+ * order is constant time. Otherwise only the nodes whose position lies
+ * between the end points of the new edge are searched and reordered.
+ *
+ * Nodes are identified by the integers 0, 1, ... in the order they
+ * are added.
+ */
+class IncrementalCycleDetector{
+public:
+  IncrementalCycleDetector() : sz(0), next_ord(0) {};
+  /* The number of nodes in the graph. */
+  int size() const { return sz; };
+  /* Adds a new node without edges, and returns its identifier. The
+   * new node is placed last in the topological order.
+   */
+  int add_node();
+  /* Removes the node with the highest identifier, together with all
+   * its edges.
+   *
+   * Pre: size() > 0
+   */
+  void remove_last_node();
+  /* Adds the edge from -> to. Returns true if the graph is still
+   * acyclic. Otherwise returns false and leaves the graph unchanged.
+   *
+   * Pre: 0 <= from < size() and 0 <= to < size()
+   */
+  bool add_edge(int from, int to);
+  /* Returns true iff a is before b in the maintained topological
+   * order. In particular, if there is a path from a to b, then
+   * precedes(a,b).
+   */
+  bool precedes(int a, int b) const { return ord[a] < ord[b]; };
+  /* Removes all nodes and edges. */
+  void clear() { sz = 0; next_ord = 0; };
+private:
+  /* The number of nodes in use. The vectors below may be longer, in
+   * which case their remaining elements are kept only to reuse
+   * their allocations.
+   */
+  int sz;
+  /* The position in the topological order that will be given to the
+   * next added node. Positions are distinct, but need not be
+   * contiguous.
+   */
+  int64_t next_ord;
+  /* fwd[n] and bwd[n] are the successors and predecessors of n. */
+  std::vector<std::vector<int> > fwd;
+  std::vector<std::vector<int> > bwd;
+  /* ord[n] is the position of n in the topological order. */
+  std::vector<int64_t> ord;
+  /* Scratch space for add_edge. visited is all false between calls. */
+  std::vector<bool> visited;
+  std::vector<int> delta_fwd;
+  std::vector<int> delta_bwd;
+  std::vector<int> stack;
+  std::vector<int64_t> pool;
+
+  /* Searches forward from n through nodes placed before ub. Returns
+   * false iff a node at position ub is reached. The visited nodes are
+   * collected in delta_fwd.
+   */
+  bool search_fwd(int n, int64_t ub);
+  /* Searches backward from n through nodes placed after lb. The
+   * visited nodes are collected in delta_bwd.
+   */
+  void search_bwd(int n, int64_t lb);
+  /* Places the nodes of delta_bwd before the nodes of delta_fwd,
+   * using the positions previously held by those nodes.
+   */
+  void reorder();
+};
+
+#endif
@@ -0,0 +1,107 @@
+/* Copyright (C) 2026 agent
+ *
+ * This file is part of Nidhugg.
+ *
+ * Nidhugg is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nidhugg is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#ifdef HAVE_BOOST_UNIT_TEST_FRAMEWORK
+#include <boost/test/unit_test.hpp>
+
+#include "IncrementalCycleDetector.h"
+
+BOOST_AUTO_TEST_SUITE(IncrementalCycleDetector_test)
+
+BOOST_AUTO_TEST_CASE(Forward_edges){
+  IncrementalCycleDetector G;
+  for(int i = 0; i < 4; ++i){
+    BOOST_CHECK_EQUAL(G.add_node(), i);
+  }
+  BOOST_CHECK(G.add_edge(0,1));
+  BOOST_CHECK(G.add_edge(1,3));
+  BOOST_CHECK(G.add_edge(0,2));
+  BOOST_CHECK(G.precedes(0,3));
+  BOOST_CHECK(!G.add_edge(3,0));
+  BOOST_CHECK(!G.add_edge(2,2));
+}
+
+BOOST_AUTO_TEST_CASE(Reorder){
+  IncrementalCycleDetector G;
+  for(int i = 0; i < 5; ++i) G.add_node();
+  BOOST_CHECK(G.add_edge(0,1));
+  BOOST_CHECK(G.add_edge(3,4));
+  /* Edges against the initial order */
+  BOOST_CHECK(G.add_edge(4,0));
+  BOOST_CHECK(G.precedes(3,4));
+  BOOST_CHECK(G.precedes(4,0));
+  BOOST_CHECK(G.precedes(0,1));
+  BOOST_CHECK(G.add_edge(2,3));
+  BOOST_CHECK(G.precedes(2,1));
+  /* 1 -> 2 closes 1 -> 2 -> 3 -> 4 -> 0 -> 1 */
+  BOOST_CHECK(!G.add_edge(1,2));
+  /* The failed edge was not added */
+  BOOST_CHECK(G.add_edge(1,2) == false);
+  BOOST_CHECK(G.precedes(2,1));
+}
+
+BOOST_AUTO_TEST_CASE(Long_chain){
+  IncrementalCycleDetector G;
+  const int n = 1000;
+  for(int i = 0; i < n; ++i) G.add_node();
+  /* A chain in reverse of the initial order */
+  for(int i = n-1; 0 < i; --i){
+    BOOST_CHECK(G.add_edge(i,i-1));
+  }
+  for(int i = n-1; 0 < i; --i){
+    BOOST_CHECK(G.precedes(i,i-1));
+  }
+  BOOST_CHECK(!G.add_edge(0,n-1));
+  BOOST_CHECK(G.add_edge(n-1,0));
+}
+
+BOOST_AUTO_TEST_CASE(Remove_last_node){
+  IncrementalCycleDetector G;
+  G.add_node();
+  G.add_node();
+  G.add_node();
+  BOOST_CHECK(G.add_edge(0,2));
+  BOOST_CHECK(G.add_edge(2,1));
+  G.remove_last_node();
+  BOOST_CHECK_EQUAL(G.size(), 2);
+  BOOST_CHECK(G.add_edge(1,0));
+  BOOST_CHECK_EQUAL(G.add_node(), 2);
+  BOOST_CHECK(G.add_edge(0,2));
+  BOOST_CHECK(!G.add_edge(2,1));
+}
+
+BOOST_AUTO_TEST_CASE(Clear){
+  IncrementalCycleDetector G;
+  G.add_node();
+  G.add_node();
+  BOOST_CHECK(G.add_edge(1,0));
+  G.clear();
+  BOOST_CHECK_EQUAL(G.size(), 0);
+  G.add_node();
+  G.add_node();
+  BOOST_CHECK(G.add_edge(0,1));
+  BOOST_CHECK(G.precedes(0,1));
+  BOOST_CHECK(!G.add_edge(1,0));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
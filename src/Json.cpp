@@ -0,0 +1,45 @@
+/* Copyright (C) 2026 agent
+ *
+ * This file is part of Nidhugg.
+ *
+ * Nidhugg is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nidhugg is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include "Json.h"
+
+#include <cstdio>
+
+std::string Json::quote(const std::string &s){
+  std::string res = "\"";
+  for(char c : s){
+    switch(c){
+    case '"': res += "\\\""; break;
+    case '\\': res += "\\\\"; break;
+    case '\n': res += "\\n"; break;
+    case '\t': res += "\\t"; break;
+    case '\r': res += "\\r"; break;
+    default:
+      if((unsigned char)c < 0x20){
+        char buf[8];
+        std::snprintf(buf,sizeof(buf),"\\u%04x",int(c));
+        res += buf;
+      }else{
+        res += c;
+      }
+    }
+  }
+  res += '"';
+  return res;
+}
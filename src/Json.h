@@ -0,0 +1,40 @@
+/* Copyright (C) 2026 agent
+ *
+ * This file is part of Nidhugg.
+ *
+ * Nidhugg is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nidhugg is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#ifndef __JSON_H__
+#define __JSON_H__
+
+#include <string>
+
+/* Helpers for the JSON documents written by nidhugg (--stats-json,
+ * --batch, --time-trace, microbench).
+ */
+namespace Json {
+
+  /* Returns s as a JSON string literal, including the quotes. Quotes,
+   * backslashes and control characters are escaped. Other bytes are
+   * copied as they are, so s should be UTF-8.
+   */
+  std::string quote(const std::string &s);
+
+}
+
+#endif
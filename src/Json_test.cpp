@@ -0,0 +1,48 @@
+/* Copyright (C) 2026 agent
+ *
+ * This file is part of Nidhugg.
+ *
+ * Nidhugg is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nidhugg is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#ifdef HAVE_BOOST_UNIT_TEST_FRAMEWORK
+#include <boost/test/unit_test.hpp>
+
+#include "Json.h"
+
+#include <string>
+
+BOOST_AUTO_TEST_SUITE(Json_test)
+
+BOOST_AUTO_TEST_CASE(Quote_plain){
+  BOOST_CHECK_EQUAL(Json::quote(""), "\"\"");
+  BOOST_CHECK_EQUAL(Json::quote("a.ll:12"), "\"a.ll:12\"");
+}
+
+BOOST_AUTO_TEST_CASE(Quote_escapes){
+  BOOST_CHECK_EQUAL(Json::quote("say \"hi\""), "\"say \\\"hi\\\"\"");
+  BOOST_CHECK_EQUAL(Json::quote("C:\\dir"), "\"C:\\\\dir\"");
+  BOOST_CHECK_EQUAL(Json::quote("a\nb\tc\rd"), "\"a\\nb\\tc\\rd\"");
+  BOOST_CHECK_EQUAL(Json::quote(std::string("\x01\x1f",2)), "\"\\u0001\\u001f\"");
+  BOOST_CHECK_EQUAL(Json::quote(std::string("\0",1)), "\"\\u0000\"");
+  /* Non-ASCII bytes are passed through */
+  BOOST_CHECK_EQUAL(Json::quote("\xc3\xa5"), "\"\xc3\xa5\"");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
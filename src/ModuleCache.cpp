@@ -0,0 +1,149 @@
+/* Copyright (C) 2026 agent
+ *
+ * This file is part of Nidhugg.
+ *
+ * Nidhugg is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nidhugg is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include "Debug.h"
+#include "ModuleCache.h"
+
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/SHA1.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+namespace {
+  /* Entries are named by their key followed by this suffix. Bump the
+   * version if the key or entry format changes. */
+  const std::string entry_suffix = ".v1.bc";
+
+  bool ends_with(const std::string &s, const std::string &suffix){
+    return s.size() >= suffix.size() &&
+      s.compare(s.size()-suffix.size(),suffix.size(),suffix) == 0;
+  }
+}
+
+ModuleCache::ModuleCache(const std::string &dir, uint64_t max_size)
+  : dir(dir), max_size(max_size), broken(false) {
+  if(std::error_code ec = llvm::sys::fs::create_directories(dir)){
+    Debug::warn("ModuleCache::create")
+      << "WARNING: Cannot create module cache directory " << dir
+      << ": " << ec.message() << ". Not caching modules.\n";
+    broken = true;
+  }
+}
+
+std::string ModuleCache::key(const std::string &input, const Configuration &conf){
+  std::stringstream settings;
+  settings << PACKAGE_VERSION
+#ifdef GIT_COMMIT
+           << ":" << GIT_COMMIT
+#endif
+           << ":" << LLVM_VERSION
+           << "|spin_assume=" << conf.transform_spin_assume
+           << "|loop_unroll=" << conf.transform_loop_unroll
+           << "|";
+  llvm::SHA1 sha;
+  sha.update(settings.str());
+  sha.update(input);
+  std::string hex;
+  for(unsigned char c : sha.result()){
+    const char *digits = "0123456789abcdef";
+    hex += digits[c >> 4];
+    hex += digits[c & 0xf];
+  }
+  return hex;
+}
+
+std::string ModuleCache::path(const std::string &key) const{
+  return dir + "/" + key + entry_suffix;
+}
+
+bool ModuleCache::lookup(const std::string &key, std::string &bitcode){
+  if(broken) return false;
+  std::string p = path(key);
+  std::ifstream is(p, std::ios::binary);
+  if(!is) return false;
+  std::stringstream ss;
+  ss << is.rdbuf();
+  if(!is) return false;
+  bitcode = ss.str();
+  /* Mark as recently used for eviction */
+  utime(p.c_str(),nullptr);
+  return true;
+}
+
+void ModuleCache::store(const std::string &key, const std::string &bitcode){
+  if(broken) return;
+  std::string p = path(key);
+  std::string tmp = p + ".tmp" + std::to_string(getpid());
+  {
+    std::ofstream os(tmp, std::ios::binary);
+    os.write(bitcode.data(),bitcode.size());
+    if(!os){
+      Debug::warn("ModuleCache::store")
+        << "WARNING: Failed to write to module cache " << dir << ".\n";
+      std::remove(tmp.c_str());
+      return;
+    }
+  }
+  if(std::rename(tmp.c_str(),p.c_str())){
+    std::remove(tmp.c_str());
+    return;
+  }
+  evict(p);
+}
+
+void ModuleCache::evict(const std::string &keep){
+  struct entry {
+    std::string path;
+    uint64_t size;
+    time_t mtime;
+  };
+  std::vector<entry> entries;
+  uint64_t total = 0;
+  DIR *d = opendir(dir.c_str());
+  if(!d) return;
+  while(struct dirent *de = readdir(d)){
+    std::string name = de->d_name;
+    if(!ends_with(name,entry_suffix)) continue;
+    struct stat st;
+    std::string p = dir + "/" + name;
+    if(stat(p.c_str(),&st)) continue;
+    entries.push_back({p, uint64_t(st.st_size), st.st_mtime});
+    total += st.st_size;
+  }
+  closedir(d);
+  if(total <= max_size) return;
+  std::sort(entries.begin(),entries.end(),
+            [](const entry &a, const entry &b){ return a.mtime < b.mtime; });
+  for(const entry &e : entries){
+    if(total <= max_size) break;
+    if(e.path == keep) continue;
+    if(std::remove(e.path.c_str()) == 0){
+      total -= e.size;
+    }
+  }
+}
@@ -0,0 +1,77 @@
+/* Copyright (C) 2026 agent
+ *
+ * This file is part of Nidhugg.
+ *
+ * Nidhugg is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nidhugg is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#ifndef __MODULE_CACHE_H__
+#define __MODULE_CACHE_H__
+
+#include "Configuration.h"
+
+#include <cstdint>
+#include <string>
+
+/* A ModuleCache is an on-disk cache of transformed modules, stored as
+ * bitcode in a directory. Modules are content addressed: the key of a
+ * module is a hash of the input module, of the transformation
+ * settings in the Configuration, and of the Nidhugg and LLVM versions.
+ *
+ * The directory may be shared by concurrent Nidhugg processes. Each
+ * entry is written to a temporary file which is then renamed into
+ * place, so readers never see a partial entry.
+ *
+ * Failures to write to the cache are reported as warnings, since the
+ * cache is only an optimisation.
+ */
+class ModuleCache{
+public:
+  /* Create a cache in the directory dir, which is created if it does
+   * not exist. When the entries in dir exceed max_size bytes in total,
+   * the least recently used entries are removed.
+   */
+  ModuleCache(const std::string &dir, uint64_t max_size);
+  ModuleCache(const ModuleCache&) = delete;
+  ModuleCache &operator=(const ModuleCache&) = delete;
+
+  /* Returns the key under which the result of transforming the module
+   * input (LLVM assembly or bitcode) according to conf is cached.
+   */
+  static std::string key(const std::string &input, const Configuration &conf);
+  /* If a module is cached under key, stores its bitcode in bitcode,
+   * marks the entry as recently used, and returns true. Otherwise
+   * returns false.
+   */
+  bool lookup(const std::string &key, std::string &bitcode);
+  /* Caches bitcode under key, and then evicts entries until the cache
+   * is within its size limit.
+   */
+  void store(const std::string &key, const std::string &bitcode);
+private:
+  std::string dir;
+  uint64_t max_size;
+  /* Set if dir could not be created. Then the cache is disabled. */
+  bool broken;
+
+  std::string path(const std::string &key) const;
+  /* Remove the least recently used entries, except the one at path
+   * keep, until the cache is within its size limit. */
+  void evict(const std::string &keep);
+};
+
+#endif
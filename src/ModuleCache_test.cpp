@@ -0,0 +1,126 @@
+/* Copyright (C) 2026 agent
+ *
+ * This file is part of Nidhugg.
+ *
+ * Nidhugg is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nidhugg is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#ifdef HAVE_BOOST_UNIT_TEST_FRAMEWORK
+#include <boost/test/unit_test.hpp>
+
+#include "ModuleCache.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#include <dirent.h>
+#include <unistd.h>
+#include <utime.h>
+
+namespace {
+  /* A fresh temporary directory, removed with its contents on
+   * destruction. */
+  struct TmpDir {
+    std::string path;
+    TmpDir(){
+      char buf[] = "/tmp/nidhugg_ModuleCache_test_XXXXXX";
+      path = mkdtemp(buf);
+    }
+    ~TmpDir(){
+      if(DIR *d = opendir(path.c_str())){
+        while(struct dirent *de = readdir(d)){
+          std::string name = de->d_name;
+          if(name != "." && name != "..") unlink((path+"/"+name).c_str());
+        }
+        closedir(d);
+      }
+      rmdir(path.c_str());
+    }
+  };
+
+  int count_entries(const std::string &dir){
+    int n = 0;
+    if(DIR *d = opendir(dir.c_str())){
+      while(struct dirent *de = readdir(d)){
+        if(de->d_name[0] != '.') ++n;
+      }
+      closedir(d);
+    }
+    return n;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(ModuleCache_test)
+
+BOOST_AUTO_TEST_CASE(Key){
+  Configuration conf;
+  std::string k = ModuleCache::key("define i32 @main() { ret i32 0 }",conf);
+  BOOST_CHECK_EQUAL(k.size(), 40);
+  BOOST_CHECK_EQUAL(k, ModuleCache::key("define i32 @main() { ret i32 0 }",conf));
+  BOOST_CHECK_NE(k, ModuleCache::key("define i32 @main() { ret i32 1 }",conf));
+  conf.transform_loop_unroll = 3;
+  BOOST_CHECK_NE(k, ModuleCache::key("define i32 @main() { ret i32 0 }",conf));
+  conf.transform_loop_unroll = -1;
+  conf.transform_spin_assume = !conf.transform_spin_assume;
+  BOOST_CHECK_NE(k, ModuleCache::key("define i32 @main() { ret i32 0 }",conf));
+}
+
+BOOST_AUTO_TEST_CASE(Store_lookup){
+  TmpDir tmp;
+  ModuleCache cache(tmp.path, 1 << 20);
+  std::string bc;
+  BOOST_CHECK(!cache.lookup("abc",bc));
+  std::string data("BC\0\xc0\xde",5);
+  cache.store("abc",data);
+  BOOST_CHECK(cache.lookup("abc",bc));
+  BOOST_CHECK(bc == data);
+  BOOST_CHECK(!cache.lookup("abd",bc));
+  /* A second cache in the same directory sees the entry */
+  ModuleCache cache2(tmp.path, 1 << 20);
+  BOOST_CHECK(cache2.lookup("abc",bc));
+  BOOST_CHECK(bc == data);
+}
+
+BOOST_AUTO_TEST_CASE(Evict){
+  TmpDir tmp;
+  ModuleCache cache(tmp.path, 250);
+  std::string bc;
+  cache.store("a",std::string(100,'a'));
+  cache.store("b",std::string(100,'b'));
+  /* Make a older than b, and then use a so that b is the least
+   * recently used. */
+  struct utimbuf old = {1000, 1000};
+  struct utimbuf older = {500, 500};
+  utime((tmp.path+"/a.v1.bc").c_str(),&older);
+  utime((tmp.path+"/b.v1.bc").c_str(),&old);
+  BOOST_CHECK(cache.lookup("a",bc));
+  cache.store("c",std::string(100,'c'));
+  BOOST_CHECK_EQUAL(count_entries(tmp.path), 2);
+  BOOST_CHECK(cache.lookup("a",bc));
+  BOOST_CHECK(!cache.lookup("b",bc));
+  BOOST_CHECK(cache.lookup("c",bc));
+  /* An entry larger than the limit is still kept until the next
+   * store. */
+  cache.store("d",std::string(300,'d'));
+  BOOST_CHECK(cache.lookup("d",bc));
+  BOOST_CHECK_EQUAL(count_entries(tmp.path), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
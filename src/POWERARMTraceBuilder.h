@@ -22,6 +22,7 @@
 #ifndef __POWER_TRACE_BUILDER_H__
 #define __POWER_TRACE_BUILDER_H__
 
+#include <memory>
 #include <stdexcept>
 
 #include "BVClock.h"
@@ -155,9 +156,6 @@ public:
    */
   virtual bool schedule(IID<int> *iid, std::vector<MBlock> *values) = 0;
 
-  virtual bool check_for_cycles(){
-    throw std::logic_error("POWERARMTraceBuilder::check_for_cycles: Not supported.");
-  };
   /* Call to spawn a new thread. proc should be the parent thread. The
    * identifier of the new thread is returned.
    */
@@ -169,6 +167,18 @@ public:
    * repetition of the previous.
    */
   virtual void replay() = 0;
+  /* Splits off a part of the exploration which remains for this
+   * trace builder, and returns a new trace builder which will explore
+   * that part instead. Together, this trace builder and the returned
+   * one then explore precisely the computations that this trace
+   * builder would have explored on its own.
+   *
+   * split may only be called between computations, i.e., after a call
+   * to reset which returned true. Returns nullptr if there is nothing
+   * that can be split off, or if this trace builder was not created
+   * for parallel exploration (conf.n_threads > 1).
+   */
+  virtual std::unique_ptr<POWERARMTraceBuilder> split() = 0;
 };
 
 /* PATB_impl contains the implementation of the concrete classes
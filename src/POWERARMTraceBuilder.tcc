@@ -21,6 +21,7 @@
 #include "POWERARMTraceBuilder.h"
 
 #include <cassert>
+#include <functional>
 
 namespace PATB_impl{
 
@@ -36,10 +37,14 @@ namespace PATB_impl{
     fch.emplace_back();
     threads.emplace_back();
     cpids.emplace_back();
+    if(conf.n_threads > 1){
+      branch_registry = std::make_shared<BranchRegistry>();
+    }
   }
 
   template<MemoryModel MemMod,CB_T CB,class Event>
   TB<MemMod,CB,Event>::~TB(){
+    release_prefix_nodes(0);
   }
 
   template<MemoryModel MemMod,CB_T CB,class Event>
@@ -497,16 +502,16 @@ namespace PATB_impl{
       }
     }
     /* prop */
-    for(auto pr : evt.cur_param.ER.prop){
-      const IID<int> &a_iid = pr.first;
-      for(const IID<int> &b_iid : pr.second){
-        Event &a = get_evt(a_iid);
-        Event &b = get_evt(b_iid);
+    const ExtraRel &ER = evt.cur_param.ER;
+    ER.prop.for_each([this,&ER](int i, int j){
+        const IID<int> &a_iid = ER.prop_events[i];
+        const IID<int> &b_iid = ER.prop_events[j];
+        Event &a = this->get_evt(a_iid);
+        Event &b = this->get_evt(b_iid);
         assert(a.committed && b.committed);
         a.rel.prop.fwd.insert(b_iid);
         b.rel.prop.bwd.insert(a_iid);
-      }
-    }
+      });
     /* cb */
     evt.cb_bwd = compute_cb(evt);
   }
@@ -769,7 +774,9 @@ namespace PATB_impl{
       assert(get_evt(prefix[bnc_start]).branch_start < 0 || get_evt(prefix[bnc_start]).cur_branch.branch.size());
       if(get_evt(prefix[bnc_start]).branch_start < 0 || get_evt(prefix[bnc_start]).cur_branch < bnc){
         assert(get_evt(prefix[bnc_start]).branch_start < 0 || get_evt(prefix[bnc_start]).branch_start == bnc_start);
-        get_evt(prefix[bnc_start]).new_branches.insert(bnc);
+        if(register_branch(bnc_start,bnc)){
+          get_evt(prefix[bnc_start]).new_branches.insert(bnc);
+        }
       }
     }
   }
@@ -911,7 +918,7 @@ namespace PATB_impl{
       }
       calc_prop(evt,B.rel,B.ER);
       if(!propagation(evt,B.rel,B.ER)) continue;
-      if(!observation(evt,B.rel,B.ER.EHB)) continue;
+      if(!observation(evt,B.rel,B.ER)) continue;
       bool ok_load_reqs = true;
       if(has_load_req){
         std::vector<MBlock> values;
@@ -1531,432 +1538,235 @@ namespace PATB_impl{
 
   template<MemoryModel MemMod,CB_T CB,class Event>
   void TB<MemMod,CB,Event>::calc_prop(Event &new_evt, Relations &rel, ExtraRel &ER){
-    /* Masks for colour */
-    const int RFE_NE = 1;     // rfe-before new_evt
-    const int COM_NE = 2;     // com-before new_evt
-    const int HB_NE = 4;      // hb-before new_evt
-    const int IN_I = 8;       // In ER.EHB.I
-    const int IN_C = 16;      // In ER.EHB.C
-    const int RFE = 32;       // Reached by rfe?
-    const int COM = 64;       // Reached by com*
-    const int L_HB = 128;     // Reached by rfe?;fences;hb*
-    const int R_HB = 256;     // Reached by com*;fences;hb*
-    const int R_HB_SNC = 512; // Reached by com*;prop-base*;ffence;hb*
-    ExtraHB &_EHB = ER.EHB;
     VecSet<Event*> inits;
-    calc_prop_inits(new_evt,rel,_EHB,inits);
-    for(Event *init_e : inits){
-      clear_event_colour();
-      for(const IID<int> &iid : rel.rf.bwd){
-        if(iid.get_pid() == new_evt.iid.get_pid()) continue; // Not rfe
-        get_evt(iid).colour |= RFE_NE;
-      }
-      for(const IID<int> &iid : rel.com.bwd) get_evt(iid).colour |= COM_NE;
-      for(const IID<int> &iid : rel.hb.bwd) get_evt(iid).colour |= HB_NE;
-      for(const IID<int> &iid : _EHB.I) get_evt(iid).colour |= IN_I;
-      for(const IID<int> &iid : _EHB.C) get_evt(iid).colour |= IN_C;
-      init_e->colour |= (RFE | COM);
-      std::vector<Event*> stack;
-      /* Mark all in rfe */
-      const VecSet<IID<int> > &rf = (init_e == &new_evt) ? rel.rf.fwd : init_e->rel.rf.fwd;
-      for(const IID<int> &iid : rf){
-        if(iid.get_pid() == init_e->iid.get_pid()) continue; // Not rfe
-        Event &rfe_e = get_evt(iid);
-        rfe_e.colour |= RFE;
-      }
-      if(init_e->colour & RFE_NE) new_evt.colour |= RFE;
-      /* Insert all in com* */
-      {
-        std::vector<Event*> com_stack;
-        com_stack.push_back(init_e);
-        while(com_stack.size()){
-          Event *e = com_stack.back();
-          com_stack.pop_back();
-          stack.push_back(e);
-          const VecSet<IID<int> > &com = (e == &new_evt) ? rel.com.fwd : e->rel.com.fwd;
-          for(const IID<int> &iid : com){
-            Event &ce = get_evt(iid);
-            if(ce.colour & COM) continue; // Already added
-            ce.colour |= COM;
-            stack.push_back(&ce);
-            com_stack.push_back(&ce);
-          }
-          if(e->colour & COM_NE){
-            if(!(new_evt.colour & COM)){
-              new_evt.colour |= COM;
-              stack.push_back(&new_evt);
-              com_stack.push_back(&new_evt);
-            }
-          }
+    calc_prop_inits(new_evt,rel,ER.EHB,inits);
+    std::vector<Event*> events;
+    index_events(&new_evt,events);
+    const int n = int(events.size());
+    /* The relations over events from which prop is computed */
+    BitRel com(n), fences(n), ffence(n), hb(n);
+    add_to_bitrel(com,&Relations::com,events,&new_evt,&rel);
+    add_to_bitrel(hb,&Relations::hb,events,&new_evt,&rel);
+    add_to_bitrel(hb,ER.EHB);
+    for(Event *e : events){
+      const int proc = e->iid.get_pid();
+      const int fch_count = threads[proc].fch_count;
+      const int eieio = (e->eieio_idx_after == -1) ? fch_count : e->eieio_idx_after;
+      const int lwsync = (e->lwsync_idx_after == -1) ? fch_count : e->lwsync_idx_after;
+      const int sync = (e->sync_idx_after == -1) ? fch_count : e->sync_idx_after;
+      const int fnc_load = e->has_load ? std::min(sync,lwsync) : sync;
+      const int fnc_store = e->has_store ?
+        std::min(std::min(sync,lwsync),eieio) :
+        std::min(sync,lwsync);
+      for(int i = std::min(fnc_load,fnc_store); i < fch_count; ++i){
+        Event &fe = fch[proc][i];
+        if(fe.rel_idx < 0) continue; // Not committed
+        if((fe.has_load && fnc_load <= i) ||
+           (fe.has_store && fnc_store <= i)){
+          fences.insert(e->rel_idx,fe.rel_idx);
+          if(sync <= i) ffence.insert(e->rel_idx,fe.rel_idx);
         }
       }
-      const std::function<void(Event*,const VecSet<IID<int> >&)> follow_hb =
-        [this,&stack,&new_evt,L_HB,R_HB,R_HB_SNC,init_e,&rel,&ER]
-        (Event *e, const VecSet<IID<int> > &hb_fwd){
-        for(const IID<int> &iid : hb_fwd){
-          Event &e2 = this->get_evt(iid);
-          if(!e2.committed && &e2 != &new_evt) continue; // Not committed
-          int new_colour = e2.colour | (e->colour & (L_HB | R_HB | R_HB_SNC));
-          if(new_colour != e2.colour){
-            e2.colour = new_colour;
-            stack.push_back(&e2);
-          }
-          if((e2.has_store && init_e->has_store && (e2.colour & L_HB)) ||
-             (e2.colour & R_HB_SNC)){
-            /* init_e -prop-> e2 */
-            VecSet<IID<int> > &pfwd = (init_e == &new_evt) ?
-            rel.prop.fwd : init_e->rel.prop.fwd;
-            if(!pfwd.count(e2.iid)){
-              /* The prop edge is new */
-              if(&e2 == &new_evt){
-                rel.prop.bwd.insert(init_e->iid);
-              }
-              if(init_e == &new_evt){
-                rel.prop.fwd.insert(e2.iid);
-              }else if(&e2 != &new_evt){
-                ER.prop[init_e->iid].insert(e2.iid);
-              }
-            }
-          }
-        }
-      };
-      /* Follow fences and hb */
-      while(stack.size()){
-        Event *e = stack.back();
-        stack.pop_back();
-        /* Follow fences */
-        const int proc = e->iid.get_pid();
-        const int fch_count = threads[proc].fch_count;
-        const int eieio = (e->eieio_idx_after == -1) ? fch_count : e->eieio_idx_after;
-        const int lwsync = (e->lwsync_idx_after == -1) ? fch_count : e->lwsync_idx_after;
-        const int sync = (e->sync_idx_after == -1) ? fch_count : e->sync_idx_after;
-        const int fnc_load = e->has_load ? std::min(sync,lwsync) : sync;
-        const int fnc_store = e->has_store ?
-          std::min(std::min(sync,lwsync),eieio) :
-          std::min(sync,lwsync);
-        int fnc = std::min(fnc_load,fnc_store);
-        for(int i = fnc; i < fch_count; ++i){
-          Event &fe = fch[proc][i];
-          if(!fe.committed && &fe != &new_evt) continue; // Not committed
-          if((fe.has_load && fnc_load <= i) ||
-             (fe.has_store && fnc_store <= i)){
-            /* (e,fe) in fences */
-            int new_colour = fe.colour;
-            if(e->colour & RFE) new_colour |= L_HB;
-            if(e->colour & COM) new_colour |= R_HB;
-            new_colour |= (e->colour & (L_HB | R_HB | R_HB_SNC));
-            if(sync <= i) new_colour |= R_HB_SNC;
-            if(new_colour != fe.colour){
-              fe.colour = new_colour;
-              stack.push_back(&fe);
-            }
+    }
+    /* hb_plus = (fences U hb)+ */
+    BitRel hb_plus(hb);
+    hb_plus |= fences;
+    hb_plus.transitive_closure();
+    /* For each init_e in inits, row init_e of rfe_opt is rfe? from
+     * init_e and row init_e of com_star is com* from init_e.
+     */
+    BitRel rfe_opt(n), com_star(n);
+    for(Event *init_e : inits){
+      const int i = init_e->rel_idx;
+      rfe_opt.insert(i,i);
+      com_star.insert(i,i);
+    }
+    BitRel rfe(n);
+    add_to_bitrel(rfe,&Relations::rf,events,&new_evt,&rel);
+    rfe.for_each([&events,&rfe_opt](int i, int j){
+        if(rfe_opt(i,i) && events[i]->iid.get_pid() != events[j]->iid.get_pid()){
+          rfe_opt.insert(i,j);
+        }
+      });
+    com.transitive_closure();
+    com_star |= com_star.compose(com);
+    /* R;(fences;hb*) for a relation R */
+    const std::function<BitRel(const BitRel&)> then_fences_hb =
+      [&fences,&hb_plus](const BitRel &R){
+      BitRel res = R.compose(fences);
+      res |= res.compose(hb_plus);
+      return res;
+    };
+    /* prop-base = rfe?;fences;hb* */
+    const BitRel prop_base = then_fences_hb(rfe_opt);
+    /* com*;prop-base*;ffence;hb* */
+    BitRel reached = then_fences_hb(com_star);
+    reached |= com_star;
+    reached |= prop_base;
+    BitRel snc = reached.compose(ffence);
+    snc |= snc.compose(hb_plus);
+    /* The new prop edges which are not from or to new_evt */
+    BitRel new_prop(n);
+    const std::function<void(int,int)> add_prop =
+      [&events,&new_evt,&rel,&new_prop](int i, int j){
+      Event *e = events[i];
+      Event *e2 = events[j];
+      const VecSet<IID<int> > &pfwd = (e == &new_evt) ? rel.prop.fwd : e->rel.prop.fwd;
+      if(pfwd.count(e2->iid)) return; // Not new
+      if(e2 == &new_evt){
+        rel.prop.bwd.insert(e->iid);
+      }
+      if(e == &new_evt){
+        rel.prop.fwd.insert(e2->iid);
+      }else if(e2 != &new_evt){
+        new_prop.insert(i,j);
+      }
+    };
+    prop_base.for_each([&events,&add_prop](int i, int j){
+        if(events[i]->has_store && events[j]->has_store) add_prop(i,j);
+      });
+    snc.for_each(add_prop);
+    /* Keep only the events of some new edge in ER, since parameters
+     * are stored for many events.
+     */
+    std::vector<int> er_idx(n,-1);
+    ER.prop_events.clear();
+    new_prop.for_each([&er_idx,&events,&ER](int i, int j){
+        for(int k : {i,j}){
+          if(er_idx[k] < 0){
+            er_idx[k] = int(ER.prop_events.size());
+            ER.prop_events.push_back(events[k]->iid);
           }
         }
-        /* Follow hb */
-        if(e == &new_evt){
-          follow_hb(e,rel.hb.fwd);
-        }else{
-          follow_hb(e,e->rel.hb.fwd);
-        }
-        if(e->colour & IN_I){
-          follow_hb(e,_EHB.after_I);
-          follow_hb(e,_EHB.after_C);
-        }else if(e->colour & IN_C){
-          follow_hb(e,_EHB.after_C);
-        }
-        if(e->colour & HB_NE){
-          follow_hb(e,{new_evt.iid});
-        }
-      }
-    }
+      });
+    ER.prop = BitRel(ER.prop_events.size());
+    new_prop.for_each([&er_idx,&ER](int i, int j){
+        ER.prop.insert(er_idx[i],er_idx[j]);
+      });
   }
 
   template<MemoryModel MemMod,CB_T CB,class Event>
-  bool TB<MemMod,CB,Event>::no_thin_air(Event &evt, Relations &rel, ExtraHB &EHB){
-    const int VISITED = 1;   // Mask for colour: event has been visited
-    const int DONE = 2;      // Mask for colour: event has been completed
-    const int EVTFWD = 4;    // Mask for colour: event is in rel.hb.fwd
-    const int AFTER_I = 8;   // Mask for colour: event is in EHB.after_I
-    const int AFTER_C = 16;  // Mask for colour: event is in EHB.after_C
-    clear_event_colour();
-    for(const IID<int> &iid : rel.hb.fwd){
-      get_evt(iid).colour = EVTFWD;
-    }
-    for(const IID<int> &iid : EHB.after_I){
-      get_evt(iid).colour |= AFTER_I;
-    }
-    for(const IID<int> &iid : EHB.after_C){
-      get_evt(iid).colour |= AFTER_C;
-    }
-#ifndef NDEBUG
-    int done_count = 0;
-#endif
-    std::vector<Event*> stack;
-    const std::function<bool(const IID<int>&)> enter =
-      [this,DONE,VISITED,&stack,&evt](const IID<int> &iid){
-      Event &e2 = this->get_evt(iid);
-      if(!e2.committed && &e2 != &evt) return true; // Don't insert
-      if(!(e2.colour & DONE) && (e2.colour & VISITED)) return false; // Cycle
-      stack.push_back(&e2);
-      return true;
-    };
+  void TB<MemMod,CB,Event>::index_events(Event *evt, std::vector<Event*> &events){
+    events.clear();
     for(unsigned proc = 0; proc < threads.size(); ++proc){
       for(int idx = 0; idx < threads[proc].fch_count; ++idx){
         Event &e = fch[proc][idx];
-        if(!e.committed && &e != &evt) continue;
-        if(!(e.colour & DONE)){
-          assert(!(e.colour & VISITED));
-          stack.push_back(&e);
-          while(stack.size()){
-            Event *e = stack.back();
-            if(e->colour & VISITED){
-              if(!(e->colour & DONE)){
-#ifndef NDEBUG
-                ++done_count;
-#endif
-                e->colour |= DONE;
-              }
-              stack.pop_back();
-            }else{
-              VecSet<IID<int> > *bwd;
-              if(e == &evt){
-                bwd = &rel.hb.bwd;
-              }else{
-                bwd = &e->rel.hb.bwd;
-              }
-              for(const IID<int> &iid : *bwd){
-                if(!enter(iid)) return false;
-              }
-              if(e->colour & AFTER_I){
-                for(const IID<int> &iid : EHB.I){
-                  if(!enter(iid)) return false;
-                }
-              }
-              if(e->colour & AFTER_C){
-                for(const IID<int> &iid : EHB.C){
-                  if(!enter(iid)) return false;
-                }
-              }
-              if(e->colour & EVTFWD){ // Can also reach evt backwards
-                if(!enter(evt.iid)) return false;
-              }
-              e->colour |= VISITED;
-            }
-          }
+        if(e.committed || &e == evt){
+          e.rel_idx = int(events.size());
+          events.push_back(&e);
         }else{
-          assert(e.colour & VISITED);
+          e.rel_idx = -1;
         }
       }
     }
-    assert(done_count == sched_count+1);
-    return true;
   }
 
   template<MemoryModel MemMod,CB_T CB,class Event>
-  bool TB<MemMod,CB,Event>::propagation(Event &new_evt, Relations &rel, ExtraRel &ER){
-    const int CO_NE = 1;       // co-before new_evt
-    const int PROP_NE = 2;     // prop-before new_evt
-    const int IN_ER_PROP = 4;  // ER.prop contains a forward prop edge from this event
-    const int CP_VISITED = 8;  // Has been visited
-    const int CP_DONE = 16;    // Visited, and all successors are done
-    clear_event_colour();
-    std::vector<Event*> stack;
-    const std::function<bool(Event*)> enter =
-      [&stack](Event *e){
-      if((e->colour & CP_VISITED) && !(e->colour & CP_DONE)){
-        return false;
+  void TB<MemMod,CB,Event>::add_to_bitrel(BitRel &R, Rel Relations::*r,
+                                          const std::vector<Event*> &events,
+                                          const Event *evt, const Relations *rel){
+    for(Event *e : events){
+      const Rel &er = (e == evt) ? rel->*r : e->rel.*r;
+      for(const IID<int> &iid : er.fwd){
+        const int j = get_evt(iid).rel_idx;
+        if(0 <= j) R.insert(e->rel_idx,j);
       }
-      stack.push_back(e);
-      return true;
-    };
-    enter(&new_evt);
-    for(auto pr : ER.prop){
-      Event &e = get_evt(pr.first);
-      e.colour |= IN_ER_PROP;
-      enter(&e);
-    }
-    for(const IID<int> &iid : rel.co.bwd) get_evt(iid).colour |= CO_NE;
-    for(const IID<int> &iid : rel.prop.bwd) get_evt(iid).colour |= PROP_NE;
-    while(stack.size()){
-      Event *e = stack.back();
-      if(e->colour & CP_VISITED){
-        e->colour |= CP_DONE;
-        stack.pop_back();
-      }else{
-        assert(!(e->colour & CP_DONE));
-        e->colour |= CP_VISITED;
-        /* Follow co */
-        const VecSet<IID<int> > &co = (e == &new_evt) ? rel.co.fwd : e->rel.co.fwd;
-        for(const IID<int> &iid : co){
-          if(!enter(&get_evt(iid))) return false;
-        }
-        if(e->colour & CO_NE){
-          if(!enter(&new_evt)) return false;
-        }
-        /* Follow prop */
-        const VecSet<IID<int> > &prop = (e == &new_evt) ? rel.prop.fwd : e->rel.prop.fwd;
-        for(const IID<int> &iid : prop){
-          if(!enter(&get_evt(iid))) return false;
-        }
-        auto it = ER.prop.find(e->iid);
-        if(it != ER.prop.end()){
-          for(const IID<int> &iid : it->second){
-            if(!enter(&get_evt(iid))) return false;
-          }
-        }
-        if(e->colour & PROP_NE){
-          if(!enter(&new_evt)) return false;
-        }
+      for(const IID<int> &iid : er.bwd){
+        const int j = get_evt(iid).rel_idx;
+        if(0 <= j) R.insert(j,e->rel_idx);
       }
     }
-    return true;
   }
 
   template<MemoryModel MemMod,CB_T CB,class Event>
-  bool TB<MemMod,CB,Event>::observation(Event &new_evt, Relations &rel, ExtraHB &EHB){
-    // TODO: Fix observation to make use of ExtraRel.
-
-    /* Masks for colour */
-    const int IN_I = 1;      // In EHB.I
-    const int IN_C = 2;      // In EHB.C
-    const int RFE_NE = 4;    // rfe-before new_evt
-    const int COM_NE = 8;    // com-before new_evt
-    const int HB_NE = 16;    // hb-before new_evt
-    const int FRE = 32;      // Reached from fre
-    const int RFE = 64;      // Reached from fre;rfe
-    const int COM = 128;     // Reached from fre;com*
-    const int HB = 256;      // Reached from fre;prop;hb*
-    const int HB_SYNC = 512; // Reached from fre;com*;prop-base* but has not passed a sync
-    VecSet<Event*> inits;
-    observation_find_inits(new_evt,rel,EHB,inits);
-
-    for(Event *R : inits){
-      VecSet<Event*> fre;
-      observation_get_fre(*R, new_evt, rel, fre);
-      if(fre.empty()) continue;
-      clear_event_colour();
-      for(const IID<int> &iid : EHB.I) get_evt(iid).colour |= IN_I;
-      for(const IID<int> &iid : EHB.C) get_evt(iid).colour |= IN_C;
-      for(const IID<int> &iid : rel.rf.bwd){
-        if(iid.get_pid() != new_evt.iid.get_pid()){
-          get_evt(iid).colour |= RFE_NE;
-        }
-      }
-      for(const IID<int> &iid : rel.com.bwd) get_evt(iid).colour |= COM_NE;
-      for(const IID<int> &iid : rel.hb.bwd) get_evt(iid).colour |= HB_NE;
-      for(Event *e : fre) e->colour |= (FRE | COM);
-      std::vector<Event*> stack(fre.begin(),fre.end());
-      const std::function<void(Event&,int)> stack_insert =
-        [&stack](Event &evt, int mask){
-        if((evt.colour | mask) != evt.colour){
-          evt.colour |= mask;
-          stack.push_back(&evt);
-        }
-      };
-      while(stack.size()){
-        Event *e = stack.back();
-        stack.pop_back();
-        if(e == R) return false;
-        if(e->colour & FRE){
-          /* Continue via rfe */
-          const VecSet<IID<int> > &rf = (e == &new_evt) ? rel.rf.fwd : e->rel.rf.fwd;
-          for(const IID<int> &iid : rf){
-            if(iid.get_pid() == e->iid.get_pid()) continue; // Not rfe
-            Event &rfe_e = get_evt(iid);
-            stack_insert(rfe_e,RFE);
-          }
-          if(e->colour & RFE_NE){ // (e,new_evt) in rfe
-            stack_insert(new_evt,RFE);
-          }
-        }
-        if(e->colour & COM){
-          /* Continue via com* */
-          const VecSet<IID<int> > &com = (e == &new_evt) ? rel.com.fwd : e->rel.com.fwd;
-          for(const IID<int> &iid : com){
-            Event &com_e = get_evt(iid);
-            if(!(com_e.colour & (COM | RFE))){
-              com_e.colour |= COM;
-              stack.push_back(&com_e);
-            }
-          }
-          if(e->colour & COM_NE){ // (e,new_evt) in com
-            if(!(new_evt.colour & (COM | RFE))){
-              new_evt.colour |= COM;
-              stack.push_back(&new_evt);
-            }
-          }
-        }
-        if(e->colour & (FRE | RFE | COM)){
-          /* Continue via fences */
-          const int proc = e->iid.get_pid();
-          const int fch_count = threads[proc].fch_count;
-          const int eieio_idx = (e->eieio_idx_after == -1) ? fch_count : e->eieio_idx_after;
-          const int lwsync_idx = (e->lwsync_idx_after == -1) ? fch_count : e->lwsync_idx_after;
-          const int sync_idx = (e->sync_idx_after == -1) ? fch_count : e->sync_idx_after;
-          const int fnc_store =
-            e->has_store ?
-            std::min(eieio_idx,std::min(lwsync_idx,sync_idx)) :
-            std::min(lwsync_idx,sync_idx);
-          const int fnc_load =
-            e->has_load ?
-            std::min(lwsync_idx,sync_idx) :
-            sync_idx;
-          const int fnc = std::min(fnc_store,fnc_load);
-          for(int i = fnc; i < fch_count; ++i){
-            Event &fnc_e = fch[proc][i];
-            if(!fnc_e.committed && &fnc_e != &new_evt) continue; // Not committed
-            if(fnc_e.colour & HB) continue; // Already inserted
-            if((fnc_e.has_load && fnc_load <= i) ||
-               (fnc_e.has_store && fnc_store <= i)){
-              /* (e,fnc_e) in fences */
-              int new_colour = fnc_e.colour;
-              if(sync_idx <= i || (e->colour & (FRE | RFE))){
-                new_colour |= (HB | HB_SYNC);
-              }else{
-                new_colour |= HB_SYNC;
-              }
-              if(new_colour != fnc_e.colour){
-                fnc_e.colour = new_colour;
-                stack.push_back(&fnc_e);
-              }
-            }
-          }
-        }
-        if(e->colour & (HB | HB_SYNC)){
-          /* Continue via hb */
-          const std::function<void(const IID<int>&)> add_hb =
-            [this,&stack,e,HB,HB_SYNC](const IID<int> &iid){
-            Event &hb_e = get_evt(iid);
-            int new_colour = hb_e.colour | (e->colour & (HB | HB_SYNC));
-            if(!(new_colour & HB) &&
-               (e->iid.get_pid() == hb_e.iid.get_pid()) &&
-               (e->sync_idx_after < hb_e.iid.get_index())){
-              /* (e,hb_e) in ffence */
-              new_colour |= HB;
-            }
-            if(new_colour != hb_e.colour){
-              hb_e.colour = new_colour;
-              stack.push_back(&hb_e);
-            }
-          };
-          const VecSet<IID<int> > &hb = (e == &new_evt) ? rel.hb.fwd : e->rel.hb.fwd;
-          for(const IID<int> &iid : hb){
-            add_hb(iid);
-          }
-          if(e->colour & IN_I){
-            for(const IID<int> &iid : EHB.after_I) add_hb(iid);
-            for(const IID<int> &iid : EHB.after_C) add_hb(iid);
-          }else if(e->colour & IN_C){
-            for(const IID<int> &iid : EHB.after_C) add_hb(iid);
-          }
-          if(e->colour & HB_NE){
-            add_hb(new_evt.iid);
-          }
+  void TB<MemMod,CB,Event>::add_to_bitrel(BitRel &R, const ExtraHB &EHB){
+    const std::function<void(const VecSet<IID<int> >&,const VecSet<IID<int> >&)> add =
+      [this,&R](const VecSet<IID<int> > &A, const VecSet<IID<int> > &B){
+      for(const IID<int> &a_iid : A){
+        const int a = this->get_evt(a_iid).rel_idx;
+        if(a < 0) continue;
+        for(const IID<int> &b_iid : B){
+          const int b = this->get_evt(b_iid).rel_idx;
+          if(0 <= b) R.insert(a,b);
         }
       }
-    }
+    };
+    add(EHB.I,EHB.after_I);
+    add(EHB.C,EHB.after_C);
+  }
 
-    return true;
+  template<MemoryModel MemMod,CB_T CB,class Event>
+  void TB<MemMod,CB,Event>::add_to_bitrel(BitRel &R, const ExtraRel &ER){
+    ER.prop.for_each([this,&R,&ER](int i, int j){
+        R.insert(this->get_evt(ER.prop_events[i]).rel_idx,
+                 this->get_evt(ER.prop_events[j]).rel_idx);
+      });
+  }
+
+  template<MemoryModel MemMod,CB_T CB,class Event>
+  bool TB<MemMod,CB,Event>::no_thin_air(Event &evt, Relations &rel, ExtraHB &EHB){
+    std::vector<Event*> events;
+    index_events(&evt,events);
+    assert(int(events.size()) == sched_count+1);
+    BitRel hb(events.size());
+    add_to_bitrel(hb,&Relations::hb,events,&evt,&rel);
+    add_to_bitrel(hb,EHB);
+    return hb.is_acyclic();
+  }
+
+  template<MemoryModel MemMod,CB_T CB,class Event>
+  bool TB<MemMod,CB,Event>::propagation(Event &new_evt, Relations &rel, ExtraRel &ER){
+    std::vector<Event*> events;
+    index_events(&new_evt,events);
+    BitRel co_prop(events.size());
+    add_to_bitrel(co_prop,&Relations::co,events,&new_evt,&rel);
+    add_to_bitrel(co_prop,&Relations::prop,events,&new_evt,&rel);
+    add_to_bitrel(co_prop,ER);
+    return co_prop.is_acyclic();
+  }
+
+  template<MemoryModel MemMod,CB_T CB,class Event>
+  bool TB<MemMod,CB,Event>::observation(Event &new_evt, Relations &rel, ExtraRel &ER){
+    std::vector<Event*> events;
+    index_events(&new_evt,events);
+    const int n = int(events.size());
+    BitRel fre(n);
+    bool has_fre = false;
+    for(Event *r : events){
+      if(!r->has_load) continue;
+      VecSet<Event*> r_fre;
+      observation_get_fre(*r,new_evt,rel,r_fre);
+      for(Event *w : r_fre){
+        fre.insert(r->rel_idx,w->rel_idx);
+        has_fre = true;
+      }
+    }
+    if(!has_fre) return true;
+    BitRel prop(n);
+    add_to_bitrel(prop,&Relations::prop,events,&new_evt,&rel);
+    add_to_bitrel(prop,ER);
+    const BitRel fre_prop = fre.compose(prop);
+    if(!fre_prop.is_irreflexive()) return false;
+    BitRel hb(n);
+    add_to_bitrel(hb,&Relations::hb,events,&new_evt,&rel);
+    add_to_bitrel(hb,ER.EHB);
+    hb.transitive_closure();
+    return fre_prop.compose(hb).is_irreflexive();
+  }
+
+  template<MemoryModel MemMod,CB_T CB,class Event>
+  bool TB<MemMod,CB,Event>::check_for_cycles(){
+    std::vector<Event*> events;
+    index_events(nullptr,events);
+    BitRel po_com(events.size());
+    /* The events of each thread are indexed in program order */
+    for(unsigned i = 1; i < events.size(); ++i){
+      if(events[i-1]->iid.get_pid() == events[i]->iid.get_pid()){
+        po_com.insert(i-1,i);
+      }
+    }
+    add_to_bitrel(po_com,&Relations::com,events);
+    return !po_com.is_acyclic();
   }
 
   template<MemoryModel MemMod,CB_T CB,class Event>
@@ -1978,112 +1788,6 @@ namespace PATB_impl{
     }
   }
 
-  /* Search forward from new_evt and EHB.after_I and EHB.after_C for
-   * load events.
-   */
-  template<MemoryModel MemMod,CB_T CB,class Event>
-  void TB<MemMod,CB,Event>::observation_find_inits(Event &new_evt, Relations &rel, ExtraHB &EHB,
-                                                   VecSet<Event*> &inits){
-    inits.clear();
-    /* Masks for colour */
-    const int COM = 1;
-    const int HB = 2;
-    const int IN_I = 4;
-    const int IN_C = 8;
-    /* First find all events from which we should search via hb:
-     * - EHB.after_I U EHB.after_C
-     * - new_evt
-     * - Every event e such that (new_evt,e) in com*;fences
-     */
-    VecSet<Event*> hb_inits;
-    for(const IID<int> &iid : EHB.after_I){
-      hb_inits.insert(&get_evt(iid));
-    }
-    for(const IID<int> &iid : EHB.after_C){
-      hb_inits.insert(&get_evt(iid));
-    }
-    hb_inits.insert(&new_evt);
-    clear_event_colour();
-    for(const IID<int> &iid : EHB.I){ get_evt(iid).colour |= IN_I; }
-    for(const IID<int> &iid : EHB.C){ get_evt(iid).colour |= IN_C; }
-    {
-      std::vector<Event*> stack;
-      stack.push_back(&new_evt);
-      std::vector<int> fnc_store(threads.size(),-1);
-      std::vector<int> fnc_load(threads.size(),-1);
-      const std::function<int(int,int)> fncmin =
-        [](int a, int b){
-        if(a == -1) return b;
-        if(b == -1) return a;
-        return std::min(a,b);
-      };
-      while(stack.size()){
-        Event *e = stack.back();
-        stack.pop_back();
-        /* Events reachable from e by fences */
-        const int proc = e->iid.get_pid();
-        fnc_store[proc] =
-          fncmin(fnc_store[proc],fncmin(e->lwsync_idx_after,e->sync_idx_after));
-        if(e->has_store) fnc_store[proc] = fncmin(fnc_store[proc],e->eieio_idx_after);
-        fnc_load[proc] = fncmin(fnc_load[proc],e->sync_idx_after);
-        if(e->has_load) fnc_load[proc] = fncmin(fnc_load[proc],e->lwsync_idx_after);
-        /* Events reachable from e by com */
-        const VecSet<IID<int> > &com =
-          (e == &new_evt) ? rel.com.fwd : e->rel.com.fwd;
-        for(const IID<int> &iid : com){
-          Event &e2 = get_evt(iid);
-          if(e2.colour & COM) continue;
-          e2.colour |= COM;
-          stack.push_back(&e2);
-        }
-      }
-      for(unsigned p = 0; p < threads.size(); ++p){
-        if(fnc_store[p] == -1 && fnc_load[p] == -1) continue;
-        const int fch_count = threads[p].fch_count;
-        const int fnc = fncmin(fnc_store[p],fnc_load[p]);
-        for(int i = fnc; i < fch_count; ++i){
-          if((fch[p][i].has_load && fnc_load[p] != -1 && fnc_load[p] <= i) ||
-             (fch[p][i].has_store && fnc_store[p] != -1 && fnc_store[p] <= i)){
-            hb_inits.insert(&fch[p][i]);
-          }
-        }
-      }
-    }
-    /* Next search for loads via hb from hb_inits */
-    std::function<std::string(Event * const &)> f =
-      [](Event * const &p){
-      return p->iid.to_string();
-    };
-    {
-      for(Event *p : hb_inits){ p->colour |= HB; }
-      std::vector<Event*> stack(hb_inits.begin(),hb_inits.end());
-      const std::function<void(const VecSet<IID<int> >&)> follow_hb =
-        [this,&stack,HB](const VecSet<IID<int> > &fwd){
-        for(const IID<int> &iid : fwd){
-          Event &e2 = this->get_evt(iid);
-          if(!(e2.colour & HB)){
-            e2.colour |= HB;
-            stack.push_back(&e2);
-          }
-        }
-      };
-      while(stack.size()){
-        Event *e = stack.back();
-        stack.pop_back();
-        if(e->has_load) inits.insert(e);
-        const VecSet<IID<int> > &hb =
-          (e == &new_evt) ? rel.hb.fwd : e->rel.hb.fwd;
-        follow_hb(hb);
-        if(e->colour & IN_I){
-          follow_hb(EHB.after_I);
-          follow_hb(EHB.after_C);
-        }else if(e->colour & IN_C){
-          follow_hb(EHB.after_C);
-        }
-      }
-    }
-  }
-
   template<MemoryModel MemMod,CB_T CB,class Event>
   void TB<MemMod,CB,Event>::debug_print() const{
     for(const IID<int> &iid : prefix){
@@ -2224,6 +1928,9 @@ namespace PATB_impl{
     }
     if(i < 0) return false; // Nothing more to explore.
 
+    /* The nodes from prefix[i] and onwards are not revisited. */
+    release_prefix_nodes(i);
+
     int new_pfx_len;
     Event &evt = get_evt(prefix[i]);
     if(evt.new_params.size()){ // New parameters that are already available
@@ -2338,4 +2045,84 @@ namespace PATB_impl{
     return true;
   }
 
+  template<MemoryModel MemMod,CB_T CB,class Event>
+  std::unique_ptr<POWERARMTraceBuilder> TB<MemMod,CB,Event>::split(){
+    assert(sched_count == 0);
+    if(!branch_registry) return nullptr;
+
+    /* Find the earliest event where a different parameter may be
+     * explored. The alternatives at that event are handed over to the
+     * new trace builder, since they are likely to make up the largest
+     * part of the remaining exploration.
+     */
+    int s;
+    for(s = 0; s < int(prefix.size()); ++s){
+      const Event &evt = get_evt(prefix[s]);
+      if(evt.new_params.size() || evt.new_branches.size()){
+        break;
+      }
+    }
+    if(s == int(prefix.size())) return nullptr; // Nothing to split off.
+
+    /* Fix the identities of the nodes shared by both trace builders. */
+    if(s > 0) get_prefix_node(s-1);
+
+    std::unique_ptr<TB> other(new TB(conf));
+    other->branch_registry = branch_registry;
+    other->prefix = prefix;
+    other->fch = fch;
+    other->prefix_node.assign(prefix_node.begin(),prefix_node.begin()+s);
+    for(uint64_t node : other->prefix_node){
+      branch_registry->hold(node);
+    }
+    for(int i = 0; i < int(prefix.size()); ++i){
+      Event &evt = (i == s) ? get_evt(prefix[i]) : other->get_evt(prefix[i]);
+      evt.new_params.clear();
+      evt.new_branches.clear();
+    }
+
+    /* Let other take its first alternative at s. Events that are not
+     * part of its new prefix would have been cleared by reset, had
+     * they been fetched in a computation of other.
+     */
+    bool other_has_work = other->reset();
+    assert(other_has_work);
+    (void)other_has_work;
+    VecSet<IID<int> > keep(other->prefix);
+    for(auto &fch_p : other->fch){
+      for(Event &evt : fch_p){
+        if(!keep.count(evt.iid)){
+          evt.filled_status = Event::STATUS_EMPTY;
+        }
+      }
+    }
+
+    return other;
+  }
+
+  template<MemoryModel MemMod,CB_T CB,class Event>
+  uint64_t TB<MemMod,CB,Event>::get_prefix_node(int i){
+    assert(branch_registry);
+    assert(i < int(prefix.size()));
+    while(int(prefix_node.size()) <= i){
+      prefix_node.push_back(branch_registry->new_node());
+    }
+    return prefix_node[i];
+  }
+
+  template<MemoryModel MemMod,CB_T CB,class Event>
+  void TB<MemMod,CB,Event>::release_prefix_nodes(int n){
+    while(int(prefix_node.size()) > n){
+      branch_registry->release(prefix_node.back());
+      prefix_node.pop_back();
+    }
+  }
+
+  template<MemoryModel MemMod,CB_T CB,class Event>
+  bool TB<MemMod,CB,Event>::register_branch(int bnc_start, const Branch &B){
+    if(!branch_registry) return true;
+    uint64_t node = (bnc_start == 0) ? 0 : get_prefix_node(bnc_start-1);
+    return branch_registry->insert(node,B);
+  }
+
 } // End namespace PATB_impl
@@ -17,10 +17,14 @@
  * <http://www.gnu.org/licenses/>.
  */
 
+#include "BitRel.h"
 #include "Debug.h"
 #include "POWERARMTraceBuilder.h"
 
 #include <cassert>
+#include <map>
+#include <mutex>
+#include <set>
 
 #ifndef __POWERARM_TRACE_BUILDER_H__
 #define __POWERARM_TRACE_BUILDER_H__
@@ -155,12 +159,15 @@ namespace PATB_impl{
   /* An ExtraRel object describes a set of extra edges in hb and
    * prop, which are not entered into the event structure.
    *
-   * The new edges are the hb edges in EHB and the prop edges (e,e')
-   * for all events e,e' such that e' in prop[e].
+   * The new edges are the hb edges in EHB and the prop edges
+   * (prop_events[i],prop_events[j]) for all (i,j) in prop.
+   *
+   * prop_events only contains the events of some extra prop edge.
    */
   struct ExtraRel{
     ExtraHB EHB;
-    std::map<IID<int>,VecSet<IID<int> > > prop;
+    std::vector<IID<int> > prop_events;
+    BitRel prop;
   };
 
   /* A Param represents one set of choices for one event: The parameter
@@ -489,6 +496,11 @@ namespace PATB_impl{
      * colouring algorithm.
      */
     int colour;
+    /* Temporary value used by the consistency checks: The index of
+     * this event in the BitRel relations of the check, or -1 if this
+     * event is not part of them. Assigned by TB::index_events.
+     */
+    int rel_idx;
 
     /* A one-line string representation of the parameter B for this
      * event.
@@ -655,14 +667,19 @@ namespace PATB_impl{
 
     virtual bool schedule(IID<int> *iid, std::vector<MBlock> *values);
 
-    virtual bool check_for_cycles(){
-      throw std::logic_error("POWERARMTraceBuilder::check_for_cycles: Not supported.");
-    };
+    /* Returns true iff po U com is cyclic over the committed events,
+     * i.e., iff the current computation is not sequentially
+     * consistent. Unlike the other trace builders, no error is
+     * reported, since robustness is not checked under POWER and ARM
+     * (see Configuration::check_commandline).
+     */
+    virtual bool check_for_cycles();
     virtual int spawn(int proc);
     virtual void abort();
     virtual Trace *get_trace() const;
     virtual bool reset();
     virtual void replay();
+    virtual std::unique_ptr<POWERARMTraceBuilder> split();
     virtual IID<CPid> get_iid() const;
     virtual bool sleepset_is_empty() const;
     virtual void debug_print() const;
@@ -781,6 +798,90 @@ namespace PATB_impl{
      */
     TraceRecorder TRec;
 
+    /* The branches that have been added to new_branches by any of the
+     * trace builders originating from the same trace builder through
+     * split. Each branch is paired with the node of the exploration
+     * tree from which it branches off (see prefix_node).
+     *
+     * Trace builders working on separate parts of the exploration
+     * share the nodes that were explored before they were split
+     * apart. Both may detect the same race at such a node. The
+     * registry makes sure that only one of them explores the
+     * corresponding branch.
+     *
+     * The registry also counts the trace builders holding each node
+     * in their prefix_node. A node which is held by no trace builder
+     * will never be visited again, so its branches are forgotten as
+     * soon as the last holder releases it. Hence the registry only
+     * keeps the branches of the nodes on the current prefixes of the
+     * live trace builders, and of the root.
+     */
+    class BranchRegistry{
+    public:
+      /* Returns a fresh node identifier, held by the caller. */
+      uint64_t new_node(){
+        std::lock_guard<std::mutex> lock(mutex);
+        uint64_t node = next_node++;
+        nodes[node].holders = 1;
+        return node;
+      };
+      /* Registers one more holder of node. */
+      void hold(uint64_t node){
+        std::lock_guard<std::mutex> lock(mutex);
+        assert(nodes.count(node));
+        ++nodes[node].holders;
+      };
+      /* Unregisters one holder of node. */
+      void release(uint64_t node){
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = nodes.find(node);
+        assert(it != nodes.end() && 0 < it->second.holders);
+        if(--it->second.holders == 0){
+          nodes.erase(it);
+        }
+      };
+      /* Registers B as branching off from node. Returns true iff B
+       * was not already registered for node.
+       */
+      bool insert(uint64_t node, const Branch &B){
+        std::lock_guard<std::mutex> lock(mutex);
+        return nodes[node].branches.insert(B).second;
+      };
+    private:
+      struct Node{
+        Node() : holders(0) {};
+        /* The number of trace builders holding this node. Always 0
+         * for the root, which is never released.
+         */
+        int holders;
+        std::set<Branch> branches;
+      };
+      uint64_t next_node = 1;
+      std::mutex mutex;
+      std::map<uint64_t,Node> nodes;
+    };
+    /* The registry shared with all trace builders originating from
+     * the same trace builder. nullptr unless conf.n_threads > 1.
+     */
+    std::shared_ptr<BranchRegistry> branch_registry;
+    /* prefix_node[i] identifies the node of the exploration tree
+     * which is reached by executing prefix[0..i] with their current
+     * parameters. Identifiers are assigned lazily by get_prefix_node,
+     * and only when branch_registry is in use. The node identifier 0
+     * denotes the root, where nothing has been executed.
+     */
+    std::vector<uint64_t> prefix_node;
+    uint64_t get_prefix_node(int i);
+    /* Releases the nodes prefix_node[n..] in branch_registry, and
+     * shrinks prefix_node to (at most) n elements.
+     */
+    void release_prefix_nodes(int n);
+    /* Returns true iff the branch B, starting at prefix[bnc_start],
+     * should be added to new_branches, i.e., iff no trace builder
+     * sharing branch_registry has added it before.
+     */
+    bool register_branch(int bnc_start, const Branch &B);
+
     int get_prefix_index(const IID<int> &iid){
       int i = int(prefix.size())-1;
       while(0 <= i && prefix[i] != iid) --i;
@@ -952,47 +1053,52 @@ namespace PATB_impl{
     void calc_prop(Event &evt, Relations &rel, ExtraRel &ER);
     /* Helper for calc_prop. */
     void calc_prop_inits(Event &evt, Relations &rel, ExtraHB &EHB, VecSet<Event*> &new_prop);
-    /* Searches the event structure for cycles in hb. Returns true iff
-     * hb is acyclic. The event structure which is considered is the
-     * one consisting of all currently committed events, and the hb
-     * edges in EHB, and also the event evt, assumed to have relations
-     * as given in rel.
-     */
-    bool no_thin_air(Event &evt, Relations &rel, ExtraHB &EHB);
-    /* Searches the event structure for cycles in co U prop. Returns
-     * true iff co U prop is acyclic. The event structure which is
-     * considered is the one consisting of all currently committed
-     * events, and the hb and prop edges in ER, and also the event
-     * evt, assumed to have relations as given in rel.
-     */
-    bool propagation(Event &evt, Relations &rel, ExtraRel &ER);
-    /* Searches the event structure for reflexivity in fre;prop;hb*.
-     * Returns true iff irreflexive(fre;prop;hb*). The event structure
-     * which is considered is the one consisting of all currently
-     * committed events, and the hb edges in EHB, and also the event
-     * evt, assumed to have relations as given in rel.
+    /* The consistency checks below consider the event structure
+     * consisting of all currently committed events, and also the
+     * event evt, assumed to have relations as given in rel. They
+     * build the relations they need over that event structure as
+     * BitRel objects, and check them with whole-row operations.
      *
-     * Pre: The OBSERVATION axiom holds for the event structure
-     * without evt and EHB.
+     * index_events assigns to events the events of the event
+     * structure in a fixed order, and sets the rel_idx field of every
+     * fetched event to its index in events, or to -1 if it is not in
+     * events. If evt is null, only the committed events are included.
+     */
+    void index_events(Event *evt, std::vector<Event*> &events);
+    /* Adds to R the edges of the relation r (e.g. &Relations::hb)
+     * between events in events, as recorded in the events
+     * themselves. The relations of evt, if non-null, are instead taken
+     * from *rel.
      *
-     * Pre: The SC PER LOCATION, NO THIN AIR and PROPAGATION axioms
-     * hold for the event structure including evt and EHB.
+     * Pre: events and the rel_idx fields have been set up by
+     * index_events.
      */
-    bool observation(Event &evt, Relations &rel, ExtraHB &EHB);
-    /* Helper for observation.
+    void add_to_bitrel(BitRel &R, Rel Relations::*r, const std::vector<Event*> &events,
+                       const Event *evt = nullptr, const Relations *rel = nullptr);
+    /* Adds to R the hb edges in EHB.
      *
-     * Assigns to inits a set of load events which is a superset of
-     * all loads e such that (e,e) in fre;prop;hb*, under the same
-     * assumptions as for the TB::observation method.
+     * Pre: As for add_to_bitrel above.
+     */
+    void add_to_bitrel(BitRel &R, const ExtraHB &EHB);
+    /* Adds to R the prop edges in ER.
      *
-     * Pre: The OBSERVATION axiom holds for the event structure
-     * without evt and EHB.
+     * Pre: As for add_to_bitrel above.
+     */
+    void add_to_bitrel(BitRel &R, const ExtraRel &ER);
+    /* Returns true iff hb is acyclic in the event structure extended
+     * with the hb edges in EHB.
+     */
+    bool no_thin_air(Event &evt, Relations &rel, ExtraHB &EHB);
+    /* Returns true iff co U prop is acyclic in the event structure
+     * extended with the hb and prop edges in ER.
+     */
+    bool propagation(Event &evt, Relations &rel, ExtraRel &ER);
+    /* Returns true iff irreflexive(fre;prop;hb*) in the event
+     * structure extended with the hb and prop edges in ER.
      *
-     * Pre: The SC PER LOCATION, NO THIN AIR and PROPAGATION axioms
-     * hold for the event structure including evt and EHB.
+     * Pre: rel.prop and ER.prop have been populated by calc_prop.
      */
-    void observation_find_inits(Event &evt, Relations &rel, ExtraHB &EHB,
-                                VecSet<Event*> &inits);
+    bool observation(Event &evt, Relations &rel, ExtraRel &ER);
     /* Helper for observation.
      *
      * Assigns to fre the set of stores w_evt such that (r_evt,w_evt)
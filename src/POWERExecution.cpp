@@ -3005,6 +3005,7 @@ void POWERInterpreter::run() {
     IID<int> iid;
     std::vector<MBlock> values;
     if(TB.schedule(&iid,&values)){
+      countEvent();
       CurrentThread = iid.get_pid();
       std::shared_ptr<FetchedInstruction> FI;
 #ifndef NDEBUG
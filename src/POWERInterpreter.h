@@ -290,6 +290,12 @@ public:
   }
   virtual void freeMachineCodeForFunction(llvm::Function *F) { }
 
+  /* Robustness is not checked under POWER and ARM (see
+   * Configuration::check_commandline), so a cycle is never reported
+   * as an error.
+   */
+  virtual bool checkForCycles() const { return TB.check_for_cycles(); };
+
   // Methods used to execute code:
   // Place a call on the stack
   void callFunction(llvm::Function *F, const std::vector<llvm::Value*> &ArgVals);
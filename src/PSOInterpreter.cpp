@@ -104,12 +104,12 @@ void PSOInterpreter::runAux(int proc, int aux){
 
   for(SymAddr b : ml){
     assert(pso_threads[proc].store_buffers.count(b));
-    std::vector<PendingStoreByte> &sb = pso_threads[proc].store_buffers[b];
+    RingBuffer<PendingStoreByte> &sb = pso_threads[proc].store_buffers[b];
     assert(sb.size());
     assert(sb.front().ml == ml);
     blk[unsigned(b-b0)] = sb.front().val;
     if(!DryRun) {
-      sb.erase(sb.begin());
+      sb.pop_front();
       if(sb.empty()) pso_threads[proc].store_buffers.erase(b);
     }
   }
@@ -23,6 +23,9 @@
 
 #include "Interpreter.h"
 #include "PSOTraceBuilder.h"
+#include "RingBuffer.h"
+
+#include <unordered_map>
 
 /* A PSOInterpreter is an interpreter running under the PSO
  * semantics. The execution should be guided by scheduling from a
@@ -92,7 +95,7 @@ protected:
      * in store_buffers[b] are ordered such that newer entries are
      * further to the back.
      */
-    std::map<SymAddr,std::vector<PendingStoreByte> > store_buffers;
+    std::unordered_map<SymAddr,RingBuffer<PendingStoreByte> > store_buffers;
     /* awaiting_buffer_flush indicates whether this thread is blocked
      * waiting for some store buffer to flush.
      */
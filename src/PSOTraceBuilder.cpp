@@ -515,11 +515,8 @@ void PSOTraceBuilder::atomic_store(const SymData &sd){
 
   if(is_update){ /* Remove pending store from buffer */
     for(SymAddr b : ml){
-      std::vector<PendingStoreByte> &sb = threads[tipid].store_buffers[b];
-      for(unsigned i = 0; i < sb.size() - 1; ++i){
-        sb[i] = sb[i+1];
-      }
-      sb.pop_back();
+      RingBuffer<PendingStoreByte> &sb = threads[tipid].store_buffers[b];
+      sb.pop_front();
       if(sb.empty()){
         threads[tipid].store_buffers.erase(b);
         mark_unavailable_ipid(uipid);
@@ -556,7 +553,7 @@ void PSOTraceBuilder::load(const SymAddrSize &ml){
   {
     auto it = threads[ipid].store_buffers.find(ml.addr);
     if(it != threads[ipid].store_buffers.end()){
-      std::vector<PendingStoreByte> &sb = it->second;
+      RingBuffer<PendingStoreByte> &sb = it->second;
       assert(sb.size());
       assert(sb.back().ml == ml);
       sb.back().last_rowe = prefix_idx;
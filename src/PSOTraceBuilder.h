@@ -21,6 +21,7 @@
 #ifndef __PSO_TRACE_BUILDER_H__
 #define __PSO_TRACE_BUILDER_H__
 
+#include "RingBuffer.h"
 #include "TSOPSOTraceBuilder.h"
 #include "VClock.h"
 
@@ -164,7 +165,7 @@ protected:
      * The store buffer is kept in the Thread object for the real
      * thread, not for the auxiliary.
      */
-    std::map<SymAddr,std::vector<PendingStoreByte> > store_buffers;
+    std::map<SymAddr,RingBuffer<PendingStoreByte> > store_buffers;
     /* For a non-auxiliary thread, aux_clock_sum is the sum of the
      * clocks of all auxiliary threads belonging to this thread.
      */
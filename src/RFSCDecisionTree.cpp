@@ -19,6 +19,7 @@
 
 #include "Debug.h"
 #include "RFSCDecisionTree.h"
+#include <algorithm>
 #include <numeric>
 
 std::shared_ptr<DecisionNode> RFSCDecisionTree::new_decision_node
@@ -33,9 +34,52 @@ std::shared_ptr<DecisionNode> RFSCDecisionTree::new_decision_node
 void RFSCDecisionTree::construct_sibling
 (const DecisionNode &decision,
  std::shared_ptr<RFSCUnfoldingTree::UnfoldingNode> unf, Leaf l) {
+  count_queued(decision.depth, 1);
   scheduler->enqueue(decision.make_sibling(std::move(unf), l));
 }
 
+std::vector<uint64_t> RFSCDecisionTree::queued_depth_profile() const {
+  std::vector<uint64_t> profile;
+  for (unsigned i = 0; i < queued_by_depth.size(); ++i) {
+    /* Dequeues may be counted before the matching enqueues */
+    int64_t count = queued_by_depth[i].load(std::memory_order_relaxed);
+    if (count > 0) {
+      profile.resize(i+1);
+      profile[i] = count;
+    }
+  }
+  return profile;
+}
+
+void RFSCTraceEstimator::add_sample
+(const std::vector<std::size_t> &branching_factors) {
+  std::lock_guard<std::mutex> lock(mutex);
+  std::size_t size = branching_factors.size() + 1;
+  if (trace_sums.size() < size) {
+    trace_sums.resize(size);
+    sample_counts.resize(size);
+  }
+  long double traces = 1;
+  for (std::size_t i = size; i-- > 0;) {
+    trace_sums[i] += traces;
+    ++sample_counts[i];
+    if (i > 0) traces *= branching_factors[i-1];
+  }
+}
+
+long double RFSCTraceEstimator::estimate
+(uint64_t explored, const std::vector<uint64_t> &queued_depth_profile) {
+  std::lock_guard<std::mutex> lock(mutex);
+  long double estimate = explored;
+  for (std::size_t i = 0; i < queued_depth_profile.size(); ++i) {
+    long double traces = 1;
+    if (i < sample_counts.size() && sample_counts[i])
+      traces = trace_sums[i] / sample_counts[i];
+    estimate += queued_depth_profile[i] * traces;
+  }
+  return estimate;
+}
+
 
 const std::shared_ptr<DecisionNode> &RFSCDecisionTree::find_ancestor
 (const std::shared_ptr<DecisionNode> &node, int wanted) {
@@ -51,6 +95,48 @@ const std::shared_ptr<DecisionNode> &RFSCDecisionTree::find_ancestor
 
 RFSCScheduler::~RFSCScheduler() = default;
 
+bool RFSCTaskBatch::run_one() {
+  unsigned i = next.fetch_add(1, std::memory_order_relaxed);
+  if (i >= size) return false;
+  job(i);
+  std::lock_guard<std::mutex> lock(mutex);
+  if (++done == size) cv.notify_all();
+  return true;
+}
+
+void RFSCTaskBatch::run_all() {
+  while (run_one()) {}
+  std::unique_lock<std::mutex> lock(mutex);
+  while (done != size) {
+    cv.wait(lock);
+  }
+}
+
+void RFSCScheduler::run_batch(unsigned size, std::function<void(unsigned)> job) {
+  auto batch = std::make_shared<RFSCTaskBatch>(size, std::move(job));
+  {
+    std::lock_guard<std::mutex> lock(batches_mutex);
+    batches.push_back(batch);
+    posted_batches.store(batches.size(), std::memory_order_release);
+  }
+  notify_idle();
+  batch->run_all();
+  {
+    std::lock_guard<std::mutex> lock(batches_mutex);
+    batches.erase(std::find(batches.begin(), batches.end(), batch));
+    posted_batches.store(batches.size(), std::memory_order_release);
+  }
+}
+
+std::shared_ptr<RFSCTaskBatch> RFSCScheduler::take_batch() {
+  if (posted_batches.load(std::memory_order_acquire) == 0) return nullptr;
+  std::lock_guard<std::mutex> lock(batches_mutex);
+  for (const std::shared_ptr<RFSCTaskBatch> &batch : batches) {
+    if (!batch->exhausted()) return batch;
+  }
+  return nullptr;
+}
+
 PriorityQueueScheduler::PriorityQueueScheduler() : RFSCScheduler() {}
 
 void PriorityQueueScheduler::enqueue(std::shared_ptr<DecisionNode> node) {
@@ -63,6 +149,12 @@ void PriorityQueueScheduler::enqueue(std::shared_ptr<DecisionNode> node) {
 std::shared_ptr<DecisionNode> PriorityQueueScheduler::dequeue() {
   std::unique_lock<std::mutex> lock(mutex);
   while (!halting && work_queue.empty()) {
+    if (std::shared_ptr<RFSCTaskBatch> batch = take_batch()) {
+      lock.unlock();
+      while (batch->run_one()) {}
+      lock.lock();
+      continue;
+    }
     cv.wait(lock);
   }
   if (halting) return nullptr;
@@ -77,6 +169,11 @@ void PriorityQueueScheduler::halt() {
   cv.notify_all();
 }
 
+void PriorityQueueScheduler::notify_idle() {
+  std::lock_guard<std::mutex> lock(mutex);
+  cv.notify_all();
+}
+
 thread_local int WorkstealingPQScheduler::thread_id = 0;
 WorkstealingPQScheduler::WorkstealingPQScheduler(unsigned num_threads)
   : work_queue(num_threads), halting(false) {}
@@ -121,6 +218,12 @@ std::shared_ptr<DecisionNode> WorkstealingPQScheduler::dequeue() {
         return work_queue[thread_id].pop();
       }
     }
+    if (std::shared_ptr<RFSCTaskBatch> batch = take_batch()) {
+      lock.unlock();
+      while (batch->run_one()) {}
+      lock.lock();
+      continue;
+    }
     cv.wait(lock);
   }
 }
@@ -131,6 +234,11 @@ void WorkstealingPQScheduler::halt() {
   cv.notify_all();
 }
 
+void WorkstealingPQScheduler::notify_idle() {
+  std::lock_guard<std::mutex> lock(mutex);
+  cv.notify_all();
+}
+
 std::shared_ptr<DecisionNode> WorkstealingPQScheduler::ThreadWorkQueue::pop() {
   assert(!empty());
   auto it = queue.end();
@@ -239,6 +347,17 @@ bool DecisionNode::is_pruned() {
 }
 
 
+std::vector<std::size_t> DecisionNode::branching_factors() {
+  std::vector<std::size_t> factors(depth+1);
+  for (DecisionNode *node = this; node->depth != -1;
+       node = node->parent.get()) {
+    std::lock_guard<std::mutex> lock(node->parent->decision_node_mutex);
+    factors[node->depth] = node->parent->children_unf_set.size();
+  }
+  return factors;
+}
+
+
 const std::shared_ptr<DecisionNode> &
 DecisionNode::get_ancestor(const DecisionNode * node, int wanted) {
   while (node->parent->depth != wanted) {
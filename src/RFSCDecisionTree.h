@@ -25,8 +25,12 @@
 #include "SaturatedGraph.h"
 #include "RFSCUnfoldingTree.h"
 
+#include <algorithm>
+#include <array>
 #include <unordered_set>
 #include <mutex>
+#include <condition_variable>
+#include <functional>
 #include <queue>
 #include <atomic>
 
@@ -109,6 +113,13 @@ public:
   /* True if node is part of a pruned subtree. */
   bool is_pruned();
 
+  /* Returns, for each depth 0..depth, the number of alternatives found
+   * so far at the decision of that depth on the path to this node,
+   * i.e., how many UnfoldingNodes the ancestor at that depth and its
+   * siblings have allocated.
+   */
+  std::vector<std::size_t> branching_factors();
+
 private:
 
   std::shared_ptr<DecisionNode> parent;
@@ -147,6 +158,34 @@ public:
   }
 };
 
+/* A batch of independent jobs [0,size) that a thread needs done before
+ * it can continue. Jobs are claimed in order, by the thread that posted
+ * the batch and by any idle threads that help it (see
+ * RFSCScheduler::run_batch).
+ */
+class RFSCTaskBatch {
+public:
+  RFSCTaskBatch(unsigned size, std::function<void(unsigned)> job)
+    : job(std::move(job)), size(size) {}
+  /* Claims and runs one job. Returns false if all jobs were already
+   * claimed. */
+  bool run_one();
+  /* Runs jobs until all have been claimed, then waits until all
+   * claimed jobs have completed. */
+  void run_all();
+  bool exhausted() const {
+    return next.load(std::memory_order_relaxed) >= size;
+  }
+private:
+  std::function<void(unsigned)> job;
+  unsigned size;
+  std::atomic<unsigned> next{0};
+  /* The number of completed jobs. Protected by mutex. */
+  unsigned done = 0;
+  std::mutex mutex;
+  std::condition_variable cv;
+};
+
 struct RFSCScheduler {
   virtual ~RFSCScheduler();
   virtual void enqueue(std::shared_ptr<DecisionNode> node) = 0;
@@ -154,6 +193,26 @@ struct RFSCScheduler {
   virtual void halt() = 0;
   virtual void register_thread(unsigned tid){}
   std::atomic<uint64_t> outstanding_jobs{0};
+
+  /* Runs the jobs job(0), ..., job(size-1), letting threads that are
+   * idle in dequeue() help with them. Returns when all jobs have
+   * completed. */
+  void run_batch(unsigned size, std::function<void(unsigned)> job);
+
+protected:
+  /* Returns a posted batch which has unclaimed jobs, or nullptr if
+   * there is none. Idle threads should run jobs from it (without
+   * holding any scheduler lock) before waiting for work. */
+  std::shared_ptr<RFSCTaskBatch> take_batch();
+  /* Wakes all threads that are idle in dequeue(), so that they notice a
+   * newly posted batch. */
+  virtual void notify_idle() = 0;
+
+private:
+  std::mutex batches_mutex;
+  std::vector<std::shared_ptr<RFSCTaskBatch>> batches;
+  /* The size of batches, readable without holding batches_mutex. */
+  std::atomic<unsigned> posted_batches{0};
 };
 
 class PriorityQueueScheduler final : public RFSCScheduler {
@@ -163,6 +222,8 @@ public:
   void enqueue(std::shared_ptr<DecisionNode> node) override;
   std::shared_ptr<DecisionNode> dequeue() override;
   void halt() override;
+protected:
+  void notify_idle() override;
 private:
   /* Exclusive access to the work_queue. */
   std::mutex mutex;
@@ -188,6 +249,9 @@ public:
     thread_id = id;
   }
 
+protected:
+  void notify_idle() override;
+
 private:
   class alignas(64) ThreadWorkQueue {
     std::map<int,std::deque<std::shared_ptr<DecisionNode>>> queue;
@@ -209,11 +273,39 @@ private:
   std::atomic<bool> halting;
 };
 
+/* Estimates the total number of traces of an RFSC exploration.
+ *
+ * Each sample is the branching factors along the decisions of an
+ * explored trace (see DecisionNode::branching_factors). As in Knuth's
+ * estimator, the product of the factors below depth d estimates the
+ * number of traces under a node of depth d. Combined with the depths
+ * of the nodes that remain in the work queue, this gives an estimate
+ * of the traces that are left. Samples may be added concurrently.
+ */
+class RFSCTraceEstimator {
+public:
+  void add_sample(const std::vector<std::size_t> &branching_factors);
+  /* Estimates the total number of traces, given that explored traces
+   * have been explored and the work queue has the given depth profile
+   * (see RFSCDecisionTree::queued_depth_profile).
+   */
+  long double estimate(uint64_t explored,
+                       const std::vector<uint64_t> &queued_depth_profile);
+private:
+  std::mutex mutex;
+  /* At index d+1: the sum over all samples of the product of the
+   * branching factors below depth d, and the number of samples that
+   * went as deep as d, respectively. */
+  std::vector<long double> trace_sums;
+  std::vector<uint64_t> sample_counts;
+};
+
 class RFSCDecisionTree final {
 public:
   RFSCDecisionTree(std::unique_ptr<RFSCScheduler> scheduler)
     : scheduler(std::move(scheduler)) {
     // Initiallize the work_queue with a "root"-node
+    count_queued(-1, 1);
     this->scheduler->enqueue(std::make_shared<DecisionNode>());
   };
 
@@ -223,7 +315,11 @@ public:
   void backtrack_decision_tree(std::shared_ptr<DecisionNode> *TB_work_item);
 
   /* Get a new prefix to execute from the scheduler */
-  std::shared_ptr<DecisionNode> get_next_work_task() { return scheduler->dequeue(); }
+  std::shared_ptr<DecisionNode> get_next_work_task() {
+    std::shared_ptr<DecisionNode> node = scheduler->dequeue();
+    if (node) count_queued(node->depth, -1);
+    return node;
+  }
 
   /* Constructs an empty Decision node. */
   std::shared_ptr<DecisionNode> new_decision_node
@@ -241,8 +337,22 @@ public:
 
   RFSCScheduler &get_scheduler() { return *scheduler; }
 
+  /* Returns the number of nodes in the work queue at each depth d, at
+   * index d+1. The counts are not a consistent snapshot, and are only
+   * intended for progress estimation.
+   */
+  std::vector<uint64_t> queued_depth_profile() const;
+
 private:
   std::unique_ptr<RFSCScheduler> scheduler;
+
+  /* Nodes deeper than max_profile_depth are counted at the last index */
+  static constexpr int max_profile_depth = 1022;
+  std::array<std::atomic<uint64_t>,max_profile_depth+2> queued_by_depth{};
+  void count_queued(int depth, int64_t delta) {
+    int index = std::min(depth, max_profile_depth) + 1;
+    queued_by_depth[index].fetch_add(delta, std::memory_order_relaxed);
+  }
 };
 
 
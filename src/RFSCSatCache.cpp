@@ -0,0 +1,94 @@
+/* Copyright (C) 2026 agent
+ *
+ * This file is part of Nidhugg.
+ *
+ * Nidhugg is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nidhugg is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include "RFSCSatCache.h"
+
+#include <boost/functional/hash.hpp>
+
+RFSCSatCache::RFSCSatCache(uint64_t capacity)
+  : capacity(capacity), shards(new Shard[shard_count]) {}
+
+std::size_t RFSCSatCache::KeyHash::operator()(const Key &key) const {
+  return boost::hash_range(key.begin(), key.end());
+}
+
+RFSCSatCache::Shard &RFSCSatCache::get_shard(const Key &key) {
+  /* Use the high bits, since the low bits select the bucket */
+  return shards[(KeyHash()(key) >> 32) % shard_count];
+}
+
+uint64_t RFSCSatCache::entry_size(const Key &key, const Answer &answer) {
+  /* A rough estimate of the allocator overhead of the nodes of the
+   * map and the list, and of the vectors.
+   */
+  const uint64_t overhead = 128;
+  return overhead + key.size() * sizeof(uint64_t)
+    + (answer ? answer->size() * sizeof(unsigned) : 0);
+}
+
+bool RFSCSatCache::lookup(const Key &key, Answer &answer) {
+  if (!enabled()) return false;
+  Shard &shard = get_shard(key);
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.map.find(key);
+    if (it != shard.map.end()) {
+      answer = it->second.answer;
+      shard.lru.splice(shard.lru.begin(), shard.lru, it->second.pos);
+      hits.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  misses.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
+
+void RFSCSatCache::insert(Key key, Answer answer) {
+  if (!enabled()) return;
+  Shard &shard = get_shard(key);
+  uint64_t shard_capacity = capacity / shard_count;
+  uint64_t size = entry_size(key, answer);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto it = shard.map.find(key);
+  if (it != shard.map.end()) {
+    shard.bytes -= entry_size(it->first, it->second.answer);
+    shard.lru.erase(it->second.pos);
+    shard.map.erase(it);
+  }
+  if (size > shard_capacity) return;
+  while (shard.bytes + size > shard_capacity) {
+    auto victim = shard.map.find(*shard.lru.back());
+    shard.bytes -= entry_size(victim->first, victim->second.answer);
+    shard.lru.pop_back();
+    shard.map.erase(victim);
+  }
+  it = shard.map.emplace(std::move(key), Entry{std::move(answer), {}}).first;
+  shard.lru.push_front(&it->first);
+  it->second.pos = shard.lru.begin();
+  shard.bytes += size;
+}
+
+uint64_t RFSCSatCache::size() {
+  uint64_t bytes = 0;
+  for (unsigned i = 0; i < shard_count; ++i) {
+    std::lock_guard<std::mutex> lock(shards[i].mutex);
+    bytes += shards[i].bytes;
+  }
+  return bytes;
+}
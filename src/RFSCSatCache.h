@@ -0,0 +1,105 @@
+/* Copyright (C) 2026 agent
+ *
+ * This file is part of Nidhugg.
+ *
+ * Nidhugg is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nidhugg is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#ifndef __RFSC_SAT_CACHE_H__
+#define __RFSC_SAT_CACHE_H__
+
+#include "Option.h"
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/* A bounded cache of the answers to satisfiability queries of RFSC,
+ * shared by all threads exploring the same program.
+ *
+ * A key is a canonical encoding of the constraint set of a query (see
+ * RFSCTraceBuilder::sat_cache_key), so that equal keys have equal
+ * answers. The answer is either UNSAT, represented by nullptr, or an
+ * order of the events of the query that satisfies the constraints.
+ */
+class RFSCSatCache final {
+public:
+  typedef std::vector<uint64_t> Key;
+  typedef Option<std::vector<unsigned>> Answer;
+
+  /* A cache using at most about capacity bytes. Keys and answers grow
+   * with the number of events of a query, so the cache is bounded by
+   * their size rather than by their number. A cache with capacity 0
+   * is disabled; it never stores anything.
+   */
+  RFSCSatCache(uint64_t capacity);
+
+  bool enabled() const { return capacity != 0; }
+
+  /* If key has been inserted (and not yet evicted), stores its answer
+   * in answer and returns true. Otherwise returns false.
+   */
+  bool lookup(const Key &key, Answer &answer);
+  /* Inserts key with the given answer. If the cache is full, the least
+   * recently used entries are evicted to make room. An entry that is
+   * too large for the cache is not inserted.
+   */
+  void insert(Key key, Answer answer);
+
+  /* The estimated number of bytes used by the entries of the cache. */
+  uint64_t size();
+
+  /* The number of successful and failed lookups. */
+  std::atomic<uint64_t> hits{0}, misses{0};
+
+private:
+  struct KeyHash {
+    std::size_t operator()(const Key &key) const;
+  };
+  struct Entry {
+    Answer answer;
+    /* The position of the key in Shard::lru */
+    std::list<const Key*>::iterator pos;
+  };
+  /* The cache is split into shards by hash, to reduce lock contention
+   * between threads. Each shard is bounded by its part of capacity.
+   */
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_map<Key,Entry,KeyHash> map;
+    /* The keys of map, most recently used first. The elements point
+     * into map, whose nodes are never moved.
+     */
+    std::list<const Key*> lru;
+    /* The estimated number of bytes used by the entries of map */
+    uint64_t bytes = 0;
+  };
+  static constexpr unsigned shard_count = 16;
+  Shard &get_shard(const Key &key);
+  /* The estimated number of bytes used by an entry of the cache,
+   * including the nodes of Shard::map and Shard::lru.
+   */
+  static uint64_t entry_size(const Key &key, const Answer &answer);
+
+  uint64_t capacity;
+  std::unique_ptr<Shard[]> shards;
+};
+
+#endif
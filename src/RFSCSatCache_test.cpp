@@ -0,0 +1,136 @@
+/* Copyright (C) 2026 agent
+ *
+ * This file is part of Nidhugg.
+ *
+ * Nidhugg is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nidhugg is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#ifdef HAVE_BOOST_UNIT_TEST_FRAMEWORK
+#include <boost/test/unit_test.hpp>
+
+#include "RFSCSatCache.h"
+
+#include <atomic>
+#include <thread>
+
+BOOST_AUTO_TEST_SUITE(RFSCSatCache_test)
+
+BOOST_AUTO_TEST_CASE(Lookup){
+  RFSCSatCache cache(1 << 20);
+  RFSCSatCache::Answer a;
+  BOOST_CHECK(!cache.lookup({1,2,3}, a));
+  cache.insert({1,2,3}, std::vector<unsigned>{2,0,1});
+  cache.insert({1,2}, nullptr);
+  BOOST_CHECK(cache.lookup({1,2,3}, a));
+  BOOST_CHECK(a && *a == std::vector<unsigned>({2,0,1}));
+  BOOST_CHECK(cache.lookup({1,2}, a));
+  BOOST_CHECK(!a);
+  BOOST_CHECK(!cache.lookup({1,2,4}, a));
+  BOOST_CHECK_EQUAL(cache.hits, 2);
+  BOOST_CHECK_EQUAL(cache.misses, 2);
+}
+
+BOOST_AUTO_TEST_CASE(Disabled){
+  RFSCSatCache cache(0);
+  RFSCSatCache::Answer a;
+  BOOST_CHECK(!cache.enabled());
+  cache.insert({1}, nullptr);
+  BOOST_CHECK(!cache.lookup({1}, a));
+  BOOST_CHECK_EQUAL(cache.hits, 0);
+}
+
+BOOST_AUTO_TEST_CASE(Bounded){
+  /* Large keys and answers, as for queries with many events */
+  const uint64_t capacity = 1 << 20;
+  RFSCSatCache cache(capacity);
+  for (uint64_t i = 0; i < 1000; ++i) {
+    RFSCSatCache::Key key(1000, i);
+    cache.insert(key, std::vector<unsigned>(1000, unsigned(i)));
+    BOOST_CHECK(cache.size() <= capacity);
+  }
+  unsigned found = 0;
+  for (uint64_t i = 0; i < 1000; ++i) {
+    RFSCSatCache::Answer a;
+    if (cache.lookup(RFSCSatCache::Key(1000, i), a)) {
+      ++found;
+      BOOST_CHECK(a && *a == std::vector<unsigned>(1000, unsigned(i)));
+    }
+  }
+  BOOST_CHECK(found > 0);
+  /* Each entry uses at least 12000 bytes */
+  BOOST_CHECK(found <= capacity / 12000);
+}
+
+BOOST_AUTO_TEST_CASE(Recently_used_survives){
+  RFSCSatCache cache(1 << 16);
+  cache.insert({1000000}, nullptr);
+  for (uint64_t i = 0; i < 10000; ++i) {
+    RFSCSatCache::Answer a;
+    BOOST_CHECK(cache.lookup({1000000}, a));
+    cache.insert({i}, std::vector<unsigned>{unsigned(i)});
+  }
+  BOOST_CHECK(cache.size() <= 1 << 16);
+  RFSCSatCache::Answer a;
+  BOOST_CHECK(cache.lookup({1000000}, a));
+  BOOST_CHECK(!a);
+}
+
+BOOST_AUTO_TEST_CASE(Too_large){
+  RFSCSatCache cache(1 << 16);
+  cache.insert({1}, nullptr);
+  cache.insert(RFSCSatCache::Key(1 << 16, 2), nullptr);
+  RFSCSatCache::Answer a;
+  BOOST_CHECK(!cache.lookup(RFSCSatCache::Key(1 << 16, 2), a));
+  BOOST_CHECK(cache.lookup({1}, a));
+}
+
+BOOST_AUTO_TEST_CASE(Replace){
+  RFSCSatCache cache(1 << 16);
+  cache.insert({1}, std::vector<unsigned>(100, 1));
+  uint64_t size = cache.size();
+  cache.insert({1}, nullptr);
+  BOOST_CHECK(cache.size() < size);
+  RFSCSatCache::Answer a;
+  BOOST_CHECK(cache.lookup({1}, a));
+  BOOST_CHECK(!a);
+}
+
+BOOST_AUTO_TEST_CASE(Concurrent){
+  RFSCSatCache cache(1 << 14);
+  /* Boost.Test assertions are not thread safe */
+  std::atomic<unsigned> wrong_answers(0);
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < 4; ++t) {
+    threads.emplace_back([&cache,&wrong_answers]() {
+        for (uint64_t i = 0; i < 2000; ++i) {
+          RFSCSatCache::Answer a;
+          if (cache.lookup({i % 300}, a)) {
+            if (!a || (*a)[0] != i % 300) ++wrong_answers;
+          } else {
+            cache.insert({i % 300}, std::vector<unsigned>{unsigned(i % 300)});
+          }
+        }
+      });
+  }
+  for (std::thread &t : threads) t.join();
+  BOOST_CHECK_EQUAL(wrong_answers, 0);
+  BOOST_CHECK_EQUAL(cache.hits + cache.misses, 4*2000);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
@@ -43,12 +43,15 @@ static Timing::Context try_read_from_context("try_read_from");
 static Timing::Context ponder_mutex_context("ponder_mutex");
 static Timing::Context graph_context("graph");
 static Timing::Context sat_context("sat");
+static Timing::Context schedule_context("schedule");
 
 RFSCTraceBuilder::RFSCTraceBuilder(RFSCDecisionTree &desicion_tree_,
                                    RFSCUnfoldingTree &unfolding_tree_,
+                                   RFSCSatCache &sat_cache_,
                                    const Configuration &conf)
     : TSOPSOTraceBuilder(conf),
       unfolding_tree(unfolding_tree_),
+      sat_cache(sat_cache_),
       decision_tree(desicion_tree_) {
     threads.push_back(Thread(CPid(), -1));
     prefix_idx = -1;
@@ -223,11 +226,15 @@ Trace *RFSCTraceBuilder::get_trace() const{
 
 bool RFSCTraceBuilder::reset(){
 
-  work_item = decision_tree.get_next_work_task();
-
-  while (work_item != nullptr && work_item->is_pruned()) {
-    tasks_created--;
+  {
+    /* Includes waiting for work when exploring in parallel */
+    Timing::Guard timing_guard(schedule_context);
     work_item = decision_tree.get_next_work_task();
+
+    while (work_item != nullptr && work_item->is_pruned()) {
+      tasks_created--;
+      work_item = decision_tree.get_next_work_task();
+    }
   }
 
   if (work_item == nullptr) {
@@ -1175,6 +1182,31 @@ void RFSCTraceBuilder::compute_prefixes() {
   //   pair.second.push_back(-1);
   // }
 
+  /* When exploring in parallel, candidates are not decided as they are
+   * found, but collected and decided in batches that idle threads can
+   * help with. Debug printing is interleaved with the candidates, so
+   * we decide them immediately when it is enabled.
+   */
+  const bool defer_siblings = conf.n_threads > 1 && !conf.debug_print_on_reset;
+  const std::size_t max_pending = 4 * conf.n_threads;
+  std::vector<PendingSibling> pending;
+  auto try_sibling = [&](DecisionNode &decision,
+                         std::shared_ptr<RFSCUnfoldingTree::UnfoldingNode> unf,
+                         std::initializer_list<unsigned> changed) {
+      if (!defer_siblings) {
+        Leaf solution = try_sat(changed);
+        if (!solution.is_bottom()) {
+          decision_tree.construct_sibling(decision, std::move(unf),
+                                          std::move(solution));
+          tasks_created++;
+        }
+        return;
+      }
+      pending.push_back({&decision, std::move(unf), make_sat_query(changed),
+                         Leaf()});
+      if (pending.size() >= max_pending) decide_siblings(pending);
+    };
+
   for (unsigned i = 0; i < prefix.size(); ++i) {
     auto try_swap = [&](int i, int j) {
         int original_read_from = *prefix[i].read_from;
@@ -1192,12 +1224,8 @@ void RFSCTraceBuilder::compute_prefixes() {
         prefix[j].read_from = original_read_from;
         prefix[i].decision_swap(prefix[j]);
 
-        Leaf solution = try_sat({unsigned(j)}, writes_by_address);
-        if (!solution.is_bottom()) {
-          decision_tree.construct_sibling(decision, std::move(alt),
-                                          std::move(solution));
-          tasks_created++;
-        }
+        try_sibling(decision, std::move(alt), {unsigned(j)});
+
         /* Reset read-from and decision */
         prefix[j].read_from = i;
         prefix[i].decision_swap(prefix[j]);
@@ -1218,12 +1246,8 @@ void RFSCTraceBuilder::compute_prefixes() {
         prefix[j].read_from = original_read_from;
         prefix[i].decision_swap(prefix[j]);
 
-        Leaf solution = try_sat({unsigned(j)}, writes_by_address);
-        if (!solution.is_bottom()) {
-          decision_tree.construct_sibling(decision, std::move(alt),
-                                          std::move(solution));
-          tasks_created++;
-        }
+        try_sibling(decision, std::move(alt), {unsigned(j)});
+
         /* Reset read-from and decision */
         prefix[j].read_from = unlock;
         prefix[i].decision_swap(prefix[j]);
@@ -1253,12 +1277,7 @@ void RFSCTraceBuilder::compute_prefixes() {
           assert(!prefix[i].pinned);
           prefix[i].pinned = true;
 
-          Leaf solution = try_sat({unsigned(j)}, writes_by_address);
-          if (!solution.is_bottom()) {
-            decision_tree.construct_sibling(decision, std::move(alt),
-                                            std::move(solution));
-            tasks_created++;
-          }
+          try_sibling(decision, std::move(alt), {unsigned(j)});
 
           /* Reset decision */
           prefix[i].decision_swap(prefix[j]);
@@ -1326,12 +1345,7 @@ void RFSCTraceBuilder::compute_prefixes() {
         auto undoj = recompute_cmpxhg_success(j, possible_writes);
         auto undoi = recompute_cmpxhg_success(i, possible_writes);
 
-        Leaf solution = try_sat({unsigned(j), i}, writes_by_address);
-        if (!solution.is_bottom()) {
-          decision_tree.construct_sibling(decision, std::move(read_from),
-                                          std::move(solution));
-          tasks_created++;
-        }
+        try_sibling(decision, std::move(read_from), {unsigned(j), i});
 
         /* Reset read-from */
         prefix[j].read_from = i;
@@ -1357,11 +1371,7 @@ void RFSCTraceBuilder::compute_prefixes() {
           prefix[i].read_from = j;
           auto undoi = recompute_cmpxhg_success(i, possible_writes);
 
-          Leaf solution = try_sat({i}, writes_by_address);
-          if (!solution.is_bottom()) {
-            decision_tree.construct_sibling(decision, read_from, std::move(solution));
-            tasks_created++;
-          }
+          try_sibling(decision, read_from, {i});
 
           undo_cmpxhg_recomputation(undoi, possible_writes);
         }
@@ -1407,66 +1417,88 @@ void RFSCTraceBuilder::compute_prefixes() {
       prefix[i].read_from = original_read_from;
     }
   }
+
+  if (!pending.empty()) decide_siblings(pending);
 }
 
-void RFSCTraceBuilder::output_formula
-(SatSolver &sat,
- std::map<SymAddr,std::vector<int>> &writes_by_address,
- const std::vector<bool> &keep){
-  unsigned no_keep = 0;
-  std::vector<unsigned> var;
-  for (unsigned i = 0; i < prefix.size(); ++i) {
-    var.push_back(no_keep);
-    if (keep[i]) no_keep++;
+void RFSCTraceBuilder::decide_siblings(std::vector<PendingSibling> &pending) {
+  if (pending.size() == 1) {
+    pending[0].solution = solve_sat_query(pending[0].query);
+  } else {
+    decision_tree.get_scheduler().run_batch
+      (pending.size(), [this,&pending](unsigned k) {
+        pending[k].solution = solve_sat_query(pending[k].query);
+      });
+  }
+  for (PendingSibling &p : pending) {
+    if (!p.solution.is_bottom()) {
+      decision_tree.construct_sibling(*p.decision, std::move(p.unf),
+                                      std::move(p.solution));
+      tasks_created++;
+    }
+  }
+  pending.clear();
+}
+
+template<typename T, typename F> auto map(const std::vector<T> &vec, F f)
+  -> std::vector<typename std::result_of<F(const T&)>::type> {
+  std::vector<typename std::result_of<F(const T&)>::type> ret;
+  ret.reserve(vec.size());
+  for (const T &e : vec) ret.emplace_back(f(e));
+  return ret;
+}
+
+void RFSCTraceBuilder::output_formula(SatSolver &sat, const SatQuery &q){
+  const std::vector<SatQuery::Event> &events = q.events;
+  sat.alloc_variables(events.size());
+
+  std::map<SymAddr,std::vector<unsigned>> writes_by_address;
+  for (unsigned i = 0; i < events.size(); ++i) {
+    if (events[i].kind == SaturatedGraph::STORE
+        || events[i].kind == SaturatedGraph::RMW) {
+      writes_by_address[events[i].addr].push_back(i);
+    }
   }
 
-  sat.alloc_variables(no_keep);
   /* PO */
-  for (unsigned i = 0; i < prefix.size(); ++i) {
-    if (!keep[i]) continue;
-    if (Option<unsigned> pred = po_predecessor(i)) {
-      assert(*pred != i);
-      sat.add_edge(var[*pred], var[i]);
+  std::vector<int> last_of_thread;
+  for (unsigned i = 0; i < events.size(); ++i) {
+    unsigned pid = events[i].iid.get_pid();
+    if (last_of_thread.size() <= pid) last_of_thread.resize(pid+1, -1);
+    if (last_of_thread[pid] != -1) {
+      sat.add_edge(last_of_thread[pid], i);
     }
+    last_of_thread[pid] = i;
   }
 
   /* Read-from and SC consistency */
-  for (unsigned r = 0; r < prefix.size(); ++r) {
-    if (!keep[r] || !prefix[r].read_from) continue;
-    int w = *prefix[r].read_from;
+  for (unsigned r = 0; r < events.size(); ++r) {
+    if (!events[r].read_from) continue;
+    int w = *events[r].read_from;
     assert(int(r) != w);
+    const std::vector<unsigned> &writes = writes_by_address[events[r].addr];
     if (w == -1) {
-      for (int j : writes_by_address[get_addr(r).addr]) {
-        if (j == int(r) || !keep[j]) continue;
-        sat.add_edge(var[r], var[j]);
+      for (unsigned j : writes) {
+        if (j == r) continue;
+        sat.add_edge(r, j);
       }
     } else {
-      sat.add_edge(var[w], var[r]);
-      for (int j : writes_by_address[get_addr(r).addr]) {
-        if (j == w || j == int(r) || !keep[j]) continue;
-        sat.add_edge_disj(var[j], var[w],
-                          var[r], var[j]);
+      sat.add_edge(w, r);
+      for (unsigned j : writes) {
+        if (int(j) == w || j == r) continue;
+        sat.add_edge_disj(j, w, r, j);
       }
     }
   }
 
   /* Other happens-after edges (such as thread spawn and join) */
-  for (unsigned i = 0; i < prefix.size(); ++i) {
-    if (!keep[i]) continue;
-    for (unsigned j : prefix[i].happens_after) {
-      sat.add_edge(var[j], var[i]);
+  for (unsigned i = 0; i < events.size(); ++i) {
+    for (unsigned j : events[i].happens_after) {
+      sat.add_edge(j, i);
     }
   }
 }
 
-template<typename T, typename F> auto map(const std::vector<T> &vec, F f)
-  -> std::vector<typename std::result_of<F(const T&)>::type> {
-  std::vector<typename std::result_of<F(const T&)>::type> ret;
-  ret.reserve(vec.size());
-  for (const T &e : vec) ret.emplace_back(f(e));
-  return ret;
-}
-
 void RFSCTraceBuilder::add_event_to_graph(SaturatedGraph &g, unsigned i) const {
   SaturatedGraph::EventKind kind = SaturatedGraph::NONE;
   SymAddr addr;
@@ -1484,6 +1516,17 @@ void RFSCTraceBuilder::add_event_to_graph(SaturatedGraph &g, unsigned i) const {
                              [this](unsigned j){return prefix[j].iid;}));
 }
 
+void RFSCTraceBuilder::add_event_to_graph
+(SaturatedGraph &g, const SatQuery &q, unsigned i) {
+  const SatQuery::Event &e = q.events[i];
+  Option<IID<IPid>> read_from;
+  if (e.read_from && *e.read_from != -1)
+    read_from = q.events[*e.read_from].iid;
+  g.add_event(e.iid.get_pid(), e.iid, e.kind, e.addr,
+              read_from, map(e.happens_after,
+                             [&q](unsigned j){return q.events[j].iid;}));
+}
+
 const SaturatedGraph &RFSCTraceBuilder::get_cached_graph
 (DecisionNode &decision) {
   const int depth = decision.depth;
@@ -1501,33 +1544,121 @@ const SaturatedGraph &RFSCTraceBuilder::get_cached_graph
     });
 }
 
-Leaf
-RFSCTraceBuilder::try_sat
-(std::initializer_list<unsigned> changed_events,
- std::map<SymAddr,std::vector<int>> &writes_by_address){
-  Timing::Guard timing_guard(graph_context);
+RFSCTraceBuilder::SatQuery RFSCTraceBuilder::make_sat_query
+(std::initializer_list<unsigned> changed_events){
   unsigned last_change = changed_events.end()[-1];
   DecisionNode &decision = *prefix[last_change].decision_ptr;
   int decision_depth = decision.depth;
   std::vector<bool> keep = causal_past(decision_depth);
 
-  SaturatedGraph g(get_cached_graph(decision).clone());
+  SatQuery q;
+  q.graph = &get_cached_graph(decision);
+  std::vector<int> index(prefix.size(), -1);
+  for (unsigned i = 0; i < prefix.size(); ++i) {
+    if (keep[i]) index[i] = q.events.size(), q.events.emplace_back();
+  }
   for (unsigned i = 0; i < prefix.size(); ++i) {
-    if (keep[i] && i != last_change && !g.has_event(prefix[i].iid)) {
-      add_event_to_graph(g, i);
+    if (!keep[i]) continue;
+    SatQuery::Event &e = q.events[index[i]];
+    e.iid = prefix[i].iid;
+    e.kind = SaturatedGraph::NONE;
+    if (is_load(i)) {
+      if (is_store(i)) e.kind = SaturatedGraph::RMW;
+      else e.kind = SaturatedGraph::LOAD;
+    } else if (is_store(i)) e.kind = SaturatedGraph::STORE;
+    if (e.kind != SaturatedGraph::NONE) e.addr = get_addr(i).addr;
+    if (prefix[i].read_from) {
+      int w = *prefix[i].read_from;
+      assert(w == -1 || index[w] != -1);
+      e.read_from = w == -1 ? -1 : index[w];
+    }
+    e.happens_after = map(prefix[i].happens_after, [&index](unsigned j) {
+        assert(index[j] != -1);
+        return unsigned(index[j]);
+      });
+
+    bool is_changed = std::any_of(changed_events.begin(), changed_events.end(),
+                                  [i](unsigned c) { return c == i; });
+    bool new_pinned = prefix[i].pinned;
+    int new_decision = prefix[i].get_decision_depth();
+    if (new_decision > decision_depth) {
+      new_pinned = true;
+      new_decision = -1;
+    }
+    e.branch = Branch(prefix[i].iid.get_pid(),
+                      is_changed ? 1 : prefix[i].size,
+                      new_decision,
+                      new_pinned,
+                      prefix[i].sym);
+  }
+  q.last_change = index[last_change];
+  q.current_exec = map(prefix, [](const Event &e) { return e.iid; });
+  return q;
+}
+
+Leaf
+RFSCTraceBuilder::solve_sat_query(const SatQuery &q) const{
+  RFSCSatCache::Key key;
+  RFSCSatCache::Answer order;
+  if (sat_cache.enabled()) key = sat_cache_key(q);
+  if (sat_cache.enabled() && sat_cache.lookup(key, order)) {
+    if (conf.debug_print_on_reset)
+      llvm::dbgs() << ": Cached " << (order ? "SAT" : "UNSAT") << "\n";
+  } else {
+    order = decide_sat_query(q);
+    if (sat_cache.enabled()) sat_cache.insert(std::move(key), order);
+  }
+  if (!order) return Leaf();
+  return order_to_leaf(q, *order);
+}
+
+RFSCSatCache::Key RFSCTraceBuilder::sat_cache_key(const SatQuery &q) {
+  /* The answer is determined by the events of q and their read-from
+   * and happens-after edges; q.graph only contains a subset of those
+   * events, and the branches only affect how an answer is turned into
+   * a Leaf. Indices are fixed by the order of the events, so equal
+   * keys also agree on the meaning of an answer.
+   */
+  RFSCSatCache::Key key;
+  key.reserve(q.events.size() * 3 + 1);
+  key.push_back(q.events.size());
+  for (const SatQuery::Event &e : q.events) {
+    key.push_back(uint64_t(uint32_t(e.iid.get_pid())) << 32
+                  | uint32_t(e.iid.get_index()));
+    /* 0 means not a load, 1 means reading from init */
+    uint64_t read_from = e.read_from ? uint64_t(*e.read_from + 2) : 0;
+    key.push_back(uint64_t(e.kind) << 56
+                  | uint64_t(e.happens_after.size()) << 32
+                  | uint32_t(read_from));
+    /* The hash of a SymAddr is injective */
+    key.push_back(e.kind == SaturatedGraph::NONE
+                  ? 0 : std::hash<SymAddr>()(e.addr));
+    key.insert(key.end(), e.happens_after.begin(), e.happens_after.end());
+  }
+  return key;
+}
+
+Option<std::vector<unsigned>>
+RFSCTraceBuilder::decide_sat_query(const SatQuery &q) const{
+  Timing::Guard timing_guard(graph_context);
+
+  SaturatedGraph g(q.graph->clone());
+  for (unsigned i = 0; i < q.events.size(); ++i) {
+    if (i != q.last_change && !g.has_event(q.events[i].iid)) {
+      add_event_to_graph(g, q, i);
     }
   }
-  add_event_to_graph(g, last_change);
+  add_event_to_graph(g, q, q.last_change);
   if (!g.saturate()) {
     if (conf.debug_print_on_reset)
       llvm::dbgs() << ": Saturation yielded cycle\n";
-    return Leaf();
+    if (conf.sat_portfolio) ++portfolio_stats.saturation;
+    return nullptr;
   }
-  std::vector<IID<int>> current_exec
-    = map(prefix, [](const Event &e) { return e.iid; });
+  if (conf.sat_portfolio) return solve_portfolio(q, std::move(g));
   /* We need to preserve g */
   if (Option<std::vector<IID<int>>> res
-      = try_generate_prefix(std::move(g), std::move(current_exec))) {
+      = try_generate_prefix(std::move(g), q.current_exec)) {
     if (conf.debug_print_on_reset) {
       llvm::dbgs() << ": Heuristic found prefix\n";
       llvm::dbgs() << "[";
@@ -1536,72 +1667,140 @@ RFSCTraceBuilder::try_sat
       }
       llvm::dbgs() << "]\n";
     }
-    std::vector<unsigned> order = map(*res, [this](IID<int> iid) {
-        return find_process_event(iid.get_pid(), iid.get_index());
-      });
-    return order_to_leaf(decision_depth, changed_events, std::move(order));
+    return prefix_to_order(q, *res);
   }
 
   assert(false && "Tried sat");
 
   std::unique_ptr<SatSolver> sat = conf.get_sat_solver();
+  Option<std::vector<unsigned>> order = solve_with_solver(*sat, q);
+  ++solver_stats.calls;
+  ++(order ? solver_stats.sat : solver_stats.unsat);
+  if (!order) {
+    if (conf.debug_print_on_reset) llvm::dbgs() << ": UNSAT\n";
+    return nullptr;
+  }
+  if (conf.debug_print_on_reset) {
+    llvm::dbgs() << ": SAT\n";
+    print_order(q, *order);
+  }
+  return order;
+}
+
+Option<std::vector<unsigned>>
+RFSCTraceBuilder::solve_portfolio(const SatQuery &q, SaturatedGraph g) const {
+  enum { NONE, HEURISTIC, SOLVER } winner = NONE;
+  /* Empty if the winner found q unsatisfiable */
+  Option<std::vector<unsigned>> order;
+  /* Protects the above, and solver */
+  std::mutex mutex;
+  /* The solver currently deciding q, if any */
+  SatSolver *solver = nullptr;
+
+  /* The heuristic is job 0, so that it is run first if nobody helps */
+  decision_tree.get_scheduler().run_batch
+    (2, [&](unsigned job) {
+      if (job == 0) {
+        Option<std::vector<IID<int>>> res
+          = try_generate_prefix(std::move(g), q.current_exec);
+        /* A failing heuristic does not mean that q is unsatisfiable */
+        if (!res) return;
+        std::vector<unsigned> res_order = prefix_to_order(q, *res);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (winner != NONE) return;
+        winner = HEURISTIC;
+        order = std::move(res_order);
+        if (solver) solver->interrupt();
+      } else {
+        /* Creating a solver may be costly (e.g. start a process), so
+         * do not if the heuristic has already won. */
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          if (winner != NONE) return;
+        }
+        std::unique_ptr<SatSolver> sat = conf.get_sat_solver();
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          if (winner != NONE) return;
+          solver = sat.get();
+        }
+        Option<std::vector<unsigned>> res_order = solve_with_solver(*sat, q);
+        ++solver_stats.calls;
+        std::lock_guard<std::mutex> lock(mutex);
+        solver = nullptr;
+        if (winner != NONE) {
+          ++solver_stats.interrupted;
+          return;
+        }
+        ++(res_order ? solver_stats.sat : solver_stats.unsat);
+        winner = SOLVER;
+        order = std::move(res_order);
+      }
+    });
+
+  switch (winner) {
+  case HEURISTIC:
+    ++portfolio_stats.heuristic;
+    if (conf.debug_print_on_reset) llvm::dbgs() << ": Heuristic won\n";
+    break;
+  case SOLVER:
+    ++portfolio_stats.solver;
+    if (conf.debug_print_on_reset)
+      llvm::dbgs() << ": Solver won, " << (order ? "SAT" : "UNSAT") << "\n";
+    break;
+  case NONE:
+    abort();
+  }
+  if (conf.debug_print_on_reset && order) print_order(q, *order);
+  return order;
+}
+
+Option<std::vector<unsigned>>
+RFSCTraceBuilder::solve_with_solver(SatSolver &sat, const SatQuery &q) {
   {
     Timing::Guard timing_guard(sat_context);
 
-    output_formula(*sat, writes_by_address, keep);
-    //output_formula(std::cerr, writes_by_address, keep);
-
-    if (!sat->check_sat()) {
-      if (conf.debug_print_on_reset) llvm::dbgs() << ": UNSAT\n";
-      return Leaf();
-    }
-    if (conf.debug_print_on_reset) llvm::dbgs() << ": SAT\n";
+    output_formula(sat, q);
 
+    if (!sat.check_sat()) return nullptr;
   }
-  std::vector<unsigned> model = sat->get_model();
+  std::vector<unsigned> model = sat.get_model();
 
-  unsigned no_keep = 0;
-  for (unsigned i = 0; i < prefix.size(); ++i) {
-    if (keep[i]) no_keep++;
-  }
-  std::vector<unsigned> order(no_keep);
-  for (unsigned i = 0, var = 0; i < prefix.size(); ++i) {
-    if (keep[i]) {
-      unsigned pos = model[var++];
-      order[pos] = i;
-    }
+  std::vector<unsigned> order(q.events.size());
+  for (unsigned var = 0; var < q.events.size(); ++var) {
+    unsigned pos = model[var];
+    order[pos] = var;
   }
+  return order;
+}
 
-  if (conf.debug_print_on_reset) {
-    llvm::dbgs() << "[";
-    for (unsigned i : order) {
-      llvm::dbgs() << i << ",";
-    }
-    llvm::dbgs() << "]\n";
+void RFSCTraceBuilder::print_order
+(const SatQuery &q, const std::vector<unsigned> &order) const {
+  llvm::dbgs() << "[";
+  for (unsigned i : order) {
+    llvm::dbgs() << iid_string(q.events[i].iid) << ",";
   }
+  llvm::dbgs() << "]\n";
+}
 
-  return order_to_leaf(decision_depth, changed_events, std::move(order));
+std::vector<unsigned> RFSCTraceBuilder::prefix_to_order
+(const SatQuery &q, const std::vector<IID<int>> &prefix) {
+  std::unordered_map<IID<IPid>,unsigned> index;
+  for (unsigned i = 0; i < q.events.size(); ++i) {
+    index.emplace(q.events[i].iid, i);
+  }
+  return map(prefix, [&index](IID<int> iid) {
+      assert(index.count(iid));
+      return index.at(iid);
+    });
 }
 
 Leaf RFSCTraceBuilder::order_to_leaf
-(int decision, std::initializer_list<unsigned> changed,
- const std::vector<unsigned> order) const{
+(const SatQuery &q, const std::vector<unsigned> &order){
   std::vector<Branch> new_prefix;
   new_prefix.reserve(order.size());
   for (unsigned i : order) {
-    bool is_changed = std::any_of(changed.begin(), changed.end(),
-                                  [i](unsigned c) { return c == i; });
-    bool new_pinned = prefix[i].pinned || (prefix[i].get_decision_depth() > decision);
-    int new_decision = prefix[i].get_decision_depth();
-    if (new_decision > decision) {
-      new_pinned = true;
-      new_decision = -1;
-    }
-    new_prefix.emplace_back(prefix[i].iid.get_pid(),
-                            is_changed ? 1 : prefix[i].size,
-                            new_decision,
-                            new_pinned,
-                            prefix[i].sym);
+    new_prefix.push_back(q.events[i].branch);
   }
 
   return Leaf(new_prefix);
@@ -1682,23 +1881,24 @@ inline unsigned RFSCTraceBuilder::find_process_event(IPid pid, int index) const{
 }
 
 long double RFSCTraceBuilder::estimate_trace_count() const{
-  return estimate_trace_count(0);
-}
-
-bool RFSCTraceBuilder::check_for_cycles() {
-  return false;
+  /* Knuth's estimator: the product of the branching factors along the
+   * path through the decision tree. */
+  long double count = 1;
+  for (std::size_t factor : branching_factors()) count *= factor;
+  return count;
 }
 
-long double RFSCTraceBuilder::estimate_trace_count(int idx) const{
-  if(idx > int(prefix.size())) return 0;
-  if(idx == int(prefix.size())) return 1;
-
-  long double count = 42;
-  for(int i = int(prefix.size())-1; idx <= i; --i){
-    count += prefix[i].sleep_branch_trace_count;
-    // count += std::max(0, int(prefix.children_after(i)))
-    //   * (count / (1 + prefix[i].sleep.size()));
+std::vector<std::size_t> RFSCTraceBuilder::branching_factors() const{
+  const Event *deepest = nullptr;
+  for (const Event &e : prefix) {
+    if (e.decision_ptr && (!deepest || e.get_decision_depth()
+                           > deepest->get_decision_depth()))
+      deepest = &e;
   }
+  if (!deepest) return {};
+  return deepest->decision_ptr->branching_factors();
+}
 
-  return count;
+bool RFSCTraceBuilder::check_for_cycles() {
+  return false;
 }
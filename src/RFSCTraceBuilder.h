@@ -29,7 +29,9 @@
 #include "SaturatedGraph.h"
 #include "RFSCUnfoldingTree.h"
 #include "RFSCDecisionTree.h"
+#include "RFSCSatCache.h"
 
+#include <atomic>
 #include <unordered_map>
 #include <unordered_set>
 #include <boost/container/flat_map.hpp>
@@ -39,6 +41,7 @@ class RFSCTraceBuilder final : public TSOPSOTraceBuilder{
 public:
   RFSCTraceBuilder(RFSCDecisionTree &desicion_tree_,
                    RFSCUnfoldingTree &unfolding_tree_,
+                   RFSCSatCache &sat_cache_,
                    const Configuration &conf = Configuration::default_conf);
   virtual ~RFSCTraceBuilder();
   virtual bool schedule(int *proc, int *aux, int *alt, bool *dryrun);
@@ -81,10 +84,34 @@ public:
   virtual int cond_destroy(const SymAddrSize &ml);
   virtual void register_alternatives(int alt_count);
   virtual long double estimate_trace_count() const;
+  /* The branching factors (see DecisionNode::branching_factors) along
+   * the deepest decision of the current trace. Only valid after
+   * compute_prefixes.
+   */
+  std::vector<std::size_t> branching_factors() const;
 
   /* Amount of siblings found during compute_prefixes. */
   int tasks_created;
 
+  /* With conf.sat_portfolio, the number of candidate siblings that
+   * were decided by saturation alone, by the prefix heuristic, and by
+   * the SAT solver, respectively. Updated by any thread that helps
+   * deciding siblings.
+   */
+  struct PortfolioStats {
+    std::atomic<uint64_t> saturation{0}, heuristic{0}, solver{0};
+  };
+  mutable PortfolioStats portfolio_stats;
+  /* The number of calls to the SAT solver, and of those, the number
+   * that found the query satisfiable and unsatisfiable. With
+   * conf.sat_portfolio, interrupted counts the calls that finished
+   * after the prefix heuristic had already decided the query.
+   */
+  struct SolverStats {
+    std::atomic<uint64_t> calls{0}, sat{0}, unsat{0}, interrupted{0};
+  };
+  mutable SolverStats solver_stats;
+
   /* Active work item, signifies the leaf of an exploration.*/
   std::shared_ptr<DecisionNode> work_item;
 
@@ -143,6 +170,7 @@ protected:
   };
 
   RFSCUnfoldingTree &unfolding_tree;
+  RFSCSatCache &sat_cache;
 
   /* The threads in the current execution, in the order they were
    * created. Threads on even indexes are real, threads on odd indexes
@@ -458,19 +486,79 @@ protected:
   /* Records a symbolic representation of the current event.
    */
   void record_symbolic(SymEv event);
-  Leaf try_sat(std::initializer_list<unsigned>, std::map<SymAddr,std::vector<int>> &);
-  Leaf order_to_leaf(int decision, std::initializer_list<unsigned> changed,
-                     const std::vector<unsigned> order) const;
-  void output_formula(SatSolver &sat,
-                      std::map<SymAddr,std::vector<int>> &,
-                      const std::vector<bool> &);
+  /* A SatQuery is a snapshot of the causal past of a candidate
+   * sibling, taken while prefix is modified to describe the
+   * candidate. Deciding it (solve_sat_query) does not access prefix,
+   * so several queries may be decided concurrently.
+   */
+  struct SatQuery {
+    struct Event {
+      IID<IPid> iid;
+      SaturatedGraph::EventKind kind;
+      SymAddr addr;
+      /* Index into events of the event read from, -1 if reading from
+       * init, or empty if this is not a load.
+       */
+      Option<int> read_from;
+      /* Indices into events of the events that happen before this one
+       * (see Event::happens_after).
+       */
+      std::vector<unsigned> happens_after;
+      /* How this event is to be replayed in the new prefix. */
+      Branch branch;
+    };
+    /* The events of the causal past, in prefix order. */
+    std::vector<Event> events;
+    /* Index into events of the last changed event. */
+    unsigned last_change;
+    /* The cached saturated graph of the decision. */
+    const SaturatedGraph *graph;
+    /* The iids of all events in prefix, in order. */
+    std::vector<IID<IPid>> current_exec;
+  };
+  /* A candidate sibling whose satisfiability has not yet been decided. */
+  struct PendingSibling {
+    DecisionNode *decision;
+    std::shared_ptr<RFSCUnfoldingTree::UnfoldingNode> unf;
+    SatQuery query;
+    Leaf solution;
+  };
+  SatQuery make_sat_query(std::initializer_list<unsigned> changed);
+  /* Decides query, using sat_cache if possible. */
+  Leaf solve_sat_query(const SatQuery &query) const;
+  /* Returns an order of the events of query that satisfies it, or
+   * nullptr if query is unsatisfiable.
+   */
+  Option<std::vector<unsigned>> decide_sat_query(const SatQuery &query) const;
+  static RFSCSatCache::Key sat_cache_key(const SatQuery &query);
+  Leaf try_sat(std::initializer_list<unsigned> changed) {
+    return solve_sat_query(make_sat_query(changed));
+  }
+  /* Decides all of pending, concurrently with any idle threads, and
+   * constructs the satisfiable siblings in the order of pending.
+   */
+  void decide_siblings(std::vector<PendingSibling> &pending);
+  /* Races try_generate_prefix on the saturated graph g against the
+   * SAT solver, the latter run by an idle thread if there is one.
+   */
+  Option<std::vector<unsigned>>
+  solve_portfolio(const SatQuery &query, SaturatedGraph g) const;
+  /* Returns the event order of a model of the formula of query, or
+   * nullptr if there is none (or sat was interrupted).
+   */
+  static Option<std::vector<unsigned>>
+  solve_with_solver(SatSolver &sat, const SatQuery &query);
+  void print_order(const SatQuery &query,
+                   const std::vector<unsigned> &order) const;
+  static std::vector<unsigned>
+  prefix_to_order(const SatQuery &query, const std::vector<IID<int>> &prefix);
+  static Leaf order_to_leaf(const SatQuery &query,
+                            const std::vector<unsigned> &order);
+  static void output_formula(SatSolver &sat, const SatQuery &query);
+  static void add_event_to_graph(SaturatedGraph &g, const SatQuery &query,
+                                 unsigned i);
   std::vector<bool> causal_past(int decision) const;
   void causal_past_1(std::vector<bool> &acc, unsigned i) const;
-  /* Estimate the total number of traces that have the same prefix as
-   * the current one, up to the first idx events.
-   */
-  long double estimate_trace_count(int idx) const;
-
   bool is_load(unsigned idx) const;
   bool is_store(unsigned idx) const;
   bool is_store_when_reading_from(unsigned idx, int read_from) const;
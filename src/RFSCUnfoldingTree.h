@@ -21,6 +21,7 @@
 #ifndef __RFSC_UNFOLDING_TREE_H__
 #define __RFSC_UNFOLDING_TREE_H__
 
+#include <unordered_map>
 #include <unordered_set>
 #include <mutex>
 #include <shared_mutex>
@@ -76,7 +77,7 @@ public:
 
   UnfoldingRoot &get_unfolding_root(const CPid &cpid);
 
-  std::map<CPid,UnfoldingRoot> first_events;
+  std::unordered_map<CPid,UnfoldingRoot> first_events;
   std::shared_timed_mutex unfolding_tree_mutex;
 
 };
@@ -0,0 +1,107 @@
+/* Copyright (C) 2026 agent
+ *
+ * This file is part of Nidhugg.
+ *
+ * Nidhugg is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nidhugg is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#ifndef __RING_BUFFER_H__
+#define __RING_BUFFER_H__
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/* A RingBuffer is a FIFO queue with random access, stored in a
+ * circular array. push_back is amortised constant time, and
+ * pop_front is constant time (unlike erasing the first element of a
+ * std::vector).
+ *
+ * Elements are indexed from the front: (*this)[0] is the oldest
+ * element and (*this)[size()-1] the newest.
+ *
+ * T need not be default constructible. The slot of a popped element
+ * keeps its (moved-into) value until the slot is reused by a later
+ * push_back, or until clear() is called.
+ */
+template<typename T>
+class RingBuffer{
+public:
+  RingBuffer() : head(0), sz(0) {};
+  std::size_t size() const { return sz; };
+  bool empty() const { return sz == 0; };
+  const T &operator[](std::size_t i) const {
+    assert(i < sz);
+    return slots[slot(i)];
+  };
+  T &operator[](std::size_t i) {
+    assert(i < sz);
+    return slots[slot(i)];
+  };
+  const T &front() const { return (*this)[0]; };
+  T &front() { return (*this)[0]; };
+  const T &back() const { return (*this)[sz-1]; };
+  T &back() { return (*this)[sz-1]; };
+  /* Appends t as the newest element. */
+  void push_back(T t){
+    if(sz < slots.size()){
+      slots[slot(sz)] = std::move(t);
+    }else{
+      /* Full: Straighten the array so that the new slot can be
+       * appended at its end.
+       */
+      std::rotate(slots.begin(),slots.begin()+head,slots.end());
+      head = 0;
+      slots.push_back(std::move(t));
+    }
+    ++sz;
+  };
+  /* Removes the oldest element.
+   *
+   * Pre: !empty()
+   */
+  void pop_front(){
+    assert(sz);
+    head = slot(1);
+    if(--sz == 0) head = 0;
+  };
+  /* Removes all elements, and releases the popped values that are
+   * still held in their slots.
+   */
+  void clear(){
+    slots.clear();
+    head = sz = 0;
+  };
+private:
+  /* The slots of the circular array. Its capacity grows as that of a
+   * std::vector.
+   */
+  std::vector<T> slots;
+  /* The slot of the front element. */
+  std::size_t head;
+  /* The number of elements. */
+  std::size_t sz;
+  /* The slot of element i. */
+  std::size_t slot(std::size_t i) const {
+    i += head;
+    return i < slots.size() ? i : i - slots.size();
+  };
+};
+
+#endif
@@ -30,6 +30,11 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
 BOOST_AUTO_TEST_SUITE(SC_test)
 
 BOOST_AUTO_TEST_CASE(fib_simple_n2_sc){
@@ -2716,6 +2721,207 @@ BOOST_AUTO_TEST_CASE(Atexit_multithreaded){
     << "WARNING: Missing support for multithreaded atexit.\n";
 }
 
+namespace {
+  /* A module with two racing stores, and thus two traces, explored
+   * under SC. */
+  struct TwoStores {
+    TwoStores() : conf(DPORDriver_test::get_sc_conf()) {
+      module = StrModule::portasm(R"(
+@x = global i32 0, align 4
+
+define i8* @p(i8* %arg){
+  store i32 1, i32* @x, align 4
+  ret i8* null
+}
+
+define i32 @main(){
+  call i32 @pthread_create(i64* null, %attr_t* null, i8*(i8*)* @p, i8* null)
+  store i32 2, i32* @x, align 4
+  ret i32 0
+}
+
+%attr_t = type { i64, [48 x i8] }
+declare i32 @pthread_create(i64*, %attr_t*, i8*(i8*)*, i8*) nounwind
+)");
+    }
+    Configuration conf;
+    std::string module;
+  };
+}
+
+BOOST_FIXTURE_TEST_CASE(Stats_json, TwoStores){
+  conf.stats_json = "SC_test_Stats_json.json";
+  DPORDriver *driver = DPORDriver::parseIR(module, conf);
+  DPORDriver::Result res = driver->run();
+  delete driver;
+  BOOST_CHECK(!res.has_errors());
+  BOOST_CHECK(res.trace_count == 2);
+
+  std::stringstream ss;
+  {
+    std::ifstream in(conf.stats_json);
+    BOOST_REQUIRE(in);
+    ss << in.rdbuf();
+  }
+  std::remove(conf.stats_json.c_str());
+  std::string doc = ss.str();
+  BOOST_CHECK(doc.find("\"final\": true") != std::string::npos);
+  BOOST_CHECK(doc.find("\"traces\": {\"count\": 2,") != std::string::npos);
+  BOOST_CHECK(doc.find("\"events\": {\"count\": 0,") == std::string::npos);
+  BOOST_CHECK(doc.find("\"peak_rss_kb\"") != std::string::npos);
+}
+
+namespace {
+  /* Records the executions passed to it, and stops the exploration
+   * after max_count executions. */
+  class CountingSink : public DPORDriver::TraceSink {
+  public:
+    CountingSink(bool traces, uint64_t max_count)
+      : traces(traces), max_count(max_count) {}
+    bool wants_traces() const override { return traces; }
+    bool consume(uint64_t index, Kind kind, const Trace *trace) override {
+      indices.push_back(index);
+      if(kind == COMPLETE) ++complete;
+      if(trace) ++with_trace;
+      return indices.size() < max_count;
+    }
+    bool traces;
+    uint64_t max_count;
+    std::vector<uint64_t> indices;
+    int complete = 0;
+    int with_trace = 0;
+  };
+}
+
+BOOST_FIXTURE_TEST_CASE(Trace_sink, TwoStores){
+  DPORDriver *driver = DPORDriver::parseIR(module, conf);
+  CountingSink sink(true, 100);
+  DPORDriver::Result res = driver->run(&sink);
+  delete driver;
+  BOOST_CHECK(!res.has_errors());
+  BOOST_CHECK(res.trace_count == 2);
+  BOOST_CHECK(res.all_traces.empty());
+  BOOST_CHECK(sink.indices == std::vector<uint64_t>({0,1}));
+  BOOST_CHECK_EQUAL(sink.complete, 2);
+  BOOST_CHECK_EQUAL(sink.with_trace, 2);
+}
+
+BOOST_FIXTURE_TEST_CASE(Trace_sink_no_traces, TwoStores){
+  DPORDriver *driver = DPORDriver::parseIR(module, conf);
+  CountingSink sink(false, 100);
+  DPORDriver::Result res = driver->run(&sink);
+  delete driver;
+  BOOST_CHECK(res.trace_count == 2);
+  BOOST_CHECK_EQUAL(sink.indices.size(), 2);
+  BOOST_CHECK_EQUAL(sink.with_trace, 0);
+}
+
+BOOST_FIXTURE_TEST_CASE(Trace_sink_stop, TwoStores){
+  DPORDriver *driver = DPORDriver::parseIR(module, conf);
+  CountingSink sink(false, 1);
+  DPORDriver::Result res = driver->run(&sink);
+  delete driver;
+  BOOST_CHECK(res.trace_count == 1);
+  BOOST_CHECK_EQUAL(sink.indices.size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(Many_executions_one_module){
+  /* Each worker keeps one module for all its executions. Every
+   * execution must still start with the initial values of the global
+   * variables: main fails if @guard has been written by an earlier
+   * execution. Thread @w writes @x0, ..., @x10, and thread @r reads
+   * them in the same order. Each read may see either the initial
+   * value or the write, independently, giving 2^11 = 2048 traces.
+   */
+  const int k = 11;
+  std::string globals, writes, reads;
+  for(int j = 0; j < k; ++j){
+    std::string x = "@x" + std::to_string(j);
+    globals += x + " = global i32 0, align 4\n";
+    writes += "  store i32 1, i32* " + x + ", align 4\n";
+    reads += "  load i32, i32* " + x + ", align 4\n";
+  }
+  std::string module = StrModule::portasm(R"(
+@guard = global i32 0, align 4
+)" + globals + R"(
+define i8* @w(i8* %arg){
+)" + writes + R"(
+  ret i8* null
+}
+
+define i8* @r(i8* %arg){
+)" + reads + R"(
+  ret i8* null
+}
+
+define i32 @main(){
+  %g = load i32, i32* @guard, align 4
+  %fresh = icmp eq i32 %g, 0
+  br i1 %fresh, label %ok, label %error
+ok:
+  store i32 1, i32* @guard, align 4
+  call i32 @pthread_create(i64* null, %attr_t* null, i8*(i8*)* @w, i8* null)
+  call i32 @pthread_create(i64* null, %attr_t* null, i8*(i8*)* @r, i8* null)
+  ret i32 0
+error:
+  call void @__assert_fail()
+  unreachable
+}
+
+%attr_t = type { i64, [48 x i8] }
+declare i32 @pthread_create(i64*, %attr_t*, i8*(i8*)*, i8*) nounwind
+declare void @__assert_fail() nounwind noreturn
+)");
+  Configuration conf = DPORDriver_test::get_sc_conf();
+  for(int n_threads : {1, 4}){
+    conf.dpor_algorithm = Configuration::READS_FROM;
+    conf.n_threads = n_threads;
+    DPORDriver *driver = DPORDriver::parseIR(module,conf);
+    DPORDriver::Result res = driver->run();
+    delete driver;
+    BOOST_CHECK(!res.has_errors());
+    BOOST_CHECK_EQUAL(res.trace_count, uint64_t(1) << k);
+  }
+  conf = DPORDriver_test::get_sc_conf();
+  DPORDriver *driver = DPORDriver::parseIR(module,conf);
+  DPORDriver::Result res = driver->run();
+  delete driver;
+  BOOST_CHECK(!res.has_errors());
+  BOOST_CHECK_EQUAL(res.trace_count, uint64_t(1) << k);
+}
+
+BOOST_AUTO_TEST_CASE(Parallel_race_detect_many_races){
+  /* Main loads @x 150 times after starting @w, which stores to @x
+   * once. When the store comes first, every load races with it,
+   * giving 150 races on one trace: more than the 64 races per helper
+   * thread that race detection needs to split the work. There are
+   * 151 traces, one per position of the store among the loads.
+   */
+  std::string loads;
+  for(int i = 0; i < 150; ++i){
+    loads += "  load i32, i32* @x, align 4\n";
+  }
+  Configuration conf = DPORDriver_test::get_sc_conf();
+  conf.dpor_algorithm = Configuration::OPTIMAL;
+  DPORDriver_test::check_parallel_equiv(R"(
+@x = global i32 0, align 4
+
+define i8* @w(i8* %arg){
+  store i32 1, i32* @x, align 4
+  ret i8* null
+}
+
+define i32 @main(){
+  call i32 @pthread_create(i64* null, %attr_t* null, i8*(i8*)* @w, i8* null)
+)" + loads + R"(
+  ret i32 0
+}
+
+%attr_t = type {i64, [48 x i8]}
+declare i32 @pthread_create(i64*,%attr_t*,i8*(i8*)*,i8*) nounwind
+)",conf,151,4);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 #endif
@@ -43,6 +43,12 @@ public:
   virtual bool check_sat() = 0;
   /* Returns the satisfying assignment, if solve() returned true. */
   virtual std::vector<unsigned> get_model() = 0;
+  /* Makes a running or later call to check_sat() return as soon as
+   * possible. The result of an interrupted check_sat() is meaningless,
+   * and the solver may not be used afterwards. May be called from any
+   * thread.
+   */
+  virtual void interrupt() = 0;
 };
 
 #endif
@@ -95,7 +95,7 @@ void SaturatedGraph::add_event(Pid pid, ExtID extid, EventKind kind,
          IFTRACE(std::cerr << "Adding from-read between " << id << " and " << w << "\n");
          out.push_back(w);
          ins.mut(w).push_back(id);
-         wq_add(w);
+         wq_add(id, w);
        });
   }
   if (is_store) {
@@ -142,23 +142,26 @@ bool SaturatedGraph::saturate() {
   check_graph_consistency();
   reverse_saturate();
   std::vector<std::pair<ID,ID>> new_edges;
+  std::vector<ID> changed, new_in;
   while (!wq_empty()) {
     Timing::Guard saturate1_guard(saturate1_timing);
     const ID id = wq_pop();
-    bool new_in = false;
     assert(id < events.size());
     new_edges.clear();
+    new_in.clear();
+    changed.clear();
+    changed.swap(wq_changed[id]);
     {
-      Event e = events[id];
-      const edge_vector &old_in = ins[id];
-      VC vc = recompute_vc_for_event(e, old_in);
+      /* events is not modified in this scope */
+      const Event &e = events[id];
       const VC &old_vc = vclocks[id];
-      if (is_in_cycle(e, old_in, vc)) {
+      VC vc;
+      if (!join_changed_preds(id, e, changed, vc)) {
         IFTRACE(std::cerr << "Cycle found\n");
         check_graph_consistency();
         return false;
       }
-      if (vc == old_vc) {
+      if (vc.size_ub() == 0) {
         IFTRACE(std::cerr << id << " unchanged\n");
         continue;
       }
@@ -197,7 +200,7 @@ bool SaturatedGraph::saturate() {
               IFTRACE(std::cerr << "Adding from-read from " << r << " to " << id << "\n");
               in.push_back(r);
               outs.mut(r).push_back(id);
-              new_in = true;
+              new_in.push_back(r);
             }
           }
           if (e.is_load) {
@@ -223,23 +226,53 @@ bool SaturatedGraph::saturate() {
       IFTRACE(std::cerr << "Updating " << id << ": " << vc << "\n");
       vclocks.mut(id) = std::move(vc);
     }
-    if (new_in) wq_add_first(id);
+    if (!new_in.empty()) {
+      wq_add_first(id);
+      std::vector<ID> &id_changed = wq_changed[id];
+      id_changed.insert(id_changed.end(), new_in.begin(), new_in.end());
+    }
     add_edges(new_edges);
   }
   wq_set.clear();
+  wq_changed.clear();
   check_graph_consistency();
   return true;
 }
 
-bool SaturatedGraph::is_in_cycle
-(const Event &e, const edge_vector &in, const VC &vc) const {
-  const auto vc_different = [&vc,this](unsigned other) {
-                              return vclocks[other] != vc;
-                            };
-  if (e.po_predecessor && !vc_different(*e.po_predecessor)) return true;
-  if (e.read_from && !vc_different(*e.read_from)) return true;
-  if (!gen::all_of(in, vc_different)) return true;
-  return false;
+bool SaturatedGraph::join_changed_preds
+(ID id, const Event &e, const std::vector<ID> &changed, VC &vc) const {
+  Timing::Guard timing_guard(saturate_vc_timing);
+  const VC &old_vc = vclocks[id];
+  /* Clocks only grow, and every event whose clock changes adds itself
+   * to wq_changed of its successors. Thus, unless e is visited for the
+   * first time, old_vc already includes the clocks of all predecessors
+   * not in changed. Likewise, if e is in a cycle, the predecessor
+   * closing the cycle is in changed once its clock includes e.
+   */
+  if (old_vc.size_ub() == 0) {
+    vc = initial_vc_for_event(e);
+    bool acyclic = true;
+    const auto add_to_vc = [&vc,&acyclic,&e,this](ID pred) {
+                             assert(pred < vclocks.size());
+                             if (happens_after(pred, e)) acyclic = false;
+                             vc += vclocks[pred];
+                           };
+    if (e.po_predecessor) add_to_vc(*e.po_predecessor);
+    if (e.read_from) add_to_vc(*e.read_from);
+    gen::for_each(ins[id], add_to_vc);
+    return acyclic;
+  }
+
+  bool grows = false;
+  for (ID pred : changed) {
+    if (happens_after(pred, e)) return false;
+    if (!grows && !vclocks[pred].leq(old_vc)) grows = true;
+  }
+  /* Leave vc empty when nothing changed, to avoid copying old_vc */
+  if (!grows) return true;
+  vc = old_vc;
+  for (ID pred : changed) vc += vclocks[pred];
+  return true;
 }
 
 void SaturatedGraph::add_edges(const std::vector<std::pair<ID,ID>> &edges) {
@@ -278,23 +311,8 @@ SaturatedGraph::VC SaturatedGraph::initial_vc_for_event(const Event &e) const {
   return initial_vc_for_event(e.iid);
 }
 
-SaturatedGraph::VC SaturatedGraph::
-recompute_vc_for_event(const Event &e, const edge_vector &in) const {
-  Timing::Guard timing_guard(saturate_vc_timing);
-  VC vc = initial_vc_for_event(e);;
-  const auto add_to_vc = [&vc,this](ID id) {
-                           assert(id < vclocks.size());
-                           vc += vclocks[id];
-                         };
-  if (e.po_predecessor)
-    add_to_vc(*e.po_predecessor);
-  if (e.read_from) add_to_vc(*e.read_from);
-  gen::for_each(in, add_to_vc);
-  return vc;
-}
-
 void SaturatedGraph::add_successors_to_wq(ID id, const Event &e) {
-  const auto add_to_wq = [this](unsigned id) { wq_add(id); };
+  const auto add_to_wq = [this,id](unsigned succ) { wq_add(id, succ); };
   if (e.is_store)
     gen::for_each(e.readers, add_to_wq);
   gen::for_each(outs[id], add_to_wq);
@@ -302,14 +320,25 @@ void SaturatedGraph::add_successors_to_wq(ID id, const Event &e) {
 
 void SaturatedGraph::wq_add(unsigned id) {
   if (wq_set.size() > id && wq_set[id]) return;
-  if (wq_set.size() <= id) wq_set.resize(id+1);
+  if (wq_set.size() <= id) {
+    wq_set.resize(id+1);
+    wq_changed.resize(id+1);
+  }
   wq_set[id] = true;
   wq_queue.push_back(id);
 }
 
+void SaturatedGraph::wq_add(unsigned from, unsigned to) {
+  wq_add(to);
+  wq_changed[to].push_back(from);
+}
+
 void SaturatedGraph::wq_add_first(unsigned id) {
   if (wq_set.size() > id && wq_set[id]) return;
-  if (wq_set.size() <= id) wq_set.resize(id+1);
+  if (wq_set.size() <= id) {
+    wq_set.resize(id+1);
+    wq_changed.resize(id+1);
+  }
   wq_set[id] = true;
   wq_queue.push_front(id);
 }
@@ -429,7 +458,7 @@ void SaturatedGraph::add_edge_internal(ID from, ID to) {
   Timing::Guard timing_guard(add_edge_timing);
   outs.mut(from).push_back(to);
   ins.mut(to).push_back(from);
-  wq_add(to);
+  wq_add(from, to);
 }
 
 /* Reverse saturation is needed to infer the from-read edges that are
@@ -449,6 +478,8 @@ void SaturatedGraph::reverse_saturate() {
     IFTRACE(for (ID id : care.vec) std::cerr << id << " ");
     IFTRACE(std::cerr << "\n");
     if (care.vec.empty()) goto done;
+    /* The forward saturation below will find the cycle */
+    if (care.cyclic) goto done;
 
     VClockVec below_clocks(events_by_pid.size(), events.size());
     const VC top = this->top();
@@ -487,8 +518,7 @@ void SaturatedGraph::reverse_saturate() {
           for (unsigned r : new_out) {
             if (r == pe_id) continue; /* RMW */
             IFTRACE(std::cerr << "Adding missed from-read from " << r << " to " << pe_id << "\n");
-            /* Optimisation opportunity */
-            //add_edge_internal(r, pe_id);
+            add_edge_internal(r, pe_id);
           }
         }
       }
@@ -525,10 +555,14 @@ foreach_succ(ID id, const Event &e, Fn f) const {
 }
 
 void SaturatedGraph::add_to_care(struct care &care, unsigned id) const {
-  if (care.set[id]) return;
+  if (care.set[id]) {
+    if (!care.done[id]) care.cyclic = true;
+    return;
+  }
   const Event &e = events[id];
   care.set[id] = true;
   foreach_succ(id, e, [&care,this](unsigned r) { add_to_care(care, r); });
+  care.done[id] = true;
   care.vec.push_back(id);
 }
 
@@ -134,15 +134,29 @@ protected:
   Option<ID> maybe_get_process_event(Pid pid, unsigned index) const;
   VC initial_vc_for_event(IID<Pid> iid) const;
   VC initial_vc_for_event(const Event &e) const;
-  VC recompute_vc_for_event(const Event &e, const edge_vector &in) const;
+  /* Joins into vc the clocks of the predecessors of e that have changed
+   * since e was last visited (all its predecessors, if it was never
+   * visited). Returns false if any of them happens after e, i.e., if e
+   * is in a cycle.
+   */
+  bool join_changed_preds(ID id, const Event &e,
+                          const std::vector<ID> &changed, VC &vc) const;
+  /* True if the (current) clock of event from includes e. */
+  bool happens_after(ID from, const Event &e) const {
+    return int(e.iid.get_index()) <= vclocks[from][e.iid.get_pid()];
+  }
   void add_successors_to_wq(ID id, const Event &e);
-  bool is_in_cycle(const Event &e, const edge_vector &in, const VC &vc) const;
   Option<ID> po_successor(ID id, const Event &e) const;
   VC top() const;
   struct care {
-    care(unsigned e_sz) : set(e_sz) {}
+    care(unsigned e_sz) : set(e_sz), done(e_sz), cyclic(false) {}
     std::vector<bool> set;
+    /* The events that have been added to vec */
+    std::vector<bool> done;
     std::vector<ID> vec;
+    /* True if the care set contains a cycle, in which case vec is not
+     * topologically sorted */
+    bool cyclic;
   };
   struct care reverse_care_set() const;
   void add_to_care(struct care &, unsigned) const;
@@ -158,7 +172,15 @@ protected:
 
   std::deque<ID> wq_queue;
   std::vector<bool> wq_set;
+  /* For each event in the queue, the predecessors whose clocks changed
+   * (or that were linked to it) since it was last visited. Saturation
+   * only needs to join (and check for cycles against) these, rather
+   * than against all predecessors.
+   */
+  std::vector<std::vector<ID>> wq_changed;
   void wq_add(ID id);
+  /* Adds to to the queue, recording that from is a changed predecessor. */
+  void wq_add(ID from, ID to);
   void wq_add_first(ID id);
   bool wq_empty() const;
   ID wq_pop();
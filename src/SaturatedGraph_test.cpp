@@ -0,0 +1,144 @@
+/* Copyright (C) 2026 agent
+ *
+ * This file is part of Nidhugg.
+ *
+ * Nidhugg is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nidhugg is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#ifdef HAVE_BOOST_UNIT_TEST_FRAMEWORK
+#include <boost/test/unit_test.hpp>
+
+#include "SaturatedGraph.h"
+
+#include <deque>
+#include <random>
+#include <vector>
+
+namespace {
+  /* The arguments of one call to SaturatedGraph::add_event. */
+  struct Event {
+    SaturatedGraph::Pid pid;
+    SaturatedGraph::ExtID iid;
+    SaturatedGraph::EventKind kind;
+    SymAddr addr;
+    Option<SaturatedGraph::ExtID> read_from;
+    std::vector<SaturatedGraph::ExtID> happens_after;
+  };
+
+  /* A random sequence of events, in an order in which they can be
+   * added to a SaturatedGraph: each event comes after its program
+   * order predecessor, the store it reads from, and the events it
+   * happens after.
+   */
+  std::vector<Event> random_events(std::mt19937 &rng){
+    std::uniform_int_distribution<int> n_procs_d(2,4), n_events_d(4,24);
+    int n_procs = n_procs_d(rng);
+    int n_events = n_events_d(rng);
+    std::uniform_int_distribution<int> pct(0,99), proc_d(0,n_procs-1),
+      addr_d(0,1), kind_d(0,3);
+    std::vector<Event> events;
+    std::vector<int> next_index(n_procs,1);
+    std::vector<std::vector<unsigned> > stores(2);
+    for(int i = 0; i < n_events; ++i){
+      Event e;
+      e.pid = proc_d(rng);
+      e.iid = SaturatedGraph::ExtID(e.pid,next_index[e.pid]++);
+      e.kind = SaturatedGraph::EventKind(kind_d(rng));
+      if(e.kind != SaturatedGraph::NONE){
+        int a = addr_d(rng);
+        e.addr = SymAddr(SymMBlock::Global(a),0);
+        if(e.kind != SaturatedGraph::STORE && stores[a].size() && pct(rng) < 75){
+          std::uniform_int_distribution<unsigned> w(0,stores[a].size()-1);
+          e.read_from = events[stores[a][w(rng)]].iid;
+        }
+        if(e.kind != SaturatedGraph::LOAD) stores[a].push_back(events.size());
+      }
+      for(unsigned j = 0; j < events.size(); ++j){
+        if(events[j].pid != e.pid && pct(rng) < 5){
+          e.happens_after.push_back(events[j].iid);
+        }
+      }
+      events.push_back(e);
+    }
+    return events;
+  }
+
+  void add(SaturatedGraph &g, const Event &e){
+    g.add_event(e.pid,e.iid,e.kind,e.addr,e.read_from,e.happens_after);
+  }
+
+  /* A chain of graphs, each cloned from the previous one. Every clone
+   * must be outlived by the graph it was cloned from, so they are
+   * destroyed from the back.
+   */
+  struct GraphChain : public std::deque<SaturatedGraph> {
+    GraphChain() : std::deque<SaturatedGraph>(1) {};
+    ~GraphChain(){
+      while(size()) pop_back();
+    };
+  };
+}
+
+BOOST_AUTO_TEST_SUITE(SaturatedGraph_test)
+
+/* Adding events in chunks and saturating after each chunk, cloning
+ * the graph in between as the RFSC trace builder does with its cached
+ * graphs, must give the same result as saturating all the events at
+ * once: the same acyclicity verdict and, if acyclic, the same clock
+ * (i.e., the same happens-after predecessors) for every event.
+ */
+BOOST_AUTO_TEST_CASE(Incremental_vs_scratch){
+  int cyclic = 0, acyclic = 0;
+  for(unsigned seed = 0; seed < 2000; ++seed){
+    std::mt19937 rng(seed);
+    std::vector<Event> events = random_events(rng);
+    std::uniform_int_distribution<unsigned> chunk_d(1,5);
+    GraphChain graphs;
+    unsigned added = 0;
+    while(added < events.size()){
+      unsigned end = std::min<unsigned>(events.size(),added+chunk_d(rng));
+      SaturatedGraph &g = graphs.back();
+      for(; added < end; ++added) add(g,events[added]);
+      bool g_acyclic = g.saturate();
+
+      SaturatedGraph scratch;
+      for(unsigned i = 0; i < added; ++i) add(scratch,events[i]);
+      bool scratch_acyclic = scratch.saturate();
+
+      BOOST_REQUIRE_MESSAGE(g_acyclic == scratch_acyclic,
+                            "seed " << seed << ", " << added << " events");
+      if(!g_acyclic){
+        ++cyclic;
+        break;
+      }
+      for(unsigned i = 0; i < added; ++i){
+        BOOST_REQUIRE_MESSAGE(g.event_vc(events[i].iid) == scratch.event_vc(events[i].iid),
+                              "seed " << seed << ", " << added << " events, "
+                              << events[i].iid.to_string());
+      }
+      if(added == events.size()) ++acyclic;
+      graphs.push_back(g.clone());
+    }
+  }
+  /* Both verdicts must be exercised */
+  BOOST_CHECK(cyclic > 100);
+  BOOST_CHECK(acyclic > 100);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
@@ -106,14 +106,31 @@ void SmtlibSatSolver::add_edge_disj(unsigned froma, unsigned toa,
 
 bool SmtlibSatSolver::check_sat() {
   in << "(check-sat)" << std::endl;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (interrupted) return false;
+    solving = true;
+  }
 
   std::string res;
   std::getline(out, res);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    solving = false;
+    if (interrupted) return false;
+  }
   if (res == "unsat") return false;
   assert(res == "sat");
   return true;
 }
 
+void SmtlibSatSolver::interrupt() {
+  std::lock_guard<std::mutex> lock(mutex);
+  interrupted = true;
+  /* Closes the pipe, so that check_sat() returns */
+  if (solving) z3.terminate();
+}
+
 std::vector<unsigned> SmtlibSatSolver::get_model() {
   std::vector<unsigned> res;
   res.reserve(no_vars);
@@ -28,6 +28,7 @@
 #endif
 
 #include <boost/process.hpp>
+#include <mutex>
 
 class SmtlibSatSolver final: public SatSolver {
 public:
@@ -40,9 +41,18 @@ public:
                              unsigned fromb, unsigned tob);
   virtual bool check_sat();
   virtual std::vector<unsigned> get_model();
+  virtual void interrupt();
 
 private:
   unsigned no_vars;
+  /* Protects interrupted and solving. */
+  std::mutex mutex;
+  bool interrupted = false;
+  /* True while check_sat() is waiting for the answer. The solver
+   * process may only be killed then, since we would otherwise get
+   * SIGPIPE when writing to it.
+   */
+  bool solving = false;
   boost::process::ipstream out;
   boost::process::opstream in;
   boost::process::child z3;
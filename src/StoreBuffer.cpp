@@ -0,0 +1,56 @@
+/* Copyright (C) 2026 agent
+ *
+ * This file is part of Nidhugg.
+ *
+ * Nidhugg is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nidhugg is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "StoreBuffer.h"
+
+#include <algorithm>
+
+void StoreBuffer::push_back(void *ptr, SymData data){
+  uint64_t seq = front_seq + entries.size();
+  for(SymAddr b : data.get_ref()){
+    newest[b] = seq;
+  }
+  entries.push_back(Entry(ptr,std::move(data)));
+}
+
+void StoreBuffer::pop_front(){
+  assert(entries.size());
+  for(SymAddr b : entries.front().data.get_ref()){
+    auto it = newest.find(b);
+    assert(it != newest.end());
+    /* Keep the index entry if a newer store also writes b. */
+    if(it->second == front_seq) newest.erase(it);
+  }
+  entries.pop_front();
+  ++front_seq;
+}
+
+int StoreBuffer::newest_overlapping(const SymAddrSize &ml) const{
+  if(newest.empty()) return -1;
+  int res = -1;
+  for(SymAddr b : ml){
+    auto it = newest.find(b);
+    if(it != newest.end()){
+      res = std::max(res,int(it->second - front_seq));
+    }
+  }
+  return res;
+}
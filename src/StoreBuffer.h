@@ -0,0 +1,80 @@
+/* Copyright (C) 2026 agent
+ *
+ * This file is part of Nidhugg.
+ *
+ * Nidhugg is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nidhugg is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#ifndef __STORE_BUFFER_H__
+#define __STORE_BUFFER_H__
+
+#include "RingBuffer.h"
+#include "SymAddr.h"
+
+#include <cstdint>
+#include <unordered_map>
+
+/* A StoreBuffer is the TSO store buffer of one thread: A FIFO queue
+ * of pending stores, where newer entries are further to the back.
+ *
+ * Besides constant time flushing of the oldest entry, it keeps a
+ * forwarding index from each buffered byte to the newest entry
+ * writing to that byte. Finding the latest store that a load may
+ * read early from (or that blocks the load) therefore takes time
+ * proportional to the size of the load rather than to the length of
+ * the buffer.
+ */
+class StoreBuffer{
+public:
+  /* A pending store of data to the actual memory at ptr. */
+  class Entry{
+  public:
+    Entry(void *ptr, SymData data) : ptr(ptr), data(std::move(data)) {};
+    void *ptr;
+    SymData data;
+  };
+  StoreBuffer() : front_seq(0) {};
+  std::size_t size() const { return entries.size(); };
+  bool empty() const { return entries.empty(); };
+  /* The i:th oldest entry. */
+  const Entry &operator[](std::size_t i) const { return entries[i]; };
+  const Entry &front() const { return entries.front(); };
+  /* Appends a store of data to ptr as the newest entry. */
+  void push_back(void *ptr, SymData data);
+  /* Removes the oldest entry.
+   *
+   * Pre: !empty()
+   */
+  void pop_front();
+  /* Returns the index of the newest entry whose memory location
+   * overlaps with ml, or -1 if there is no such entry.
+   */
+  int newest_overlapping(const SymAddrSize &ml) const;
+private:
+  RingBuffer<Entry> entries;
+  /* Entries are given sequence numbers 0, 1, ... in the order they
+   * are pushed. front_seq is the sequence number of the oldest entry
+   * in the buffer.
+   */
+  uint64_t front_seq;
+  /* For each byte b written by some entry in the buffer, newest[b]
+   * is the sequence number of the newest entry writing to b.
+   */
+  std::unordered_map<SymAddr,uint64_t> newest;
+};
+
+#endif
@@ -0,0 +1,95 @@
+/* Copyright (C) 2026 agent
+ *
+ * This file is part of Nidhugg.
+ *
+ * Nidhugg is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nidhugg is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#ifdef HAVE_BOOST_UNIT_TEST_FRAMEWORK
+#include <boost/test/unit_test.hpp>
+
+#include "StoreBuffer.h"
+
+#include <deque>
+
+BOOST_AUTO_TEST_SUITE(StoreBuffer_test)
+
+BOOST_AUTO_TEST_CASE(RingBuffer_fifo){
+  RingBuffer<int> rb;
+  std::deque<int> ref;
+  int next = 0;
+  /* Interleave pushes and pops so that the buffer wraps around while
+   * it grows.
+   */
+  for(int round = 0; round < 50; ++round){
+    for(int i = 0; i < round % 7 + 1; ++i){
+      rb.push_back(next);
+      ref.push_back(next);
+      ++next;
+    }
+    for(int i = 0; i < round % 5 && ref.size(); ++i){
+      BOOST_CHECK_EQUAL(rb.front(),ref.front());
+      rb.pop_front();
+      ref.pop_front();
+    }
+    BOOST_REQUIRE_EQUAL(rb.size(),ref.size());
+    for(unsigned i = 0; i < ref.size(); ++i){
+      BOOST_CHECK_EQUAL(rb[i],ref[i]);
+    }
+    if(ref.size()){
+      BOOST_CHECK_EQUAL(rb.back(),ref.back());
+    }
+  }
+  rb.clear();
+  BOOST_CHECK(rb.empty());
+}
+
+static SymData mk_data(const SymAddrSize &ml, uint8_t val){
+  SymData sd(ml,ml.size);
+  for(SymAddr b : ml) sd[b] = val;
+  return sd;
+}
+
+BOOST_AUTO_TEST_CASE(StoreBuffer_forwarding){
+  SymAddr x(SymMBlock::Global(0),0);
+  SymAddrSize x4(x,4), x2(x,2), x_hi(x+2,2), y4(SymAddr(SymMBlock::Global(1),0),4);
+  StoreBuffer sb;
+  BOOST_CHECK_EQUAL(sb.newest_overlapping(x4),-1);
+  sb.push_back(nullptr,mk_data(x4,1));
+  sb.push_back(nullptr,mk_data(y4,2));
+  sb.push_back(nullptr,mk_data(x2,3));
+  BOOST_CHECK_EQUAL(sb.newest_overlapping(x4),2);
+  BOOST_CHECK_EQUAL(sb.newest_overlapping(x2),2);
+  BOOST_CHECK_EQUAL(sb.newest_overlapping(x_hi),0);
+  BOOST_CHECK_EQUAL(sb.newest_overlapping(y4),1);
+  /* Flushing the first store to x keeps the index of the later one. */
+  sb.pop_front();
+  BOOST_CHECK_EQUAL(sb.newest_overlapping(x4),1);
+  BOOST_CHECK_EQUAL(sb.newest_overlapping(x_hi),-1);
+  BOOST_CHECK_EQUAL(sb.newest_overlapping(y4),0);
+  BOOST_CHECK(sb[1].data.get_ref() == x2);
+  BOOST_CHECK_EQUAL(int(sb[1].data[x]),3);
+  sb.pop_front();
+  sb.pop_front();
+  BOOST_CHECK(sb.empty());
+  BOOST_CHECK_EQUAL(sb.newest_overlapping(x4),-1);
+  BOOST_CHECK_EQUAL(sb.newest_overlapping(y4),-1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
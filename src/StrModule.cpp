@@ -26,6 +26,11 @@
 #elif defined(HAVE_LLVM_IR_IRPRINTINGPASSES_H)
 #include <llvm/IR/IRPrintingPasses.h>
 #endif
+#if defined(HAVE_LLVM_BITCODE_BITCODEWRITER_H)
+#include <llvm/Bitcode/BitcodeWriter.h>
+#elif defined(HAVE_LLVM_BITCODE_READERWRITER_H)
+#include <llvm/Bitcode/ReaderWriter.h>
+#endif
 #include <llvm/IRReader/IRReader.h>
 #if defined(HAVE_LLVM_PASSMANAGER_H)
 #include <llvm/PassManager.h>
@@ -50,6 +55,21 @@
 
 namespace StrModule {
 
+  namespace {
+    void write_bitcode(llvm::Module *mod, llvm::raw_ostream &os){
+#ifdef LLVM_WRITE_BITCODE_TAKES_REF
+      llvm::WriteBitcodeToFile(*mod,os);
+#else
+      llvm::WriteBitcodeToFile(mod,os);
+#endif
+    }
+
+    bool ends_with(const std::string &s, const std::string &suffix){
+      return s.size() >= suffix.size() &&
+        s.compare(s.size()-suffix.size(),suffix.size(),suffix) == 0;
+    }
+  }
+
   llvm::Module *read_module(std::string infile, llvm::LLVMContext &context){
     llvm::Module *mod;
     llvm::SMDiagnostic err;
@@ -134,6 +154,11 @@ namespace StrModule {
       throw std::logic_error("Failed to write transformed module to file "+outfile+": "+errs.message());
     }
 #endif
+    if(ends_with(outfile,".bc")){
+      write_bitcode(mod,*os);
+      delete os;
+      return;
+    }
 #ifdef LLVM_CREATE_PRINT_MODULE_PASS_PTR_ARG
     PM.add(llvm::createPrintModulePass(os,true));
 #else
@@ -162,6 +187,20 @@ namespace StrModule {
     return s;
   }
 
+  std::string write_module_bitcode_str(llvm::Module *mod){
+    std::string s;
+    {
+      llvm::raw_string_ostream os(s);
+      write_bitcode(mod,os);
+    }
+    return s;
+  }
+
+  bool is_bitcode(const std::string &src){
+    return src.compare(0,4,"BC\xC0\xDE") == 0 ||
+      src.compare(0,4,"\xDE\xC0\x17\x0B") == 0;
+  }
+
   std::string portasm(std::string s){
 #ifndef LLVM_ASM_LOAD_EXPLICIT_TYPE
     {
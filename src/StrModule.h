@@ -42,12 +42,25 @@ namespace StrModule {
    */
   llvm::Module *read_module_src(const std::string &src, llvm::LLVMContext &context = GlobalContext::get());
 
-  /* Stores mod as assembly to outfile. */
+  /* Stores mod to outfile. The module is stored as bitcode if
+   * outfile ends in ".bc", and as assembly otherwise.
+   */
   void write_module(llvm::Module *mod, std::string outfile);
 
   /* Returns a string representation of mod. */
   std::string write_module_str(llvm::Module *mod);
 
+  /* Returns mod as bitcode. The result can be read back with
+   * read_module_src, which is considerably faster than reading back
+   * the assembly from write_module_str.
+   */
+  std::string write_module_bitcode_str(llvm::Module *mod);
+
+  /* Returns true iff src starts like LLVM bitcode (plain or
+   * wrapped), rather than LLVM assembly.
+   */
+  bool is_bitcode(const std::string &src);
+
   /* Rewrites and returns the assembly code in s, to be of the form
    * expected by the version of LLVM against which this tool is
    * compiled.
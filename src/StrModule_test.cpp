@@ -0,0 +1,189 @@
+/* Copyright (C) 2026 agent
+ *
+ * This file is part of Nidhugg.
+ *
+ * Nidhugg is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nidhugg is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#ifdef HAVE_BOOST_UNIT_TEST_FRAMEWORK
+#include <boost/test/unit_test.hpp>
+
+#include "DPORDriver.h"
+#include "DPORDriver_test.h"
+#include "StrModule.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace {
+  /* Two threads racing on two variables, with 19 traces under SC. */
+  std::string fib_module(){
+    return StrModule::portasm(R"(
+@i = global i32 1, align 4
+@j = global i32 1, align 4
+
+define i8* @p1(i8* %arg){
+  %1 = load i32, i32* @i, align 4
+  %2 = load i32, i32* @j, align 4
+  %3 = add i32 %1, %2
+  store i32 %3, i32* @i, align 4
+  %4 = load i32, i32* @i, align 4
+  %5 = load i32, i32* @j, align 4
+  %6 = add i32 %4, %5
+  store i32 %6, i32* @i, align 4
+  ret i8* null
+}
+
+define i8* @p2(i8* %arg){
+  %1 = load i32, i32* @i, align 4
+  %2 = load i32, i32* @j, align 4
+  %3 = add i32 %1, %2
+  store i32 %3, i32* @j, align 4
+  %4 = load i32, i32* @i, align 4
+  %5 = load i32, i32* @j, align 4
+  %6 = add i32 %4, %5
+  store i32 %6, i32* @j, align 4
+  ret i8* null
+}
+
+define i32 @main(){
+  call i32 @pthread_create(i64* null, %attr_t* null, i8*(i8*)* @p1, i8* null)
+  call i32 @pthread_create(i64* null, %attr_t* null, i8*(i8*)* @p2, i8* null)
+  ret i32 0
+}
+
+%attr_t = type { i64, [48 x i8] }
+declare i32 @pthread_create(i64*, %attr_t*, i8*(i8*)*, i8*) nounwind
+)");
+  }
+
+  /* src wrapped in a bitcode wrapper header, as written by e.g. the
+   * Darwin toolchain. */
+  std::string wrap_bitcode(const std::string &src){
+    uint32_t header[5] = {0x0B17C0DE, 0, 20, uint32_t(src.size()), 0};
+    std::string s;
+    for(uint32_t w : header){
+      for(int i = 0; i < 4; ++i) s += char((w >> (8*i)) & 0xff);
+    }
+    return s + src;
+  }
+
+  /* The assembly of the module read from src, in a fresh context so
+   * that type names are not renamed. */
+  std::string assembly_of(const std::string &src){
+    llvm::LLVMContext context;
+    std::unique_ptr<llvm::Module> mod(StrModule::read_module_src(src,context));
+    return StrModule::write_module_str(mod.get());
+  }
+
+  /* The bitcode of the module read from src. */
+  std::string bitcode_of(const std::string &src){
+    llvm::LLVMContext context;
+    std::unique_ptr<llvm::Module> mod(StrModule::read_module_src(src,context));
+    return StrModule::write_module_bitcode_str(mod.get());
+  }
+
+  /* A driver that explores the module read from src, adopted with
+   * DPORDriver::fromModule. */
+  DPORDriver *from_module(const std::string &src, const Configuration &conf){
+    auto context = std::make_unique<llvm::LLVMContext>();
+    std::unique_ptr<llvm::Module> mod(StrModule::read_module_src(src,*context));
+    return DPORDriver::fromModule(std::move(mod),std::move(context),conf);
+  }
+
+  uint64_t trace_count(DPORDriver *driver){
+    std::unique_ptr<DPORDriver> d(driver);
+    DPORDriver::Result res = d->run();
+    BOOST_CHECK(!res.has_errors());
+    return res.trace_count;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(StrModule_test)
+
+BOOST_AUTO_TEST_CASE(Is_bitcode){
+  BOOST_CHECK(StrModule::is_bitcode(std::string("BC\xC0\xDE\x35\x14",6)));
+  BOOST_CHECK(StrModule::is_bitcode(std::string("\xDE\xC0\x17\x0B\0\0\0\0",8)));
+  BOOST_CHECK(StrModule::is_bitcode(wrap_bitcode("BC\xC0\xDE")));
+  BOOST_CHECK(!StrModule::is_bitcode(""));
+  BOOST_CHECK(!StrModule::is_bitcode("BC"));
+  BOOST_CHECK(!StrModule::is_bitcode("BC\xC0\xDF"));
+  BOOST_CHECK(!StrModule::is_bitcode("\xDE\xC0\x17"));
+  BOOST_CHECK(!StrModule::is_bitcode("define i32 @main(){ ret i32 0 }"));
+  BOOST_CHECK(!StrModule::is_bitcode(fib_module()));
+
+  llvm::LLVMContext context;
+  std::unique_ptr<llvm::Module> mod(StrModule::read_module_src(fib_module(),context));
+  std::string bc = StrModule::write_module_bitcode_str(mod.get());
+  BOOST_CHECK(StrModule::is_bitcode(bc));
+  BOOST_CHECK(StrModule::is_bitcode(wrap_bitcode(bc)));
+  BOOST_CHECK(!StrModule::is_bitcode(StrModule::write_module_str(mod.get())));
+}
+
+/* Converting a module to bitcode and reading it back, plain or
+ * wrapped, gives the same module. */
+BOOST_AUTO_TEST_CASE(Bitcode_round_trip){
+  std::string bc = bitcode_of(fib_module());
+  std::string s = assembly_of(fib_module());
+  BOOST_CHECK_EQUAL(assembly_of(bc), s);
+  BOOST_CHECK_EQUAL(assembly_of(wrap_bitcode(bc)), s);
+  /* The bitcode is stable */
+  BOOST_CHECK(bitcode_of(bc) == bc);
+}
+
+/* Exploring the assembly, its bitcode, and the parsed module gives
+ * the same number of traces, also when worker threads parse the
+ * module again. */
+BOOST_AUTO_TEST_CASE(Bitcode_trace_count){
+  std::string module = fib_module();
+  std::string bc = bitcode_of(module);
+  for(int n_threads : {1, 2}){
+    Configuration conf = DPORDriver_test::get_sc_conf();
+    conf.dpor_algorithm = Configuration::READS_FROM;
+    conf.n_threads = n_threads;
+    uint64_t from_asm = trace_count(DPORDriver::parseIR(module,conf));
+    BOOST_CHECK_GT(from_asm, 1);
+    BOOST_CHECK_EQUAL(trace_count(DPORDriver::parseIR(bc,conf)), from_asm);
+    BOOST_CHECK_EQUAL(trace_count(DPORDriver::parseIR(wrap_bitcode(bc),conf)), from_asm);
+    BOOST_CHECK_EQUAL(trace_count(from_module(module,conf)), from_asm);
+  }
+  Configuration conf = DPORDriver_test::get_sc_conf();
+  uint64_t from_asm = trace_count(DPORDriver::parseIR(module,conf));
+  BOOST_CHECK_EQUAL(from_asm, 19);
+  BOOST_CHECK_EQUAL(trace_count(DPORDriver::parseIR(bc,conf)), from_asm);
+  BOOST_CHECK_EQUAL(trace_count(from_module(module,conf)), from_asm);
+}
+
+/* A driver created by fromModule can be run more than once, also
+ * when the first run has serialised the module for worker threads. */
+BOOST_AUTO_TEST_CASE(From_module_run_twice){
+  for(int n_threads : {1, 2}){
+    Configuration conf = DPORDriver_test::get_sc_conf();
+    conf.dpor_algorithm = Configuration::READS_FROM;
+    conf.n_threads = n_threads;
+    std::unique_ptr<DPORDriver> driver(from_module(fib_module(),conf));
+    DPORDriver::Result first = driver->run();
+    DPORDriver::Result second = driver->run();
+    BOOST_CHECK_GT(first.trace_count, 1);
+    BOOST_CHECK_EQUAL(second.trace_count, first.trace_count);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
@@ -81,8 +81,8 @@ void TSOInterpreter::runAux(int proc, int aux){
   assert(aux == 0);
   assert(tso_threads[proc].store_buffer.size());
 
-  void *ref = tso_threads[proc].store_buffer.front().first;
-  const SymData &blk = tso_threads[proc].store_buffer.front().second;
+  void *ref = tso_threads[proc].store_buffer.front().ptr;
+  const SymData &blk = tso_threads[proc].store_buffer.front().data;
 
   TB.atomic_store(blk);
 
@@ -90,10 +90,7 @@ void TSOInterpreter::runAux(int proc, int aux){
 
   std::memcpy((uint8_t*)ref,(uint8_t*)blk.get_block(),blk.get_ref().size);
 
-  for(unsigned i = 0; i < tso_threads[proc].store_buffer.size()-1; ++i){
-    tso_threads[proc].store_buffer[i] = tso_threads[proc].store_buffer[i+1];
-  }
-  tso_threads[proc].store_buffer.pop_back();
+  tso_threads[proc].store_buffer.pop_front();
 
   if(int(tso_threads[proc].store_buffer.size()) <= tso_threads[proc].partial_buffer_flush){
     assert(0 <= tso_threads[proc].partial_buffer_flush);
@@ -204,19 +201,15 @@ bool TSOInterpreter::checkRefuse(llvm::Instruction &I){
     llvm::GenericValue SRC = getOperandValue(static_cast<llvm::LoadInst&>(I).getPointerOperand(), SF);
     llvm::GenericValue *Ptr = (llvm::GenericValue*)GVTOP(SRC);
     SymAddrSize mr = GetSymAddrSize(Ptr,static_cast<llvm::LoadInst&>(I).getType());
-    for(int i = int(tso_threads[CurrentThread].store_buffer.size())-1; 0 <= i; --i){
-      if(mr.overlaps(tso_threads[CurrentThread].store_buffer[i].second.get_ref())){
-        if(mr != tso_threads[CurrentThread].store_buffer[i].second.get_ref()){
-          /* Block until this store buffer entry has disappeared from
-           * the buffer.
-           */
-          tso_threads[CurrentThread].partial_buffer_flush =
-            int(tso_threads[CurrentThread].store_buffer.size()) - i - 1;
-          TB.refuse_schedule();
-          return true;
-        }
-        break;
-      }
+    const StoreBuffer &sb = tso_threads[CurrentThread].store_buffer;
+    int i = sb.newest_overlapping(mr);
+    if(0 <= i && mr != sb[i].data.get_ref()){
+      /* Block until this store buffer entry has disappeared from
+       * the buffer.
+       */
+      tso_threads[CurrentThread].partial_buffer_flush = int(sb.size()) - i - 1;
+      TB.refuse_schedule();
+      return true;
     }
   }
   return Interpreter::checkRefuse(I);
@@ -238,12 +231,17 @@ void TSOInterpreter::visitLoadInst(llvm::LoadInst &I){
     return;
   }
 
-  /* Check store buffer for ROWE opportunity. */
-  for(int i = int(tso_threads[CurrentThread].store_buffer.size())-1; 0 <= i; --i){
-    if(Ptr_sas.addr == tso_threads[CurrentThread].store_buffer[i].second.get_ref().addr){
+  /* Check store buffer for ROWE opportunity. checkRefuse has
+   * ensured that the newest overlapping entry, if any, is a store to
+   * precisely Ptr_sas.
+   */
+  {
+    const StoreBuffer &sb = tso_threads[CurrentThread].store_buffer;
+    int i = sb.newest_overlapping(Ptr_sas);
+    if(0 <= i){
       /* Read-Own-Write-Early */
-      assert(GetSymAddrSize(Ptr,I.getType()).size == tso_threads[CurrentThread].store_buffer[i].second.get_ref().size);
-      LoadValueFromMemory(Result,(llvm::GenericValue*)tso_threads[CurrentThread].store_buffer[i].second.get_block(),I.getType());
+      assert(Ptr_sas == sb[i].data.get_ref());
+      LoadValueFromMemory(Result,(llvm::GenericValue*)sb[i].data.get_block(),I.getType());
       SetValue(&I, Result, SF);
       return;
     }
@@ -277,7 +275,7 @@ void TSOInterpreter::visitStoreInst(llvm::StoreInst &I){
       DryRunMem.push_back(std::move(sd));
       return;
     }
-    tso_threads[CurrentThread].store_buffer.emplace_back(Ptr, std::move(sd));
+    tso_threads[CurrentThread].store_buffer.push_back(Ptr, std::move(sd));
   }
 }
 
@@ -22,6 +22,7 @@
 #define __TSO_INTERPRETER_H__
 
 #include "Interpreter.h"
+#include "StoreBuffer.h"
 #include "TSOTraceBuilder.h"
 
 /* A TSOInterpreter is an interpreter running under the TSO
@@ -61,7 +62,7 @@ protected:
     /* The TSO store buffer of this thread. Newer entries are further
      * to the back.
      */
-    std::vector<std::pair<void*,SymData>> store_buffer;
+    StoreBuffer store_buffer;
     /* When partial_buffer_flush >= 0, it signals that this thread is
      * blocked, waiting for its store buffer update to memory. The
      * thread will continue to be blocked until the size of its store
@@ -21,8 +21,10 @@
 #include "TSOTraceBuilder.h"
 #include "TraceUtil.h"
 
+#include <atomic>
 #include <sstream>
 #include <stdexcept>
+#include <thread>
 
 #define ANSIRed "\x1b[91m"
 #define ANSIRst "\x1b[m"
@@ -39,6 +41,7 @@ TSOTraceBuilder::TSOTraceBuilder(const Configuration &conf) : TSOPSOTraceBuilder
   last_full_memory_conflict = -1;
   last_md = 0;
   replay_point = 0;
+  cycle_event = -1;
 }
 
 TSOTraceBuilder::~TSOTraceBuilder(){
@@ -120,11 +123,20 @@ bool TSOTraceBuilder::schedule(int *proc, int *aux, int *alt, bool *dryrun){
       assert(threads[pid].available);
       threads[pid].event_indices.push_back(prefix_idx);
       assert(!threads[pid].sleeping);
+      robustness_add_event();
       return true;
     }
   }
 
   assert(!replay);
+
+  if(0 <= cycle_event && !conf.explore_all_traces){
+    /* This computation is not robust, and the exploration will stop
+     * with that error. There is no need to execute it any further.
+     */
+    return false;
+  }
+
   /* Create a new Event */
 
   // TEMP: Until we have a SymEv for store()
@@ -142,6 +154,10 @@ bool TSOTraceBuilder::schedule(int *proc, int *aux, int *alt, bool *dryrun){
     assert(curbranch().sym.empty()); /* Can't happen */
     unsigned size = curbranch().size;
     prefix.delete_last();
+    if(conf.check_robustness){
+      cycle_detector.remove_last_node();
+      robustness_node.pop_back();
+    }
     --prefix_idx;
     Branch b = curbranch();
     b.size += size;
@@ -187,6 +203,7 @@ bool TSOTraceBuilder::schedule(int *proc, int *aux, int *alt, bool *dryrun){
       threads[p].event_indices.push_back(prefix_idx);
       prefix.push(Branch(IPid(p)),
                   Event(IID<IPid>(IPid(p),threads[p].last_event_index())));
+      robustness_add_event();
       *proc = p/2;
       *aux = 0;
       return true;
@@ -199,6 +216,7 @@ bool TSOTraceBuilder::schedule(int *proc, int *aux, int *alt, bool *dryrun){
       threads[p].event_indices.push_back(prefix_idx);
       prefix.push(Branch(IPid(p)),
                   Event(IID<IPid>(IPid(p),threads[p].last_event_index())));
+      robustness_add_event();
       *proc = p/2;
       *aux = -1;
       return true;
@@ -264,12 +282,12 @@ bool TSOTraceBuilder::sleepset_is_empty() const{
 }
 
 bool TSOTraceBuilder::check_for_cycles(){
-  IID<IPid> i_iid;
-  if(!has_cycle(&i_iid)) return false;
+  /* The cycles are detected online, by robustness_add_edge. */
+  if(cycle_event < 0) return false;
 
   /* Report cycle */
   {
-    assert(prefix.len());
+    const IID<IPid> &i_iid = prefix[cycle_event].iid;
     IID<CPid> c_iid(threads[i_iid.get_pid()].cpid,i_iid.get_index());
     errors.push_back(new RobustnessError(c_iid));
   }
@@ -353,6 +371,9 @@ bool TSOTraceBuilder::reset(){
 
   CPS = CPidSystem();
   threads.clear();
+  sleep_readers.clear();
+  sleep_writers.clear();
+  sleep_fullmem.clear();
   threads.push_back(Thread(CPid(),-1));
   threads.push_back(Thread(CPS.new_aux(CPid()),-1));
   threads[1].available = false; // Store buffer is empty.
@@ -365,6 +386,9 @@ bool TSOTraceBuilder::reset(){
   replay = true;
   dry_sleepers = 0;
   last_md = 0;
+  cycle_detector.clear();
+  robustness_node.clear();
+  cycle_event = -1;
   reset_cond_branch_log();
 
   return true;
@@ -665,9 +689,8 @@ void TSOTraceBuilder::do_atomic_store(const SymData &sd){
     assert(prefix_idx+1 < int(prefix.len()));
     assert(dry_sleepers <= prefix[prefix_idx+1].sleep.size());
     IPid pid = prefix[prefix_idx+1].sleep[dry_sleepers-1];
-    VecSet<SymAddr> &A = threads[pid].sleep_accesses_w;
     for(SymAddr b : ml){
-      A.insert(b);
+      sleep_add_write(pid, b);
     }
     return;
   }
@@ -731,10 +754,7 @@ void TSOTraceBuilder::do_atomic_store(const SymData &sd){
   }
 
   if(is_update){ /* Remove pending store from buffer */
-    for(unsigned i = 0; i < threads[tipid].store_buffer.size()-1; ++i){
-      threads[tipid].store_buffer[i] = threads[tipid].store_buffer[i+1];
-    }
-    threads[tipid].store_buffer.pop_back();
+    threads[tipid].store_buffer.pop_front();
     if(threads[tipid].store_buffer.empty()){
       threads[uipid].available = false;
     }
@@ -755,9 +775,8 @@ void TSOTraceBuilder::do_load(const SymAddrSize &ml){
     assert(prefix_idx+1 < int(prefix.len()));
     assert(dry_sleepers <= prefix[prefix_idx+1].sleep.size());
     IPid pid = prefix[prefix_idx+1].sleep[dry_sleepers-1];
-    VecSet<SymAddr> &A = threads[pid].sleep_accesses_r;
     for(SymAddr b : ml){
-      A.insert(b);
+      sleep_add_read(pid, b);
     }
     printf("dry\n");
     return;
@@ -818,6 +837,7 @@ void TSOTraceBuilder::full_memory_conflict(){
     assert(dry_sleepers <= prefix[prefix_idx+1].sleep.size());
     IPid pid = prefix[prefix_idx+1].sleep[dry_sleepers-1];
     threads[pid].sleep_full_memory_conflict = true;
+    sleep_fullmem.insert(pid);
     return;
   }
   curev().may_conflict = true;
@@ -905,7 +925,7 @@ void TSOTraceBuilder::mutex_lock(const SymAddrSize &ml){
     assert(prefix_idx+1 < int(prefix.len()));
     assert(dry_sleepers <= prefix[prefix_idx+1].sleep.size());
     IPid pid = prefix[prefix_idx+1].sleep[dry_sleepers-1];
-    threads[pid].sleep_accesses_w.insert(ml.addr);
+    sleep_add_write(pid, ml.addr);
     return;
   }
   fence();
@@ -952,7 +972,7 @@ void TSOTraceBuilder::mutex_trylock(const SymAddrSize &ml){
     assert(prefix_idx+1 < int(prefix.len()));
     assert(dry_sleepers <= prefix[prefix_idx+1].sleep.size());
     IPid pid = prefix[prefix_idx+1].sleep[dry_sleepers-1];
-    threads[pid].sleep_accesses_w.insert(ml.addr);
+    sleep_add_write(pid, ml.addr);
     return;
   }
   fence();
@@ -979,7 +999,7 @@ void TSOTraceBuilder::mutex_unlock(const SymAddrSize &ml){
     assert(prefix_idx+1 < int(prefix.len()));
     assert(dry_sleepers <= prefix[prefix_idx+1].sleep.size());
     IPid pid = prefix[prefix_idx+1].sleep[dry_sleepers-1];
-    threads[pid].sleep_accesses_w.insert(ml.addr);
+    sleep_add_write(pid, ml.addr);
     return;
   }
   fence();
@@ -1005,7 +1025,7 @@ void TSOTraceBuilder::mutex_init(const SymAddrSize &ml){
     assert(prefix_idx+1 < int(prefix.len()));
     assert(dry_sleepers <= prefix[prefix_idx+1].sleep.size());
     IPid pid = prefix[prefix_idx+1].sleep[dry_sleepers-1];
-    threads[pid].sleep_accesses_w.insert(ml.addr);
+    sleep_add_write(pid, ml.addr);
     return;
   }
   fence();
@@ -1022,7 +1042,7 @@ void TSOTraceBuilder::mutex_destroy(const SymAddrSize &ml){
     assert(prefix_idx+1 < int(prefix.len()));
     assert(dry_sleepers <= prefix[prefix_idx+1].sleep.size());
     IPid pid = prefix[prefix_idx+1].sleep[dry_sleepers-1];
-    threads[pid].sleep_accesses_w.insert(ml.addr);
+    sleep_add_write(pid, ml.addr);
     return;
   }
   fence();
@@ -1046,7 +1066,7 @@ bool TSOTraceBuilder::cond_init(const SymAddrSize &ml){
     assert(prefix_idx+1 < int(prefix.len()));
     assert(dry_sleepers <= prefix[prefix_idx+1].sleep.size());
     IPid pid = prefix[prefix_idx+1].sleep[dry_sleepers-1];
-    threads[pid].sleep_accesses_w.insert(ml.addr);
+    sleep_add_write(pid, ml.addr);
     return true;
   }
   fence();
@@ -1066,7 +1086,7 @@ bool TSOTraceBuilder::cond_signal(const SymAddrSize &ml){
     assert(prefix_idx+1 < int(prefix.len()));
     assert(dry_sleepers <= prefix[prefix_idx+1].sleep.size());
     IPid pid = prefix[prefix_idx+1].sleep[dry_sleepers-1];
-    threads[pid].sleep_accesses_w.insert(ml.addr);
+    sleep_add_write(pid, ml.addr);
     return true;
   }
   fence();
@@ -1113,7 +1133,7 @@ bool TSOTraceBuilder::cond_broadcast(const SymAddrSize &ml){
     assert(prefix_idx+1 < int(prefix.len()));
     assert(dry_sleepers <= prefix[prefix_idx+1].sleep.size());
     IPid pid = prefix[prefix_idx+1].sleep[dry_sleepers-1];
-    threads[pid].sleep_accesses_w.insert(ml.addr);
+    sleep_add_write(pid, ml.addr);
     return true;
   }
   fence();
@@ -1166,7 +1186,7 @@ bool TSOTraceBuilder::cond_wait(const SymAddrSize &cond_ml, const SymAddrSize &m
     assert(prefix_idx+1 < int(prefix.len()));
     assert(dry_sleepers <= prefix[prefix_idx+1].sleep.size());
     IPid pid = prefix[prefix_idx+1].sleep[dry_sleepers-1];
-    threads[pid].sleep_accesses_r.insert(cond_ml.addr);
+    sleep_add_read(pid, cond_ml.addr);
     return true;
   }
   fence();
@@ -1211,7 +1231,7 @@ int TSOTraceBuilder::cond_destroy(const SymAddrSize &ml){
     assert(prefix_idx+1 < int(prefix.len()));
     assert(dry_sleepers <= prefix[prefix_idx+1].sleep.size());
     IPid pid = prefix[prefix_idx+1].sleep[dry_sleepers-1];
-    threads[pid].sleep_accesses_w.insert(ml.addr);
+    sleep_add_write(pid, ml.addr);
     return 0;
   }
   fence();
@@ -1530,6 +1550,7 @@ void TSOTraceBuilder::add_noblock_race(int event){
   assert(0 <= event);
   assert(event < prefix_idx);
   assert(do_events_conflict(event, prefix_idx));
+  robustness_add_edge(event,prefix_idx);
 
   std::vector<Race> &races = curev().races;
   if (races.size()) {
@@ -1548,6 +1569,7 @@ void TSOTraceBuilder::add_lock_suc_race(int lock, int unlock){
   assert(unlock < prefix_idx);
 
   curev().races.push_back(Race::LockSuc(lock,prefix_idx,unlock));
+  robustness_add_edge(unlock,prefix_idx);
 }
 
 void TSOTraceBuilder::add_lock_fail_race(const Mutex &m, int event){
@@ -1563,6 +1585,7 @@ void TSOTraceBuilder::add_observed_race(int first, int second){
   assert(second < prefix_idx);
   assert(do_events_conflict(first, second));
   assert(do_events_conflict(second, prefix_idx));
+  robustness_add_edge(first,second);
 
   std::vector<Race> &races = prefix[second].races;
   if (races.size()) {
@@ -1584,6 +1607,8 @@ void TSOTraceBuilder::add_happens_after(unsigned second, unsigned first){
   assert(first < second);
   assert((long long)second <= prefix_idx);
 
+  robustness_add_edge(first,second);
+
   std::vector<unsigned> &vec = prefix[second].happens_after;
   if (vec.size() && vec.back() == first) return;
 
@@ -1864,20 +1889,78 @@ void TSOTraceBuilder::do_race_detect() {
   }
 
   /* Do race detection */
-  struct obs_sleep sleep;
-  for (unsigned i = 0; i < races.size(); ++i){
-    obs_sleep_add(sleep, prefix[i]);
-    for (const Race *race : races[i]) {
-      assert(race->first_event == int(i));
-      race_detect(*race, (const struct obs_sleep&)sleep);
+  if (conf.dpor_algorithm != Configuration::SOURCE && conf.n_threads > 1) {
+    do_race_detect_parallel(races);
+  } else {
+    struct obs_sleep sleep;
+    for (unsigned i = 0; i < races.size(); ++i){
+      obs_sleep_add(sleep, prefix[i]);
+      for (const Race *race : races[i]) {
+        assert(race->first_event == int(i));
+        race_detect(*race, (const struct obs_sleep&)sleep);
+      }
+      obs_sleep_wake(sleep, prefix[i]);
     }
-    obs_sleep_wake(sleep, prefix[i]);
   }
 
   for (unsigned i = 0; i < prefix.len(); ++i) prefix[i].races.clear();
   lock_fail_races.clear();
 }
 
+void TSOTraceBuilder::do_race_detect_parallel
+(const std::vector<std::vector<const Race*>> &races) {
+  struct Job {
+    const Race *race;
+    /* Index into sleeps */
+    unsigned sleep;
+    /* The wakeup sequence, if it is to be inserted */
+    Option<std::vector<Branch>> v;
+  };
+  std::vector<Job> jobs;
+  std::vector<struct obs_sleep> sleeps;
+  {
+    struct obs_sleep sleep;
+    for (unsigned i = 0; i < races.size(); ++i){
+      obs_sleep_add(sleep, prefix[i]);
+      if (races[i].size()) {
+        sleeps.push_back(sleep);
+        for (const Race *race : races[i]) {
+          assert(race->first_event == int(i));
+          jobs.push_back({race, unsigned(sleeps.size()-1), nullptr});
+        }
+      }
+      obs_sleep_wake(sleep, prefix[i]);
+    }
+  }
+
+  std::atomic<std::size_t> next_job(0);
+  auto worker = [this, &jobs, &sleeps, &next_job]() {
+    std::size_t j;
+    while ((j = next_job.fetch_add(1, std::memory_order_relaxed))
+           < jobs.size()) {
+      Job &job = jobs[j];
+      std::vector<Branch> v = wakeup_sequence(*job.race);
+      if (sequence_clears_sleep(v, sleeps[job.sleep])) {
+        job.v = std::move(v);
+      }
+    }
+  };
+  /* Starting threads only pays off when there are enough races */
+  const std::size_t races_per_thread = 64;
+  std::size_t n_helpers =
+    std::min(std::size_t(conf.n_threads), jobs.size() / races_per_thread);
+  std::vector<std::thread> helpers;
+  for (std::size_t t = 1; t < n_helpers; ++t) {
+    helpers.emplace_back(worker);
+  }
+  worker();
+  for (std::thread &t : helpers) t.join();
+
+  for (Job &job : jobs) {
+    if (job.v) insert_wakeup_sequence(job.race->first_event, std::move(*job.v));
+  }
+}
+
 void TSOTraceBuilder::race_detect
 (const Race &race, const struct obs_sleep &isleep){
   if (conf.dpor_algorithm != Configuration::SOURCE) {
@@ -1974,6 +2057,10 @@ void TSOTraceBuilder::race_detect_optimal
   /* Check if we have previously explored everything startable with v */
   if (!sequence_clears_sleep(v, isleep)) return;
 
+  insert_wakeup_sequence(i, std::move(v));
+}
+
+void TSOTraceBuilder::insert_wakeup_sequence(int i, std::vector<Branch> v){
   /* Do insertion into the wakeup tree */
   WakeupTreeRef<Branch> node = prefix.parent_at(i);
   while(1) {
@@ -2125,18 +2212,25 @@ wakeup_sequence(const Race &race) const{
   std::vector<const Event*> observers;
   std::vector<Branch> notobs;
 
-  for (int k = i + 1; k < int(prefix.len()); ++k){
-    if (!first.clock.leq(prefix[k].clock)) {
+  if (race.kind != Race::OBSERVED) {
+    /* Only the events that do not happen after prefix[i] are needed */
+    for (unsigned k : events_not_after(i)) {
       v.emplace_back(branch_with_symbolic_data(k));
-    } else if (race.kind == Race::OBSERVED && k != j) {
-      if (!std::any_of(observers.begin(), observers.end(),
-                       [this,k](const Event* o){
-                         return o->clock.leq(prefix[k].clock); })){
-        if (is_observed_conflict(first, second, prefix[k])){
-          assert(!observers.empty() || k == race.witness_event);
-          observers.push_back(&prefix[k]);
-        } else if (race.kind == Race::OBSERVED) {
-          notobs.emplace_back(branch_with_symbolic_data(k));
+    }
+  } else {
+    for (int k = i + 1; k < int(prefix.len()); ++k){
+      if (!first.clock.leq(prefix[k].clock)) {
+        v.emplace_back(branch_with_symbolic_data(k));
+      } else if (k != j) {
+        if (!std::any_of(observers.begin(), observers.end(),
+                         [this,k](const Event* o){
+                           return o->clock.leq(prefix[k].clock); })){
+          if (is_observed_conflict(first, second, prefix[k])){
+            assert(!observers.empty() || k == race.witness_event);
+            observers.push_back(&prefix[k]);
+          } else {
+            notobs.emplace_back(branch_with_symbolic_data(k));
+          }
         }
       }
     }
@@ -2167,6 +2261,37 @@ wakeup_sequence(const Race &race) const{
   return v;
 }
 
+std::vector<unsigned> TSOTraceBuilder::events_not_after(int i) const{
+  const VClock<IPid> &iclock = prefix[i].clock;
+  std::vector<unsigned> events;
+  for (const Thread &t : threads) {
+    const std::vector<unsigned> &ei = t.event_indices;
+    /* The first event of t after prefix[i] */
+    auto it = std::upper_bound(ei.begin(), ei.end(), unsigned(i));
+    while (it != ei.end()) {
+      unsigned k = *it;
+      if (iclock.leq(prefix[k].clock)) break;
+      events.push_back(k);
+      /* Skip the remaining IIDs of prefix[k] */
+      int next = prefix[k].iid.get_index() - 1 + prefix.branch(k).size;
+      assert(next > it - ei.begin() && next <= int(ei.size()));
+      it = ei.begin() + next;
+    }
+  }
+  std::sort(events.begin(), events.end());
+#ifndef NDEBUG
+  unsigned n = 0;
+  for (unsigned k = i+1; k < prefix.len(); ++k) {
+    if (!iclock.leq(prefix[k].clock)) {
+      assert(n < events.size() && events[n] == k);
+      ++n;
+    }
+  }
+  assert(n == events.size());
+#endif
+  return events;
+}
+
 std::vector<int> TSOTraceBuilder::iid_map_at(int event) const{
   std::vector<int> map(threads.size(), 1);
   for (int i = 0; i < event; ++i) {
@@ -2239,7 +2364,7 @@ inline unsigned TSOTraceBuilder::find_process_event(IPid pid, int index) const{
 }
 
 bool TSOTraceBuilder::has_pending_store(IPid pid, SymAddr ml) const {
-  const std::vector<PendingStore> &sb = threads[pid].store_buffer;
+  const RingBuffer<PendingStore> &sb = threads[pid].store_buffer;
   for(unsigned i = 0; i < sb.size(); ++i){
     if(sb[i].ml.includes(ml)){
       return true;
@@ -2254,22 +2379,33 @@ bool TSOTraceBuilder::has_pending_store(IPid pid, SymAddr ml) const {
 #  define IFDEBUG(X) ((void)0)
 #endif
 
+void TSOTraceBuilder::sleep_add_read(IPid pid, SymAddr b){
+  assert(threads[pid].sleeping);
+  if (threads[pid].sleep_accesses_r.insert(b).second)
+    sleep_readers[b].insert(pid);
+}
+
+void TSOTraceBuilder::sleep_add_write(IPid pid, SymAddr b){
+  assert(threads[pid].sleeping);
+  if (threads[pid].sleep_accesses_w.insert(b).second)
+    sleep_writers[b].insert(pid);
+}
+
 void TSOTraceBuilder::wakeup(Access::Type type, SymAddr ml){
   IPid pid = curev().iid.get_pid();
   IFDEBUG(sym_ty ev);
-  std::vector<IPid> wakeup; // Wakeup these
+  ThreadSet wake = sleep_fullmem;
   switch(type){
   case Access::W_ALL_MEMORY:
     {
       IFDEBUG(ev.push_back(SymEv::Fullmem()));
       for(unsigned p = 0; p < threads.size(); ++p){
-        if(threads[p].sleep_full_memory_conflict ||
-           threads[p].sleep_accesses_w.size()){
-          wakeup.push_back(p);
+        if(threads[p].sleep_accesses_w.size()){
+          wake.insert(p);
         }else{
           for(SymAddr b : threads[p].sleep_accesses_r){
             if(!has_pending_store(p,b)){
-              wakeup.push_back(p);
+              wake.insert(p);
               break;
             }
           }
@@ -2280,12 +2416,11 @@ void TSOTraceBuilder::wakeup(Access::Type type, SymAddr ml){
   case Access::R:
     {
       IFDEBUG(ev.push_back(SymEv::Load(SymAddrSize(ml,1))));
-      for(unsigned p = 0; p < threads.size(); ++p){
-        if(threads[p].sleep_full_memory_conflict ||
-           (int(p) != pid+1 &&
-            threads[p].sleep_accesses_w.count(ml))){
-          wakeup.push_back(p);
-        }
+      auto w = sleep_writers.find(ml);
+      if (w != sleep_writers.end()) {
+        ThreadSet writers = w->second;
+        writers.erase(pid+1);
+        wake |= writers;
       }
       break;
     }
@@ -2293,20 +2428,26 @@ void TSOTraceBuilder::wakeup(Access::Type type, SymAddr ml){
     {
       /* We don't pick the right value, but it should not matter */
       IFDEBUG(ev.push_back(SymEv::Store({SymAddrSize(ml,1), 1})));
-      for(unsigned p = 0; p < threads.size(); ++p){
-        if(threads[p].sleep_full_memory_conflict ||
-           (int(p) + 1 != pid &&
-            (threads[p].sleep_accesses_w.count(ml) ||
-             (threads[p].sleep_accesses_r.count(ml) &&
-              !has_pending_store(p,ml))))){
-          wakeup.push_back(p);
-        }
+      ThreadSet conflicting;
+      auto w = sleep_writers.find(ml);
+      if (w != sleep_writers.end()) conflicting = w->second;
+      auto r = sleep_readers.find(ml);
+      if (r != sleep_readers.end()) {
+        r->second.for_each([&](IPid p){
+            if (!has_pending_store(p,ml)) conflicting.insert(p);
+          });
       }
+      /* Excludes the real thread of an update. There is no IPid
+       * pid-1 when the main thread writes. */
+      if (pid > 0) conflicting.erase(pid-1);
+      wake |= conflicting;
       break;
     }
   default:
     throw std::logic_error("TSOTraceBuilder::wakeup: Unknown type of memory access.");
   }
+  std::vector<IPid> wakeup; // Wakeup these
+  wake.for_each([&wakeup](IPid p){ wakeup.push_back(p); });
 
 #ifndef NDEBUG
   if (conf.dpor_algorithm != Configuration::SOURCE) {
@@ -2322,6 +2463,17 @@ void TSOTraceBuilder::wakeup(Access::Type type, SymAddr ml){
 
   for(IPid p : wakeup){
     assert(threads[p].sleeping);
+    for (SymAddr b : threads[p].sleep_accesses_r) {
+      auto it = sleep_readers.find(b);
+      it->second.erase(p);
+      if (it->second.empty()) sleep_readers.erase(it);
+    }
+    for (SymAddr b : threads[p].sleep_accesses_w) {
+      auto it = sleep_writers.find(b);
+      it->second.erase(p);
+      if (it->second.empty()) sleep_writers.erase(it);
+    }
+    sleep_fullmem.erase(p);
     threads[p].sleep_accesses_r.clear();
     threads[p].sleep_accesses_w.clear();
     threads[p].sleep_full_memory_conflict = false;
@@ -2331,143 +2483,33 @@ void TSOTraceBuilder::wakeup(Access::Type type, SymAddr ml){
   }
 }
 
-bool TSOTraceBuilder::has_cycle(IID<IPid> *loc) const{
-  int proc_count = threads.size();
-  int pfx_size = prefix.len();
-
-  /* Identify all store events */
-  struct stupd_t{
-    /* The index part of the IID identifying a store event. */
-    int store;
-    /* The index in prefix of the corresponding update event. */
-    int update;
-  };
-  /* stores[proc] is all store events of process proc, ordered by
-   * store index.
-   */
-  std::vector<std::vector<stupd_t> > stores(proc_count);
-  for(int i = 0; i < pfx_size; ++i){
-    if(prefix[i].iid.get_pid() % 2){ // Update
-      assert(prefix[i].origin_iid.get_pid()
-             == prefix[i].iid.get_pid()-1);
-      stores[prefix[i].iid.get_pid() / 2].push_back
-        ({prefix[i].origin_iid.get_index(),i});
-    }
-  }
-
-  /* Attempt to replay computation under SC */
-  struct proc_t {
-    proc_t()
-      : pc(0), pfx_index(0), store_index(0), blocked(false), block_clock() {};
-    int pc; // Current program counter
-    int pfx_index; // Index into prefix
-    int store_index; // Index into stores
-    bool blocked; // Is the process currently blocked?
-    VClock<IPid> block_clock; // If blocked, what are we waiting for?
-  };
-  std::vector<proc_t> procs(proc_count);
-
-  int proc = 0; // The next scheduled process
-  /* alive keeps track of whether any process has been successfully
-   * scheduled lately
-   */
-  bool alive = false;
-  while(true){
-    // Advance pfx_index to the right Event in prefix
-    while(procs[proc].pfx_index < pfx_size &&
-          prefix[procs[proc].pfx_index].iid.get_pid() != proc*2){
-      ++procs[proc].pfx_index;
-    }
-    if(pfx_size <= procs[proc].pfx_index){
-      // This process is finished
-      proc = (proc+1)%proc_count;
-      if(proc == 0){
-        if(!alive) break;
-        alive = false;
-      }
-      continue;
-    }
-
-    int next_pc = procs[proc].pc+1;
-    const Event &evt = prefix[procs[proc].pfx_index];
-    const Branch &branch = prefix.branch(procs[proc].pfx_index);
-
-    if(!procs[proc].blocked){
-      assert(evt.iid.get_pid() == 2*proc);
-      assert(evt.iid.get_index() <= next_pc);
-      assert(next_pc < evt.iid.get_index() + branch.size);
-      procs[proc].block_clock = evt.clock;
-      assert(procs[proc].block_clock[proc*2] <= next_pc);
-      procs[proc].block_clock[proc*2] = next_pc;
-      if(procs[proc].store_index < int(stores[proc].size()) &&
-         stores[proc][procs[proc].store_index].store == next_pc){
-        // This is a store. Also consider the update's clock.
-        procs[proc].block_clock
-          += prefix[stores[proc][procs[proc].store_index].update].clock;
-        ++procs[proc].store_index;
-      }
-    }
-
-    // Is this process blocked?
-    // Is there some process we have to wait for?
-    {
-      int i;
-      procs[proc].blocked = false;
-      for(i = 0; i < proc_count; ++i){
-        if(i != proc && procs[i].pc < procs[proc].block_clock[i*2]){
-          procs[proc].blocked = true;
-          break;
-        }
-      }
-    }
-
-    // Are we still blocked?
-    if(procs[proc].blocked){
-      proc = (proc+1)%proc_count; // Try another process
-      if(proc == 0){
-        if(!alive) break;
-        alive = false;
-      }
-    }else{
-      alive = true;
-      procs[proc].pc = next_pc;
-      assert(next_pc == procs[proc].block_clock[proc*2]);
-
-      // Advance pc to next interesting event
-      next_pc = evt.iid.get_index() + branch.size - 1;
-      if(procs[proc].store_index < int(stores[proc].size()) &&
-         stores[proc][procs[proc].store_index].store-1 < next_pc){
-        next_pc = stores[proc][procs[proc].store_index].store-1;
-      }
-      assert(procs[proc].pc <= next_pc);
-      procs[proc].pc = next_pc;
-
-      if(next_pc + 1 == evt.iid.get_index() + branch.size){
-        // We are done with this Event
-        ++procs[proc].pfx_index;
-      }
-    }
-  }
-
-  // Did all processes finish, or are some still blocked?
-  {
-    int upd_idx = -1; // Index of the latest update involved in a cycle
-    bool has_cycle = false;
-    for(int i = 0; i < proc_count; ++i){
-      if(procs[i].blocked){
-        // There is a cycle
-        has_cycle = true;
-        int next_pc = procs[i].pc+1;
-        if(0 < procs[i].store_index && stores[i][procs[i].store_index-1].store == next_pc){
-          if(stores[i][procs[i].store_index-1].update > upd_idx){
-            upd_idx = stores[i][procs[i].store_index-1].update;
-            *loc = prefix[upd_idx].iid;
-          }
-        }
-      }
-    }
-    assert(!has_cycle || 0 <= upd_idx);
-    return has_cycle;
+void TSOTraceBuilder::robustness_add_event(){
+  if(!conf.check_robustness) return;
+  IPid pid = curev().iid.get_pid();
+  int node = cycle_detector.add_node();
+  assert(node == prefix_idx);
+  if(pid % 2){ // An update takes effect at its store event
+    assert(threads[pid-1].store_buffer.size());
+    node = threads[pid-1].store_buffer.front().store_event;
+  }
+  assert(int(robustness_node.size()) == prefix_idx);
+  robustness_node.push_back(node);
+
+  const std::vector<unsigned> &evs = threads[pid].event_indices;
+  assert(evs.size() && int(evs.back()) == prefix_idx);
+  if(evs.size() > 1){
+    robustness_add_edge(evs[evs.size()-2], prefix_idx);
+  }else if(0 <= threads[pid].spawn_event){
+    robustness_add_edge(threads[pid].spawn_event, prefix_idx);
+  }
+}
+
+void TSOTraceBuilder::robustness_add_edge(int first, int second){
+  if(!conf.check_robustness || 0 <= cycle_event) return;
+  int from = robustness_node[first];
+  int to = robustness_node[second];
+  if(from != to && !cycle_detector.add_edge(from,to)){
+    cycle_event = second;
   }
 }
 
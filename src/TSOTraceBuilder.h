@@ -22,11 +22,15 @@
 #define __TSO_TRACE_BUILDER_H__
 
 #include "TSOPSOTraceBuilder.h"
+#include "IncrementalCycleDetector.h"
+#include "RingBuffer.h"
 #include "VClock.h"
 #include "SymEv.h"
 #include "WakeupTrees.h"
 #include "Option.h"
 
+#include <unordered_map>
+
 typedef llvm::SmallVector<SymEv,1> sym_ty;
 
 class TSOTraceBuilder : public TSOPSOTraceBuilder{
@@ -149,7 +153,7 @@ protected:
      *
      * Newer entries are further to the back.
      */
-    std::vector<PendingStore> store_buffer;
+    RingBuffer<PendingStore> store_buffer;
     /* True iff this thread is currently in the sleep set. */
     bool sleeping;
     /* sleep_accesses_r is the set of bytes that will be read by the
@@ -193,6 +197,60 @@ protected:
   /* The CPids of threads in the current execution. */
   CPidSystem CPS;
 
+  /* A set of IPids, represented as a bitset. */
+  class ThreadSet{
+  public:
+    bool count(IPid p) const {
+      return unsigned(p/64) < words.size() && (words[p/64] >> (p%64)) & 1;
+    }
+    void insert(IPid p) {
+      assert(p >= 0);
+      if (words.size() <= unsigned(p/64)) words.resize(p/64+1, 0);
+      words[p/64] |= uint64_t(1) << (p%64);
+    }
+    void erase(IPid p) {
+      assert(p >= 0);
+      if (unsigned(p/64) < words.size()) words[p/64] &= ~(uint64_t(1) << (p%64));
+    }
+    bool empty() const {
+      for (uint64_t w : words) if (w) return false;
+      return true;
+    }
+    void clear() { words.clear(); }
+    ThreadSet &operator|=(const ThreadSet &s) {
+      if (words.size() < s.words.size()) words.resize(s.words.size(), 0);
+      for (unsigned i = 0; i < s.words.size(); ++i) words[i] |= s.words[i];
+      return *this;
+    }
+    /* Calls f(p) for each p in the set, in increasing order. */
+    template <typename F> void for_each(F f) const {
+      for (unsigned i = 0; i < words.size(); ++i) {
+        for (uint64_t w = words[i]; w; w &= w - 1) {
+          f(IPid(i*64 + __builtin_ctzll(w)));
+        }
+      }
+    }
+  private:
+    std::vector<uint64_t> words;
+  };
+  /* Inverted indices of the sleep sets of threads. sleep_readers
+   * (sleep_writers) maps each byte in Thread::sleep_accesses_r
+   * (sleep_accesses_w) of some sleeping thread to the set of such
+   * threads. sleep_fullmem is the set of sleeping threads with
+   * Thread::sleep_full_memory_conflict.
+   *
+   * Used by wakeup to find the threads to wake without visiting every
+   * thread.
+   */
+  std::unordered_map<SymAddr,ThreadSet> sleep_readers;
+  std::unordered_map<SymAddr,ThreadSet> sleep_writers;
+  ThreadSet sleep_fullmem;
+  /* Records that the next event of the sleeping thread pid reads
+   * (writes) the byte b.
+   */
+  void sleep_add_read(IPid pid, SymAddr b);
+  void sleep_add_write(IPid pid, SymAddr b);
+
   /* A ByteInfo object contains information about one byte in
    * memory. In particular, it recalls which events have recently
    * accessed that byte.
@@ -378,6 +436,25 @@ protected:
    */
   std::vector<Race> lock_fail_races;
 
+  /* When conf.check_robustness is set, the happens-before edges of the
+   * current computation are entered into cycle_detector as they are
+   * found, so that a cycle is detected as soon as it is closed.
+   *
+   * The nodes of cycle_detector are the indices into prefix. The
+   * edges of an update are attached to the node of its store event
+   * instead of its own node, since that is where the store would take
+   * effect under SC.
+   */
+  IncrementalCycleDetector cycle_detector;
+  /* robustness_node[i] is the node of cycle_detector which represents
+   * the event prefix[i].
+   */
+  std::vector<int> robustness_node;
+  /* The index into prefix of the event whose happens-before edges
+   * closed a cycle in this computation, or -1 if there is no cycle.
+   */
+  int cycle_event;
+
   /* Information about a (short) sequence of consecutive events by the
    * same thread. At most one event in the sequence may have conflicts
    * with other events, and if the sequence has a conflicting event,
@@ -623,6 +700,16 @@ protected:
    * computed.
    */
   void do_race_detect();
+  /* Performs Optimal-DPOR race detection for the races in races, where
+   * races[i] are the races whose first event is prefix[i].
+   *
+   * Wakeup sequences and sleep set checks only read prefix, and are
+   * computed by conf.n_threads threads. The wakeup sequences are then
+   * inserted into the wakeup tree in the same order as by
+   * do_race_detect.
+   */
+  void do_race_detect_parallel
+  (const std::vector<std::vector<const Race*>> &races);
   /* Records a symbolic representation of the current event.
    */
   void record_symbolic(SymEv event);
@@ -687,8 +774,20 @@ protected:
   void obs_sleep_wake(struct obs_sleep &sleep, const Event &e) const;
   void race_detect(const Race&, const struct obs_sleep&);
   void race_detect_optimal(const Race&, const struct obs_sleep&);
+  /* Inserts the wakeup sequence v into the wakeup tree at prefix[i]. */
+  void insert_wakeup_sequence(int i, std::vector<Branch> v);
   /* Compute the wakeup sequence for reversing a race. */
   std::vector<Branch> wakeup_sequence(const Race&) const;
+  /* Returns the indices, in increasing order, of the events in prefix
+   * after prefix[i] that do not happen after prefix[i].
+   *
+   * Since the events of a thread that happen after prefix[i] form a
+   * suffix of its events, only the other events of each thread are
+   * visited, using Thread::event_indices. The cost is thus
+   * proportional to the number of returned events, rather than to the
+   * length of prefix.
+   */
+  std::vector<unsigned> events_not_after(int i) const;
   /* Checks if a sequence of events will clear a sleep set. */
   bool sequence_clears_sleep(const std::vector<Branch> &seq,
                              const struct obs_sleep &sleep) const;
@@ -699,8 +798,15 @@ protected:
    * memory location including the byte ml.
    */
   bool has_pending_store(IPid pid, SymAddr ml) const;
-  /* Helper for check_for_cycles. */
-  bool has_cycle(IID<IPid> *loc) const;
+  /* Enters the event prefix[prefix_idx], which has just been
+   * scheduled, into cycle_detector, together with its edges from the
+   * previous event of the same thread.
+   */
+  void robustness_add_event();
+  /* Enters the happens-before edge from prefix[first] to
+   * prefix[second] into cycle_detector.
+   */
+  void robustness_add_edge(int first, int second);
   /* Estimate the total number of traces that have the same prefix as
    * the current one, up to the first idx events.
    */
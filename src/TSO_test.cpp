@@ -26,6 +26,8 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <sstream>
+
 BOOST_AUTO_TEST_SUITE(TSO_test)
 
 BOOST_AUTO_TEST_CASE(Minimal_computation){
@@ -3647,6 +3649,76 @@ declare i32 @pthread_create(i64*,%attr_t*,i8*(i8*)*,i8*) nounwind
                                                 ));
 }
 
+BOOST_AUTO_TEST_CASE(Wakeup_by_main_thread_63){
+  /* Thread number w stores to x, while main updates x with an atomic
+   * exchange, which main's real thread (IPid 0) executes. With w = 31,
+   * the store buffer of w is flushed by IPid 63, which must be woken
+   * from its sleep set by the exchange just like IPid 61 for w = 30.
+   */
+  uint64_t blocked[2];
+  for(int w : {30, 31}){
+    std::stringstream ss;
+    ss << "@x = global i32 0, align 4\n"
+       << "define i8* @filler(i8* %arg){\n"
+       << "  ret i8* null\n"
+       << "}\n"
+       << "define i8* @w(i8* %arg){\n"
+       << "  store i32 1, i32* @x, align 4\n"
+       << "  ret i8* null\n"
+       << "}\n"
+       << "define i32 @main(){\n";
+    for(int i = 1; i <= 31; ++i){
+      ss << "  call i32 @pthread_create(i64* null, %attr_t* null, i8*(i8*)* "
+         << (i == w ? "@w" : "@filler") << ", i8* null)\n";
+    }
+    ss << "  atomicrmw xchg i32* @x, i32 2 seq_cst\n"
+       << "  ret i32 0\n"
+       << "}\n"
+       << "%attr_t = type {i64, [48 x i8]}\n"
+       << "declare i32 @pthread_create(i64*,%attr_t*,i8*(i8*)*,i8*) nounwind\n";
+    Configuration conf = DPORDriver_test::get_tso_conf();
+    DPORDriver *driver = DPORDriver::parseIR(StrModule::portasm(ss.str()),conf);
+    DPORDriver::Result res = driver->run();
+    delete driver;
+    BOOST_CHECK_MESSAGE(res.trace_count == 2,
+                        "w = " << w << ": " << res.trace_count << " traces");
+    blocked[w-30] = res.sleepset_blocked_trace_count;
+  }
+  BOOST_CHECK_EQUAL(blocked[0], blocked[1]);
+}
+
+BOOST_AUTO_TEST_CASE(Parallel_race_detect_many_races){
+  /* Main loads @x 150 times after starting @w, which stores to @x
+   * once. When the store is flushed first, every load races with the
+   * flush, giving 150 races on one trace: more than the 64 races per
+   * helper thread that race detection needs to split the work. There
+   * are 151 traces, one per position of the flush among the loads.
+   */
+  std::string loads;
+  for(int i = 0; i < 150; ++i){
+    loads += "  load i32, i32* @x, align 4\n";
+  }
+  Configuration conf = DPORDriver_test::get_tso_conf();
+  conf.dpor_algorithm = Configuration::OPTIMAL;
+  DPORDriver_test::check_parallel_equiv(R"(
+@x = global i32 0, align 4
+
+define i8* @w(i8* %arg){
+  store i32 1, i32* @x, align 4
+  ret i8* null
+}
+
+define i32 @main(){
+  call i32 @pthread_create(i64* null, %attr_t* null, i8*(i8*)* @w, i8* null)
+)" + loads + R"(
+  ret i32 0
+}
+
+%attr_t = type {i64, [48 x i8]}
+declare i32 @pthread_create(i64*,%attr_t*,i8*(i8*)*,i8*) nounwind
+)",conf,151,4);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 #endif
@@ -19,30 +19,220 @@
 
 #ifndef NO_TIMING
 
+#include "Debug.h"
+#include "Json.h"
 #include "Timing.h"
 #include <vector>
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+#ifdef HAVE_LINUX_PERF_EVENT_H
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 #include <llvm/Support/CommandLine.h>
 
 namespace Timing {
   namespace impl {
     bool is_enabled;
+    bool is_recording;
+    bool is_perf_enabled;
+    bool perf_unavailable = false;
+    void (*perf_fake_read)(uint64_t vals[PERF_COUNTER_COUNT]) = nullptr;
   }
   namespace {
     Context *all_contexts = nullptr;
     clock global_clock;
     thread_local Guard *current_guard = nullptr;
+    std::atomic<unsigned> thread_count(0);
+    thread_local unsigned thread_index = thread_count++;
 
     llvm::cl::opt<bool, true>
     cl_time("time", llvm::cl::desc("Print timing information."),
             llvm::cl::NotHidden, llvm::cl::location(impl::is_enabled));
+
+    llvm::cl::opt<bool, true>
+    cl_time_perf("time-perf",
+                 llvm::cl::desc("With --time, also count cycles, instructions,\n"
+                                "LLC misses and branch misses (Linux only)."),
+                 llvm::cl::NotHidden, llvm::cl::location(impl::is_perf_enabled));
+
+    const char *const perf_counter_names[PERF_COUNTER_COUNT] =
+      {"Cycles", "Instrs", "LLC-miss", "Br-miss"};
+
+    /* The perf event group of one thread. The group is opened when the
+     * thread first enters a Guard with perf enabled. If the group
+     * could not be opened, leader < 0 and all counts read as zero.
+     */
+    struct PerfGroup {
+      PerfGroup() : leader(-2), n(0) {
+        for (int i = 0; i < PERF_COUNTER_COUNT; ++i) pos[i] = -1;
+      }
+      ~PerfGroup() {
+#ifdef HAVE_LINUX_PERF_EVENT_H
+        for (int fd : fds) close(fd);
+#endif
+      }
+      int leader;
+      /* The file descriptors of the opened counters. */
+      std::vector<int> fds;
+      /* The number of opened counters, and the position of each
+       * PerfCounter in a read of the group, or -1 if it could not be
+       * opened. */
+      int n;
+      int pos[PERF_COUNTER_COUNT];
+    };
+    thread_local PerfGroup perf_group;
+    std::once_flag perf_warning;
+
+    void perf_warn(const std::string &what) {
+      std::call_once(perf_warning, [&what]() {
+                                     Debug::warn("Timing::perf")
+                                       << "WARNING: --time-perf: " << what << "\n";
+                                   });
+    }
+
+    void perf_open(PerfGroup &g) {
+      if (impl::perf_unavailable) {
+        g.leader = -1;
+        perf_warn("Perf events are unavailable. Counts will be zero.");
+        return;
+      }
+#ifdef HAVE_LINUX_PERF_EVENT_H
+      const uint64_t configs[PERF_COUNTER_COUNT] =
+        {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+         PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+      g.leader = -1;
+      for (int i = 0; i < PERF_COUNTER_COUNT; ++i) {
+        struct perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = configs[i];
+        attr.read_format = PERF_FORMAT_GROUP;
+        /* Counting user space only works with perf_event_paranoid <= 2 */
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        int fd = syscall(__NR_perf_event_open, &attr, 0, -1, g.leader, 0);
+        if (fd < 0) {
+          if (g.leader < 0) {
+            perf_warn(std::string("Could not open perf events (")
+                      + std::strerror(errno) + "). Counts will be zero.");
+            return;
+          }
+          perf_warn(std::string("Counter ") + perf_counter_names[i]
+                    + " is unavailable (" + std::strerror(errno) + ").");
+          continue;
+        }
+        if (g.leader < 0) g.leader = fd;
+        g.fds.push_back(fd);
+        g.pos[i] = g.n++;
+      }
+#else
+      g.leader = -1;
+      perf_warn("Perf events are not supported on this system.");
+#endif
+    }
+
+    /* Stores the current values of the counters of this thread in vals. */
+    void perf_read(uint64_t vals[PERF_COUNTER_COUNT]) {
+      for (int i = 0; i < PERF_COUNTER_COUNT; ++i) vals[i] = 0;
+      if (impl::perf_fake_read) {
+        impl::perf_fake_read(vals);
+        return;
+      }
+      PerfGroup &g = perf_group;
+      if (g.leader == -2) perf_open(g);
+#ifdef HAVE_LINUX_PERF_EVENT_H
+      if (g.leader < 0) return;
+      /* With PERF_FORMAT_GROUP: The number of counters, followed by
+       * their values. */
+      uint64_t buf[1 + PERF_COUNTER_COUNT];
+      if (read(g.leader, buf, sizeof(buf)) < ssize_t((1 + g.n) * sizeof(uint64_t))) {
+        return;
+      }
+      for (int i = 0; i < PERF_COUNTER_COUNT; ++i) {
+        if (0 <= g.pos[i]) vals[i] = buf[1 + g.pos[i]];
+      }
+#endif
+    }
+
+    llvm::cl::opt<std::string>
+    cl_time_trace("time-trace", llvm::cl::NotHidden, llvm::cl::value_desc("FILE"),
+                  llvm::cl::desc("Record a timeline of the timing contexts of\n"
+                                 "--time, and write it to FILE at exit."));
+
+    llvm::cl::opt<TraceFormat>
+    cl_time_trace_format
+    ("time-trace-format", llvm::cl::NotHidden, llvm::cl::init(TRACE_CHROME),
+     llvm::cl::desc("Format of --time-trace"),
+     llvm::cl::values(clEnumValN(TRACE_CHROME, "chrome",
+                                 "Chrome trace-event JSON (default)"),
+                      clEnumValN(TRACE_COLLAPSED, "collapsed",
+                                 "Collapsed stacks, for flame graphs")
+#ifdef LLVM_CL_VALUES_USES_SENTINEL
+                      ,clEnumValEnd
+#endif
+                      ));
+
+    llvm::cl::opt<unsigned>
+    cl_time_trace_buffer("time-trace-buffer", llvm::cl::NotHidden,
+                         llvm::cl::init(1 << 18), llvm::cl::value_desc("N"),
+                         llvm::cl::desc("With --time-trace, keep the last N spans\n"
+                                        "of each thread (default 262144)."));
+
+    /* A span is one completed Guard, with times relative to
+     * trace_epoch. */
+    struct Span {
+      Context *context;
+      clock::duration start, end;
+    };
+    clock::time_point trace_epoch = global_clock.now();
+
+    /* The spans recorded by one thread. Only the owning thread writes
+     * to it. When capacity spans have been recorded, each new span
+     * overwrites the oldest one.
+     */
+    struct TraceBuffer {
+      unsigned thread;
+      std::vector<Span> spans;
+      /* When spans is full, the index of the oldest span. */
+      std::size_t next = 0;
+      TraceBuffer *next_buffer;
+    };
+    std::atomic<TraceBuffer*> all_buffers(nullptr);
+    thread_local TraceBuffer *my_buffer = nullptr;
+
+    void record(Context *c, clock::time_point start, clock::time_point end) {
+      TraceBuffer *b = my_buffer;
+      if (!b) {
+        b = my_buffer = new TraceBuffer();
+        b->thread = thread_index;
+        b->next_buffer = all_buffers.load(std::memory_order_relaxed);
+        while (!all_buffers.compare_exchange_weak
+               (b->next_buffer, b, std::memory_order_release,
+                std::memory_order_relaxed)) {}
+      }
+      Span s = {c, start - trace_epoch, end - trace_epoch};
+      if (b->spans.size() < cl_time_trace_buffer) {
+        b->spans.push_back(s);
+      } else if (b->spans.size()) {
+        b->spans[b->next] = s;
+        if (++b->next == b->spans.size()) b->next = 0;
+      }
+    }
   }
 
   Context::Context(std::string name)
-    : name(name), next(all_contexts) {
+    : name(name), next(all_contexts), first_thread(nullptr) {
     all_contexts = this;
   }
 
@@ -57,17 +247,29 @@ namespace Timing {
     Thread *t = my_thread.get();
     if (!t) {
       t = new Thread();
+      t->index = thread_index;
       t->next = first_thread.load(std::memory_order_relaxed);
       while (!first_thread.compare_exchange_weak
-             (t->next, t, std::memory_order_relaxed)) {}
+             (t->next, t, std::memory_order_release,
+              std::memory_order_relaxed)) {}
+      my_thread.set(t);
     }
     return t;
   }
 
-  Context::Thread::Thread() : inclusive(0), exclusive(0), count(0) {}
+  Context::Thread::Thread() : inclusive(0), exclusive(0), count(0), index(0) {
+    for (int i = 0; i < PERF_COUNTER_COUNT; ++i) {
+      perf_inclusive[i] = 0;
+      perf_exclusive[i] = 0;
+    }
+  }
 
   void Guard::begin(Context *c) {
     context = c;
+    if (impl::is_perf_enabled) {
+      perf_read(perf_start);
+      for (int i = 0; i < PERF_COUNTER_COUNT; ++i) subcontext_perf[i] = 0;
+    }
     start = global_clock.now();
     outer_scope = current_guard;
     current_guard = this;
@@ -78,13 +280,32 @@ namespace Timing {
     clock::duration inclusive = end - start;
     clock::duration exclusive = inclusive - subcontext_time;
     Context::Thread *t = context->get_thread();
-    t->inclusive += inclusive;
-    t->exclusive += exclusive;
-    t->count++;
+    /* Only this thread writes t, so there is no need for atomic
+     * read-modify-write. */
+    t->inclusive.store(t->inclusive.load(std::memory_order_relaxed)
+                       + inclusive.count(), std::memory_order_relaxed);
+    t->exclusive.store(t->exclusive.load(std::memory_order_relaxed)
+                       + exclusive.count(), std::memory_order_relaxed);
+    t->count.store(t->count.load(std::memory_order_relaxed) + 1,
+                   std::memory_order_relaxed);
     if (outer_scope) {
       outer_scope->subcontext_time += inclusive;
     }
+    if (impl::is_perf_enabled) {
+      uint64_t now[PERF_COUNTER_COUNT];
+      perf_read(now);
+      for (int i = 0; i < PERF_COUNTER_COUNT; ++i) {
+        uint64_t incl = now[i] - perf_start[i];
+        t->perf_inclusive[i].store(t->perf_inclusive[i].load(std::memory_order_relaxed)
+                                   + incl, std::memory_order_relaxed);
+        t->perf_exclusive[i].store(t->perf_exclusive[i].load(std::memory_order_relaxed)
+                                   + (incl - subcontext_perf[i]),
+                                   std::memory_order_relaxed);
+        if (outer_scope) outer_scope->subcontext_perf[i] += incl;
+      }
+    }
     current_guard = outer_scope;
+    if (impl::is_recording) record(context, start, end);
   }
 
   void print_report() {
@@ -94,6 +315,7 @@ namespace Timing {
       Context *c;
       clock::duration inclusive, exclusive;
       unsigned long count = 0;
+      uint64_t perf[PERF_COUNTER_COUNT] = {0};
     };
     std::vector<result> vec;
     for (Context *c = all_contexts; c; c = c->next) {
@@ -101,9 +323,12 @@ namespace Timing {
       result &res = vec.back();
       for (Context::Thread *t = c->first_thread.load(std::memory_order_relaxed);
            t; t = t->next) {
-        res.count += t->count;
-        res.inclusive += t->inclusive;
-        res.exclusive += t->exclusive;
+        res.count += t->count.load(std::memory_order_relaxed);
+        res.inclusive += clock::duration(t->inclusive.load(std::memory_order_relaxed));
+        res.exclusive += clock::duration(t->exclusive.load(std::memory_order_relaxed));
+        for (int i = 0; i < PERF_COUNTER_COUNT; ++i) {
+          res.perf[i] += t->perf_exclusive[i].load(std::memory_order_relaxed);
+        }
       }
     }
     std::sort(vec.begin(), vec.end(), [](const result &a, const result &b) {
@@ -114,17 +339,139 @@ namespace Timing {
     std::cerr << std::setw(22) << (N)         \
               << std::setw(10) << (C)         \
               << std::setw(12) << (I)         \
-              << std::setw(12) << (E) << "\n"
+              << std::setw(12) << (E)
+    /* With --time-perf, the exclusive counts follow the times */
     OUT("Name", "Count", "Inclusive", "Exclusive");
+    if (perf_enabled()) {
+      for (const char *name : perf_counter_names) std::cerr << std::setw(14) << name;
+      std::cerr << std::setw(6) << "IPC";
+    }
+    std::cerr << "\n";
     for (result &r : vec) {
       using namespace std::chrono;
       OUT(r.c->name, r.count,
           duration_cast<microseconds>(r.inclusive).count(),
           duration_cast<microseconds>(r.exclusive).count());
+      if (perf_enabled()) {
+        for (uint64_t v : r.perf) std::cerr << std::setw(14) << v;
+        std::cerr << std::setw(6) << std::fixed << std::setprecision(2)
+                  << (r.perf[PERF_CYCLES]
+                      ? double(r.perf[PERF_INSTRUCTIONS]) / r.perf[PERF_CYCLES]
+                      : 0.0);
+      }
+      std::cerr << "\n";
     }
 #undef OUT
   }
 
+  std::vector<Sample> sample() {
+    typedef std::chrono::duration<double> seconds;
+    std::vector<Sample> vec;
+    for (Context *c = all_contexts; c; c = c->next) {
+      for (Context::Thread *t = c->first_thread.load(std::memory_order_acquire);
+           t; t = t->next) {
+        clock::duration incl(t->inclusive.load(std::memory_order_relaxed));
+        clock::duration excl(t->exclusive.load(std::memory_order_relaxed));
+        vec.push_back({c->name, t->index,
+                       std::chrono::duration_cast<seconds>(incl).count(),
+                       std::chrono::duration_cast<seconds>(excl).count(),
+                       t->count.load(std::memory_order_relaxed), {}, {}});
+        for (int i = 0; i < PERF_COUNTER_COUNT; ++i) {
+          vec.back().perf_inclusive[i] = t->perf_inclusive[i].load(std::memory_order_relaxed);
+          vec.back().perf_exclusive[i] = t->perf_exclusive[i].load(std::memory_order_relaxed);
+        }
+      }
+    }
+    std::sort(vec.begin(), vec.end(), [](const Sample &a, const Sample &b) {
+                                        if (a.name != b.name) return a.name < b.name;
+                                        return a.thread < b.thread;
+                                      });
+    return vec;
+  }
+
+
+  void enable() {
+    impl::is_enabled = true;
+    impl::is_recording = trace_enabled();
+  }
+
+  bool trace_enabled() { return cl_time_trace != ""; }
+
+  namespace {
+    /* The spans of b, sorted so that each span comes after all spans
+     * enclosing it. */
+    std::vector<Span> sorted_spans(const TraceBuffer *b) {
+      std::vector<Span> spans(b->spans);
+      std::sort(spans.begin(), spans.end(), [](const Span &x, const Span &y) {
+                                              if (x.start != y.start) return x.start < y.start;
+                                              return x.end > y.end;
+                                            });
+      return spans;
+    }
+
+    double microseconds(clock::duration d) {
+      return std::chrono::duration_cast
+        <std::chrono::duration<double, std::micro>>(d).count();
+    }
+  }
+
+  void write_trace() {
+    assert(impl::is_recording);
+    std::ofstream out(cl_time_trace);
+    write_trace(out, cl_time_trace_format);
+    if (!out) {
+      Debug::warn("Timing::write_trace")
+        << "WARNING: Failed to write timing trace to " << cl_time_trace << ".\n";
+    }
+  }
+
+  void write_trace(std::ostream &out, TraceFormat format) {
+    std::ios_base::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(3);
+    if (format == TRACE_CHROME) {
+      out << "{\"traceEvents\":[";
+      bool first = true;
+      for (TraceBuffer *b = all_buffers.load(std::memory_order_acquire);
+           b; b = b->next_buffer) {
+        for (const Span &s : sorted_spans(b)) {
+          out << (first ? "\n" : ",\n")
+              << "{\"name\":" << Json::quote(s.context->name)
+              << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << b->thread
+              << ",\"ts\":" << microseconds(s.start)
+              << ",\"dur\":" << microseconds(s.end - s.start) << "}";
+          first = false;
+        }
+      }
+      out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    } else {
+      /* Exclusive time of each stack of contexts. Spans whose enclosing
+       * span was overwritten in the ring buffer are counted as
+       * outermost. */
+      std::map<std::string, clock::duration> stacks;
+      for (TraceBuffer *b = all_buffers.load(std::memory_order_acquire);
+           b; b = b->next_buffer) {
+        /* The spans enclosing the current one, with their stacks */
+        std::vector<std::pair<Span, std::string>> open;
+        for (const Span &s : sorted_spans(b)) {
+          while (open.size() && open.back().first.end < s.end) open.pop_back();
+          std::string stack =
+            (open.empty() ? "thread " + std::to_string(b->thread)
+             : open.back().second) + ";" + s.context->name;
+          stacks[stack] += s.end - s.start;
+          if (open.size()) stacks[open.back().second] -= s.end - s.start;
+          open.emplace_back(s, std::move(stack));
+        }
+      }
+      for (const auto &pr : stacks) {
+        long us = long(microseconds(pr.second));
+        if (us > 0) out << pr.first << " " << us << "\n";
+      }
+    }
+    out.flags(flags);
+    out.precision(precision);
+  }
+
 }
 
 #endif /* !defined(NO_TIMING) */
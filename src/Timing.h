@@ -21,7 +21,9 @@
 #ifndef __TIMING_H__
 #define __TIMING_H__
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
 #ifdef NO_TIMING
 
@@ -40,12 +42,34 @@ namespace Timing {
   };
 
   constexpr bool timing_enabled() { return false; }
+  inline void enable() {}
+  inline bool trace_enabled() { return false; }
+  inline void write_trace() {}
+  inline bool perf_enabled() { return false; }
+
+  enum PerfCounter {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_COUNTER_COUNT
+  };
+
+  struct Sample {
+    std::string name;
+    unsigned thread;
+    double inclusive, exclusive;
+    unsigned long count;
+    uint64_t perf_inclusive[PERF_COUNTER_COUNT], perf_exclusive[PERF_COUNTER_COUNT];
+  };
+  inline std::vector<Sample> sample() { return {}; }
 }
 
 #else /* defined(NO_TIMING) */
 #include <chrono>
 #include <atomic>
 #include <memory>
+#include <ostream>
 #include <pthread.h>
 
 namespace Timing {
@@ -64,6 +88,27 @@ namespace Timing {
     };
 
     extern bool is_enabled;
+    extern bool is_recording;
+    extern bool is_perf_enabled;
+  }
+
+  /* The hardware performance counters that are read with --time-perf. */
+  enum PerfCounter {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_COUNTER_COUNT
+  };
+
+  namespace impl {
+    /* For testing --time-perf. If perf_fake_read is set, it is called
+     * to read the counters instead of the perf events. Otherwise, if
+     * perf_unavailable, opening the perf events of a thread fails as
+     * if they were not supported.
+     */
+    extern bool perf_unavailable;
+    extern void (*perf_fake_read)(uint64_t vals[PERF_COUNTER_COUNT]);
   }
 
   class Context {
@@ -74,10 +119,20 @@ namespace Timing {
     ~Context();
     std::string name;
     Context *next;
+    /* The times of this context in one thread. The fields are only
+     * written by the owning thread, but may be read by any thread
+     * (see sample()).
+     */
     struct Thread {
       Thread();
-      clock::duration inclusive, exclusive;
-      unsigned long count;
+      std::atomic<clock::rep> inclusive, exclusive;
+      std::atomic<unsigned long> count;
+      /* The counts of each PerfCounter, with --time-perf. */
+      std::atomic<uint64_t> perf_inclusive[PERF_COUNTER_COUNT];
+      std::atomic<uint64_t> perf_exclusive[PERF_COUNTER_COUNT];
+      /* The index of the owning thread, in the order in which threads
+       * first entered some context. */
+      unsigned index;
       Thread *next;
     };
     std::atomic<Thread*> first_thread;
@@ -103,10 +158,70 @@ namespace Timing {
     Guard *outer_scope;
     clock::duration subcontext_time;
     clock::time_point start;
+    /* With --time-perf, the counters at begin, and the counts spent in
+     * nested Guards. */
+    uint64_t perf_start[PERF_COUNTER_COUNT];
+    uint64_t subcontext_perf[PERF_COUNTER_COUNT];
   };
 
   void print_report();
   inline bool timing_enabled() { return impl::is_enabled; }
+  /* Enables timing, as if --time was given, and the recording of
+   * spans if --time-trace was given. Must be called before any Guard
+   * is created.
+   */
+  void enable();
+  /* True if --time-perf was given, and timing is enabled. Then each
+   * Guard also reads the hardware performance counters (see
+   * PerfCounter) of its thread, using Linux perf events. If perf
+   * events are unavailable (e.g. in a container), a warning is printed
+   * and the counts stay zero.
+   */
+  inline bool perf_enabled() { return impl::is_enabled && impl::is_perf_enabled; }
+
+  /* The times of one context in one thread. Times are in seconds. The
+   * perf counts are indexed by PerfCounter, and are zero unless
+   * perf_enabled().
+   */
+  struct Sample {
+    std::string name;
+    unsigned thread;
+    double inclusive, exclusive;
+    unsigned long count;
+    uint64_t perf_inclusive[PERF_COUNTER_COUNT], perf_exclusive[PERF_COUNTER_COUNT];
+  };
+  /* Returns the times collected so far of every context and thread
+   * that has entered it. May be called while other threads are
+   * running, in which case the result is not a consistent snapshot.
+   */
+  std::vector<Sample> sample();
+
+  /* True if --time-trace was given. Then, after enable(), every Guard
+   * is also recorded as a span (context, thread, start, end) in a
+   * ring buffer owned by its thread, which write_trace() dumps to the
+   * file given to --time-trace.
+   */
+  bool trace_enabled();
+  /* The formats of --time-trace-format. */
+  enum TraceFormat {
+    /* Chrome trace-event JSON (loadable in chrome://tracing or
+     * Perfetto). */
+    TRACE_CHROME,
+    /* Collapsed stacks with exclusive microseconds (for
+     * flamegraph.pl). */
+    TRACE_COLLAPSED
+  };
+  /* Writes the recorded spans to the file given to --time-trace, in
+   * the format given by --time-trace-format.
+   *
+   * Must not be called while other threads may still enter or leave
+   * Guards.
+   */
+  void write_trace();
+  /* Writes the recorded spans to out, in the format format. The same
+   * restriction as for write_trace() applies.
+   */
+  void write_trace(std::ostream &out, TraceFormat format);
 }
 
 #endif /* !defined(NO_TIMING) */
@@ -0,0 +1,378 @@
+/* Copyright (C) 2026 agent
+ *
+ * This file is part of Nidhugg.
+ *
+ * Nidhugg is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nidhugg is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#ifdef HAVE_BOOST_UNIT_TEST_FRAMEWORK
+#include <boost/test/unit_test.hpp>
+
+#include "Timing.h"
+
+#ifndef NO_TIMING
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <llvm/Support/raw_ostream.h>
+
+namespace {
+  /* Enables timing and span recording for the lifetime of the
+   * object. */
+  struct Recording {
+    Recording(){
+      Timing::impl::is_enabled = true;
+      Timing::impl::is_recording = true;
+    }
+    ~Recording(){
+      Timing::impl::is_enabled = false;
+      Timing::impl::is_recording = false;
+    }
+  };
+
+  void spend(){
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+
+  /* Enters outer, inner and innermost, each nested in the previous
+   * one, spending some time in each. */
+  void nest(Timing::Context &outer, Timing::Context &inner,
+            Timing::Context &innermost){
+    Timing::Guard g0(outer);
+    spend();
+    {
+      Timing::Guard g1(inner);
+      spend();
+      {
+        Timing::Guard g2(innermost);
+        spend();
+      }
+      spend();
+    }
+    spend();
+  }
+
+  std::vector<std::string> lines_of(const std::string &s){
+    std::vector<std::string> lines;
+    std::stringstream ss(s);
+    std::string line;
+    while(std::getline(ss,line)){
+      lines.push_back(line);
+    }
+    return lines;
+  }
+
+  /* Enables timing with --time-perf for the lifetime of the
+   * object. */
+  struct Perf {
+    Perf(){
+      Timing::impl::is_enabled = true;
+      Timing::impl::is_perf_enabled = true;
+    }
+    ~Perf(){
+      Timing::impl::is_enabled = false;
+      Timing::impl::is_perf_enabled = false;
+      Timing::impl::perf_unavailable = false;
+      Timing::impl::perf_fake_read = nullptr;
+    }
+  };
+
+  /* Redirects stderr to a temporary file for the lifetime of the
+   * object. */
+  struct CaptureStderr {
+    std::string path;
+    int saved_fd;
+    CaptureStderr(){
+      char buf[] = "/tmp/nidhugg_Timing_test_XXXXXX";
+      int fd = mkstemp(buf);
+      path = buf;
+      llvm::errs().flush();
+      saved_fd = dup(2);
+      dup2(fd,2);
+      close(fd);
+    }
+    ~CaptureStderr(){
+      restore();
+      unlink(path.c_str());
+    }
+    void restore(){
+      if(saved_fd < 0) return;
+      llvm::errs().flush();
+      dup2(saved_fd,2);
+      close(saved_fd);
+      saved_fd = -1;
+    }
+    /* Restores stderr, and returns what was written to it. */
+    std::string contents(){
+      restore();
+      std::ifstream is(path);
+      std::stringstream ss;
+      ss << is.rdbuf();
+      return ss.str();
+    }
+  };
+
+  /* The number of occurrences of t in s. */
+  int count_of(const std::string &s, const std::string &t){
+    int n = 0;
+    for(std::string::size_type p = s.find(t); p != std::string::npos;
+        p = s.find(t,p+1)){
+      ++n;
+    }
+    return n;
+  }
+
+  /* The samples of the context named name, summed over threads. */
+  Timing::Sample sample_of(const std::string &name){
+    Timing::Sample sum = {name, 0, 0, 0, 0, {}, {}};
+    for(const Timing::Sample &s : Timing::sample()){
+      if(s.name != name) continue;
+      sum.inclusive += s.inclusive;
+      sum.exclusive += s.exclusive;
+      sum.count += s.count;
+      for(int i = 0; i < Timing::PERF_COUNTER_COUNT; ++i){
+        sum.perf_inclusive[i] += s.perf_inclusive[i];
+        sum.perf_exclusive[i] += s.perf_exclusive[i];
+      }
+    }
+    return sum;
+  }
+
+  /* The counters read by fake_read. Each counter i reads as
+   * (i+1)*fake_events. */
+  thread_local uint64_t fake_events = 0;
+  void fake_read(uint64_t vals[Timing::PERF_COUNTER_COUNT]){
+    for(int i = 0; i < Timing::PERF_COUNTER_COUNT; ++i){
+      vals[i] = (i+1)*fake_events;
+    }
+  }
+
+  /* A span of the Chrome trace. */
+  struct ChromeSpan {
+    unsigned tid;
+    double ts, dur;
+  };
+
+  /* The spans of the context named name in the Chrome trace trace. */
+  std::vector<ChromeSpan> chrome_spans(const std::string &trace,
+                                       const std::string &name){
+    std::vector<ChromeSpan> spans;
+    std::string prefix = "{\"name\":\"" + name + "\",\"ph\":\"X\",\"pid\":1,";
+    for(const std::string &line : lines_of(trace)){
+      if(line.compare(0,prefix.size(),prefix) != 0) continue;
+      ChromeSpan s;
+      BOOST_REQUIRE_EQUAL(std::sscanf(line.c_str()+prefix.size(),
+                                      "\"tid\":%u,\"ts\":%lf,\"dur\":%lf}",
+                                      &s.tid,&s.ts,&s.dur), 3);
+      spans.push_back(s);
+    }
+    return spans;
+  }
+
+  /* True if a is contained in b, up to rounding of the printed
+   * times. */
+  bool nested_in(const ChromeSpan &a, const ChromeSpan &b){
+    const double eps = 0.002;
+    return a.tid == b.tid && b.ts <= a.ts + eps
+      && a.ts + a.dur <= b.ts + b.dur + eps;
+  }
+
+  /* The exclusive microseconds of stack in the collapsed trace trace,
+   * or -1 if stack does not occur. */
+  long collapsed_us(const std::string &trace, const std::string &stack){
+    for(const std::string &line : lines_of(trace)){
+      if(line.compare(0,stack.size()+1,stack + " ") == 0){
+        return std::stol(line.substr(stack.size()+1));
+      }
+    }
+    return -1;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(Timing_test)
+
+BOOST_AUTO_TEST_CASE(Write_trace_chrome_nested){
+  Timing::Context outer("Timing_test_chrome_outer");
+  Timing::Context inner("Timing_test_chrome_inner");
+  Timing::Context innermost("Timing_test_chrome_innermost");
+  {
+    Recording r;
+    nest(outer,inner,innermost);
+    nest(outer,inner,innermost);
+  }
+  std::stringstream out;
+  Timing::write_trace(out,Timing::TRACE_CHROME);
+  std::string trace = out.str();
+  BOOST_CHECK(trace.compare(0,16,"{\"traceEvents\":[") == 0);
+  BOOST_CHECK(trace.find("],\"displayTimeUnit\":\"ms\"}") != std::string::npos);
+  std::vector<ChromeSpan> o = chrome_spans(trace,outer.name);
+  std::vector<ChromeSpan> i = chrome_spans(trace,inner.name);
+  std::vector<ChromeSpan> ii = chrome_spans(trace,innermost.name);
+  BOOST_REQUIRE_EQUAL(o.size(), 2);
+  BOOST_REQUIRE_EQUAL(i.size(), 2);
+  BOOST_REQUIRE_EQUAL(ii.size(), 2);
+  /* The spans are sorted by start, and each call of nest lies after
+   * the previous one. */
+  BOOST_CHECK(o[0].ts + o[0].dur <= o[1].ts);
+  for(int k = 0; k < 2; ++k){
+    BOOST_CHECK(nested_in(i[k],o[k]));
+    BOOST_CHECK(nested_in(ii[k],i[k]));
+    BOOST_CHECK(i[k].dur < o[k].dur);
+    BOOST_CHECK(ii[k].dur < i[k].dur);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Write_trace_collapsed_nested){
+  Timing::Context outer("Timing_test_collapsed_outer");
+  Timing::Context inner("Timing_test_collapsed_inner");
+  Timing::Context innermost("Timing_test_collapsed_innermost");
+  {
+    Recording r;
+    nest(outer,inner,innermost);
+  }
+  std::stringstream out;
+  Timing::write_trace(out,Timing::TRACE_COLLAPSED);
+  std::string trace = out.str();
+  /* Find the thread that recorded outer */
+  std::string thread;
+  for(const std::string &line : lines_of(trace)){
+    std::string::size_type p = line.find(";" + outer.name + " ");
+    if(p != std::string::npos){
+      BOOST_CHECK(thread.empty());
+      thread = line.substr(0,p);
+    }
+  }
+  BOOST_REQUIRE(thread.compare(0,7,"thread ") == 0);
+  BOOST_CHECK(thread.find(';') == std::string::npos);
+  std::string s0 = thread + ";" + outer.name;
+  std::string s1 = s0 + ";" + inner.name;
+  std::string s2 = s1 + ";" + innermost.name;
+  /* Each context spends at least 2ms outside its nested one */
+  BOOST_CHECK_GE(collapsed_us(trace,s0), 2000);
+  BOOST_CHECK_GE(collapsed_us(trace,s1), 2000);
+  BOOST_CHECK_GE(collapsed_us(trace,s2), 1000);
+  /* The nested contexts occur only under their enclosing ones */
+  for(const std::string &line : lines_of(trace)){
+    if(line.find(inner.name) != std::string::npos){
+      BOOST_CHECK(line.compare(0,s1.size(),s1) == 0);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Perf_unavailable){
+  Timing::Context outer("Timing_test_perf_unavailable_outer");
+  Timing::Context inner("Timing_test_perf_unavailable_inner");
+  std::string err;
+  {
+    Perf p;
+    Timing::impl::perf_unavailable = true;
+    BOOST_CHECK(Timing::perf_enabled());
+    CaptureStderr capture;
+    /* Each thread opens its own perf events, but the failure is only
+     * reported once. */
+    std::vector<std::thread> threads;
+    for(int i = 0; i < 3; ++i){
+      threads.emplace_back([&outer,&inner](){
+                             for(int j = 0; j < 2; ++j){
+                               Timing::Guard g0(outer);
+                               Timing::Guard g1(inner);
+                             }
+                           });
+    }
+    for(std::thread &t : threads) t.join();
+    err = capture.contents();
+  }
+  BOOST_CHECK_EQUAL(count_of(err,"WARNING"), 1);
+  BOOST_CHECK_EQUAL(count_of(err,"--time-perf"), 1);
+  for(const std::string &name : {outer.name, inner.name}){
+    Timing::Sample s = sample_of(name);
+    BOOST_CHECK_EQUAL(s.count, 6);
+    for(int i = 0; i < Timing::PERF_COUNTER_COUNT; ++i){
+      BOOST_CHECK_EQUAL(s.perf_inclusive[i], 0);
+      BOOST_CHECK_EQUAL(s.perf_exclusive[i], 0);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Exclusive_subtracts_nested){
+  Timing::Context outer("Timing_test_exclusive_outer");
+  Timing::Context inner("Timing_test_exclusive_inner");
+  Timing::Context innermost("Timing_test_exclusive_innermost");
+  {
+    Perf p;
+    Timing::impl::perf_fake_read = fake_read;
+    fake_events = 0;
+    for(int k = 0; k < 2; ++k){
+      Timing::Guard g0(outer);
+      fake_events += 1;
+      spend();
+      {
+        Timing::Guard g1(inner);
+        fake_events += 10;
+        spend();
+        {
+          Timing::Guard g2(innermost);
+          fake_events += 100;
+          spend();
+        }
+        {
+          Timing::Guard g2(innermost);
+          fake_events += 1000;
+        }
+      }
+      fake_events += 10000;
+    }
+  }
+  Timing::Sample o = sample_of(outer.name);
+  Timing::Sample i = sample_of(inner.name);
+  Timing::Sample ii = sample_of(innermost.name);
+  BOOST_CHECK_EQUAL(o.count, 2);
+  BOOST_CHECK_EQUAL(i.count, 2);
+  BOOST_CHECK_EQUAL(ii.count, 4);
+  for(int c = 0; c < Timing::PERF_COUNTER_COUNT; ++c){
+    BOOST_CHECK_EQUAL(ii.perf_inclusive[c], (c+1)*2*1100);
+    BOOST_CHECK_EQUAL(ii.perf_exclusive[c], (c+1)*2*1100);
+    BOOST_CHECK_EQUAL(i.perf_inclusive[c], (c+1)*2*1110);
+    BOOST_CHECK_EQUAL(i.perf_exclusive[c], (c+1)*2*10);
+    BOOST_CHECK_EQUAL(o.perf_inclusive[c], (c+1)*2*11111);
+    BOOST_CHECK_EQUAL(o.perf_exclusive[c], (c+1)*2*10001);
+  }
+  /* The same holds for the times */
+  const double eps = 1e-6;
+  BOOST_CHECK(std::abs(ii.exclusive - ii.inclusive) < eps);
+  BOOST_CHECK(std::abs(i.exclusive - (i.inclusive - ii.inclusive)) < eps);
+  BOOST_CHECK(std::abs(o.exclusive - (o.inclusive - i.inclusive)) < eps);
+  BOOST_CHECK_GE(o.exclusive, 0.004);
+  BOOST_CHECK_GE(i.exclusive, 0.004);
+  BOOST_CHECK_GE(ii.exclusive, 0.004);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif /* !defined(NO_TIMING) */
+
+#endif
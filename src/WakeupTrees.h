@@ -22,8 +22,6 @@
 
 #include <memory>
 #include <vector>
-#include <deque>
-#include <map>
 #include "Debug.h"
 
 /* Constraints on template argument type Branch:
@@ -35,14 +33,66 @@ template <typename Branch> class WakeupTree;
 template <typename Branch> class WakeupTreeRef;
 template <typename Branch, typename Event> class WakeupTreeExplorationBuffer;
 
+/* A WakeupTree<Branch> is an arena holding all the nodes of a wakeup
+ * tree. Nodes are linked through first-child/next-sibling indices, and
+ * are stored in blocks of block_size nodes, so that references to
+ * nodes stay valid as the tree grows. Nodes of deleted subtrees are
+ * kept on a free list and reused by later insertions, so that a tree
+ * that is continuously grown and pruned by a DPOR exploration does not
+ * allocate in the steady state.
+ *
+ * Nodes are accessed through WakeupTreeRef<Branch>.
+ */
 template <typename Branch>
 class WakeupTree {
   friend class WakeupTreeRef<Branch>;
   template <typename Branch_, typename Event>
   friend class WakeupTreeExplorationBuffer;
+public:
+  WakeupTree() {}
+  WakeupTree(const WakeupTree &) = delete;
+  WakeupTree &operator=(const WakeupTree &) = delete;
 private:
-  typedef std::deque<std::pair<Branch,std::unique_ptr<WakeupTree>>> children_type;
-  children_type children;
+  static constexpr unsigned NIL = unsigned(-1);
+  static constexpr unsigned ROOT = unsigned(-2);
+  static constexpr unsigned block_size = 256;
+  struct children_type {
+    unsigned first = NIL;
+    unsigned last = NIL;
+    std::size_t size = 0;
+  };
+  struct Node {
+    Node(Branch branch) : branch(std::move(branch)) {}
+    Branch branch;
+    children_type children;
+    unsigned next_sibling = NIL;
+  };
+  /* Each block is reserved to block_size nodes, and never reallocated. */
+  std::vector<std::vector<Node>> blocks;
+  /* The unused nodes, linked through Node::next_sibling. */
+  unsigned free_list = NIL;
+  children_type root_children;
+  /* Scratch space for release */
+  std::vector<unsigned> release_stack;
+
+  Node &at(unsigned idx) {
+    assert(idx / block_size < blocks.size());
+    return blocks[idx / block_size][idx % block_size];
+  }
+  const Node &at(unsigned idx) const {
+    assert(idx / block_size < blocks.size());
+    return blocks[idx / block_size][idx % block_size];
+  }
+  children_type &children(unsigned idx) {
+    return idx == ROOT ? root_children : at(idx).children;
+  }
+  const children_type &children(unsigned idx) const {
+    return idx == ROOT ? root_children : at(idx).children;
+  }
+  /* Appends a new leaf node with branch b to the children of parent. */
+  unsigned put_child(unsigned parent, Branch b);
+  /* Removes the first child of parent, and its subtree. */
+  void pop_front(unsigned parent);
 };
 
 template <typename Branch>
@@ -50,7 +100,7 @@ class WakeupTreeRef {
   template <typename Branch_, typename Event>
   friend class WakeupTreeExplorationBuffer;
 public:
-  std::size_t size() const noexcept { return (*this)->children.size(); }
+  std::size_t size() const noexcept { return tree->children(idx).size; }
 
   WakeupTreeRef(const WakeupTreeRef &) = default;
   WakeupTreeRef &operator=(const WakeupTreeRef&) = default;
@@ -58,32 +108,38 @@ public:
   /* Does not implement the full iterator API, for now. */
   class iterator {
   public:
-    const Branch &branch() { return iter->first; };
-    WakeupTreeRef<Branch> node() { return {*iter->second}; };
-    bool operator<(const iterator &it) const { return iter < it.iter; };
-    bool operator==(const iterator &it) const { return iter == it.iter; };
-    bool operator>(const iterator &it) const { return iter > it.iter; };
-    bool operator<=(const iterator &it) const { return iter <= it.iter; };
-    bool operator!=(const iterator &it) const { return iter != it.iter; };
-    bool operator>=(const iterator &it) const { return iter >= it.iter; };
-    iterator operator++(){ iter++; return *this; }
-    iterator(typename WakeupTree<Branch>::children_type::iterator iter)
-      : iter(iter) {}
+    const Branch &branch() { return tree->at(idx).branch; };
+    WakeupTreeRef<Branch> node() { return {*tree, idx}; };
+    bool operator==(const iterator &it) const { return idx == it.idx; };
+    bool operator!=(const iterator &it) const { return idx != it.idx; };
+    iterator operator++(){ idx = tree->at(idx).next_sibling; return *this; }
+    iterator(WakeupTree<Branch> &tree, unsigned idx)
+      : tree(&tree), idx(idx) {}
   private:
-    typename WakeupTree<Branch>::children_type::iterator iter;
+    WakeupTree<Branch> *tree;
+    unsigned idx;
   };
 
-  iterator begin() { return iterator((*this)->children.begin()); }
-  iterator end()   { return iterator((*this)->children.end()); }
+  iterator begin() { return iterator(*tree, tree->children(idx).first); }
+  iterator end()   { return iterator(*tree, WakeupTree<Branch>::NIL); }
 
   WakeupTreeRef put_child(Branch b);
   bool has_child(const Branch &b) const;
 
 private:
-  const WakeupTree<Branch> *operator->(void) const { return node; }
-  WakeupTree<Branch> *operator->(void) { return node; }
-  WakeupTreeRef(WakeupTree<Branch> &node) : node(&node) {}
-  WakeupTree<Branch> *node;
+  WakeupTreeRef(WakeupTree<Branch> &tree, unsigned idx)
+    : tree(&tree), idx(idx) {}
+  /* The branch of the first child of this node. */
+  Branch &front() {
+    assert(size());
+    return tree->at(tree->children(idx).first).branch;
+  }
+  const Branch &front() const {
+    assert(size());
+    return tree->at(tree->children(idx).first).branch;
+  }
+  WakeupTree<Branch> *tree;
+  unsigned idx;
 };
 
 /* A WakupTreeExplorationBuffer<Branch, Event> associates a wakeup tree with an
@@ -101,15 +157,16 @@ private:
   WakeupTreeRef<Branch> rootref;
   std::vector<ExplorationNode> prefix;
 public:
-  WakeupTreeExplorationBuffer() : rootref(tree) {}
+  WakeupTreeExplorationBuffer()
+    : rootref(tree, WakeupTree<Branch>::ROOT) {}
   std::size_t len() const noexcept { return prefix.size(); }
   Event &operator[](std::size_t i) { assert(i < len()); return prefix[i].event; }
   const Event &operator[](std::size_t i) const { assert(i < len()); return prefix[i].event; }
   const Branch &branch(std::size_t i) const {
-    return parent_at(i)->children.front().first;
+    return parent_at(i).front();
   }
   Branch &branch(std::size_t i) {
-    return parent_at(i)->children.front().first;
+    return parent_at(i).front();
   }
   WakeupTreeRef<Branch> node(std::size_t i) { assert(i < len()); return prefix[i].node; }
   WakeupTreeRef<Branch> parent_at(std::size_t i) {
@@ -127,7 +184,7 @@ public:
     return parent_at(pos).size() - 1;
   }
   Event &last() { return prefix.back().event; }
-  const Branch &lastbranch() { return parent_at(len()-1)->children.front().first; }
+  const Branch &lastbranch() { return parent_at(len()-1).front(); }
   void set_last_branch(Branch b);
   WakeupTreeRef<Branch> lastnode() { return prefix.back().node; }
   void delete_last();
@@ -17,33 +17,83 @@
  * <http://www.gnu.org/licenses/>.
  */
 
+template <typename Branch>
+unsigned WakeupTree<Branch>::put_child(unsigned parent, Branch b) {
+  unsigned idx;
+  if (free_list != NIL) {
+    idx = free_list;
+    Node &n = at(idx);
+    free_list = n.next_sibling;
+    assert(n.children.first == NIL && n.children.size == 0);
+    n.branch = std::move(b);
+    n.next_sibling = NIL;
+  } else {
+    if (blocks.empty() || blocks.back().size() == block_size) {
+      blocks.emplace_back();
+      blocks.back().reserve(block_size);
+    }
+    idx = (blocks.size() - 1) * block_size + blocks.back().size();
+    blocks.back().emplace_back(std::move(b));
+  }
+  children_type &ch = children(parent);
+  if (ch.last == NIL) ch.first = idx;
+  else at(ch.last).next_sibling = idx;
+  ch.last = idx;
+  ++ch.size;
+  return idx;
+}
+
+template <typename Branch>
+void WakeupTree<Branch>::pop_front(unsigned parent) {
+  children_type &ch = children(parent);
+  assert(ch.size);
+  unsigned first = ch.first;
+  ch.first = at(first).next_sibling;
+  if (ch.first == NIL) ch.last = NIL;
+  --ch.size;
+
+  /* Put the subtree of first on the free list */
+  release_stack.push_back(first);
+  while (!release_stack.empty()) {
+    unsigned idx = release_stack.back();
+    release_stack.pop_back();
+    Node &n = at(idx);
+    for (unsigned c = n.children.first; c != NIL; c = at(c).next_sibling) {
+      release_stack.push_back(c);
+    }
+    /* Do not keep what the branch owns (e.g. its symbolic events)
+     * alive on the free list. Moving out of it leaves it empty,
+     * without requiring Branch to be default constructible.
+     */
+    { Branch released(std::move(n.branch)); }
+    n.children = children_type();
+    n.next_sibling = free_list;
+    free_list = idx;
+  }
+}
+
 template <typename Branch>
 WakeupTreeRef<Branch> WakeupTreeRef<Branch>::put_child(Branch b) {
-  assert(std::none_of
-         (node->children.begin(), node->children.end(),
-          [&b](std::pair<Branch,std::unique_ptr<WakeupTree<Branch>>> &e) {
-           return e.first == b;
-         }));
-  node->children.emplace_back
-    (std::move(b),
-     std::unique_ptr<WakeupTree<Branch>>(new WakeupTree<Branch>()));
-  return WakeupTreeRef(*node->children.back().second);
+  assert(!has_child(b));
+  return WakeupTreeRef(*tree, tree->put_child(idx, std::move(b)));
 }
 
 template <typename Branch>
 bool WakeupTreeRef<Branch>::has_child(const Branch &b) const {
-  for (const auto &p : node->children) if (p.first == b) return true;
+  for (unsigned c = tree->children(idx).first; c != WakeupTree<Branch>::NIL;
+       c = tree->at(c).next_sibling) {
+    if (tree->at(c).branch == b) return true;
+  }
   return false;
 }
 
 template <typename Branch, typename Event>
 void WakeupTreeExplorationBuffer<Branch,Event>::delete_last() {
   assert(len());
-  typename WakeupTree<Branch>::children_type &child_list
-    = parent_at(len()-1)->children;
-  assert(child_list.size());
-  assert(child_list.front().first == lastbranch());
-  child_list.pop_front();
+  WakeupTreeRef<Branch> parent = parent_at(len()-1);
+  assert(parent.size());
+  assert(parent.front() == lastbranch());
+  tree.pop_front(parent.idx);
   prefix.pop_back();
 }
 
@@ -67,6 +117,6 @@ template <typename Branch, typename Event>
 void WakeupTreeExplorationBuffer<Branch,Event>::set_last_branch(Branch b){
   WakeupTreeRef<Branch> par = parent_at(len()-1);
   assert(par.size() == 1 || b == lastbranch());
-  assert(par->children.front().first == b);
-  par->children.front().first = std::move(b);
+  assert(par.front() == b);
+  par.front() = std::move(b);
 }
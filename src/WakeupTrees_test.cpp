@@ -0,0 +1,153 @@
+/* Copyright (C) 2026 agent
+ *
+ * This file is part of Nidhugg.
+ *
+ * Nidhugg is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nidhugg is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#ifdef HAVE_BOOST_UNIT_TEST_FRAMEWORK
+#include <boost/test/unit_test.hpp>
+
+#include "WakeupTrees.h"
+
+#include <memory>
+#include <vector>
+
+namespace {
+  struct Br {
+    Br(int pid) : pid(pid) {}
+    int pid;
+    bool operator<(const Br &b) const { return pid < b.pid; }
+    bool operator==(const Br &b) const { return pid == b.pid; }
+  };
+  typedef WakeupTreeExplorationBuffer<Br, int> buffer;
+
+  std::vector<int> children(WakeupTreeRef<Br> node) {
+    std::vector<int> res;
+    for (auto it = node.begin(); it != node.end(); ++it) {
+      res.push_back(it.branch().pid);
+    }
+    return res;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(WakeupTrees_test)
+
+BOOST_AUTO_TEST_CASE(Push_and_delete){
+  buffer b;
+  b.push(Br(0), 10);
+  b.push(Br(1), 11);
+  BOOST_CHECK_EQUAL(b.len(), 2);
+  BOOST_CHECK_EQUAL(b[1], 11);
+  BOOST_CHECK_EQUAL(b.branch(0).pid, 0);
+  BOOST_CHECK_EQUAL(b.branch(1).pid, 1);
+  BOOST_CHECK_EQUAL(b.children_after(0), 0);
+  b.delete_last();
+  BOOST_CHECK_EQUAL(b.len(), 1);
+  BOOST_CHECK_EQUAL(b.lastnode().size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(Children_in_order){
+  buffer b;
+  b.push(Br(0), 0);
+  WakeupTreeRef<Br> root = b.parent_at(0);
+  root.put_child(Br(2));
+  root.put_child(Br(1));
+  BOOST_CHECK(root.has_child(Br(1)));
+  BOOST_CHECK(!root.has_child(Br(3)));
+  BOOST_CHECK(children(root) == std::vector<int>({0, 2, 1}));
+  BOOST_CHECK_EQUAL(b.children_after(0), 2);
+
+  b.delete_last();
+  BOOST_CHECK(children(b.parent_at(0)) == std::vector<int>({2, 1}));
+  b.enter_first_child(1);
+  BOOST_CHECK_EQUAL(b.lastbranch().pid, 2);
+  b.set_last_branch(Br(2));
+  b.delete_last();
+  b.enter_first_child(2);
+  BOOST_CHECK_EQUAL(b.lastbranch().pid, 1);
+  BOOST_CHECK_EQUAL(b.children_after(0), 0);
+}
+
+BOOST_AUTO_TEST_CASE(Reuse_deleted_subtree){
+  buffer b;
+  b.push(Br(0), 0);
+  b.parent_at(0).put_child(Br(1));
+  /* A deep sequence below the first branch */
+  WakeupTreeRef<Br> n = b.lastnode();
+  for (int i = 0; i < 1000; ++i) n = n.put_child(Br(i));
+  b.delete_last();
+  b.enter_first_child(1);
+  BOOST_CHECK_EQUAL(b.lastbranch().pid, 1);
+  /* Deleted nodes are reused, and the new tree is intact */
+  n = b.lastnode();
+  for (int i = 0; i < 1000; ++i) n = n.put_child(Br(-i));
+  n = b.lastnode();
+  for (int i = 0; i < 1000; ++i) {
+    BOOST_REQUIRE_EQUAL(n.size(), 1);
+    BOOST_CHECK_EQUAL(n.begin().branch().pid, -i);
+    n = n.begin().node();
+  }
+  BOOST_CHECK_EQUAL(n.size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(Deleted_nodes_release_branches){
+  /* A branch owning some data */
+  struct PBr {
+    PBr(int pid, std::shared_ptr<int> data) : pid(pid), data(std::move(data)) {}
+    int pid;
+    std::shared_ptr<int> data;
+    bool operator<(const PBr &b) const { return pid < b.pid; }
+    bool operator==(const PBr &b) const { return pid == b.pid; }
+  };
+  std::shared_ptr<int> data = std::make_shared<int>(0);
+  WakeupTreeExplorationBuffer<PBr, int> b;
+  b.push(PBr(0, nullptr), 0);
+  b.parent_at(0).put_child(PBr(1, nullptr));
+  WakeupTreeRef<PBr> n = b.lastnode();
+  for (int i = 0; i < 10; ++i) n = n.put_child(PBr(i, data));
+  BOOST_CHECK_EQUAL(data.use_count(), 11);
+  b.delete_last();
+  /* The deleted nodes are on the free list, but hold no data */
+  BOOST_CHECK_EQUAL(data.use_count(), 1);
+  b.enter_first_child(1);
+  n = b.lastnode();
+  n = n.put_child(PBr(2, nullptr));
+  BOOST_CHECK_EQUAL(n.size(), 0);
+  BOOST_CHECK_EQUAL(b.lastnode().size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(Wide_tree){
+  buffer b;
+  b.push(Br(0), 0);
+  WakeupTreeRef<Br> root = b.parent_at(0);
+  std::vector<WakeupTreeRef<Br>> nodes;
+  for (int i = 1; i < 1000; ++i) nodes.push_back(root.put_child(Br(i)));
+  for (unsigned i = 0; i < nodes.size(); ++i) {
+    nodes[i].put_child(Br(int(i)));
+  }
+  /* References stay valid as the arena grows */
+  for (unsigned i = 0; i < nodes.size(); ++i) {
+    BOOST_REQUIRE_EQUAL(nodes[i].size(), 1);
+    BOOST_CHECK_EQUAL(nodes[i].begin().branch().pid, int(i));
+  }
+  BOOST_CHECK_EQUAL(root.size(), 1000);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
@@ -19,7 +19,9 @@
 
 #include <config.h>
 
+#include "Batch.h"
 #include "Configuration.h"
+#include "Debug.h"
 #include "DPORDriver.h"
 #include "GlobalContext.h"
 #include "Transform.h"
@@ -28,11 +30,16 @@
 #include <llvm/Support/CommandLine.h>
 #include <llvm/Support/ManagedStatic.h>
 
+#include <algorithm>
 #include <iostream>
 #include <set>
 #include <stdexcept>
+#include <thread>
+#include <vector>
 
 extern llvm::cl::opt<std::string> cl_transform;
+extern llvm::cl::opt<std::string> cl_batch;
+extern llvm::cl::opt<unsigned> cl_batch_threads;
 
 llvm::cl::opt<std::string>
 cl_input_file(llvm::cl::desc("<input bitcode or assembly>"),
@@ -63,6 +70,50 @@ void print_version(){
             << ", with LLVM-" << LLVM_VERSION << ":" << LLVM_BUILDMODE << ")\n";
 }
 
+/* Reads the jobs of the --batch manifest. The switches of each job
+ * are parsed as a command line of their own, after which the actual
+ * command line argc, argv is parsed again.
+ */
+static std::vector<Batch::Job> read_batch_jobs(int argc, char *argv[]){
+#ifdef HAVE_LLVM_CL_RESETALLOPTIONOCCURRENCES
+  const std::string manifest = cl_batch;
+  if(cl_input_file.getNumOccurrences()){
+    Debug::warn("main:batch:input")
+      << "WARNING: Input file ignored in presence of --batch.\n";
+  }
+  std::vector<Batch::Job> jobs;
+  for(const auto &line : Batch::read_manifest(manifest)){
+    Batch::Job job;
+    job.name = manifest + ":" + std::to_string(line.first);
+    /* Use the job name as program name, so that LLVM reports errors
+     * in the switches by their manifest line. */
+    std::vector<const char*> job_argv = {job.name.c_str()};
+    for(const std::string &word : line.second){
+      job_argv.push_back(word.c_str());
+    }
+    llvm::cl::ResetAllOptionOccurrences();
+    llvm::cl::ParseCommandLineOptions(job_argv.size(), job_argv.data());
+    if(cl_batch != "" || cl_transform != ""){
+      throw std::logic_error(job.name+": --batch and --transform cannot be used in a batch job.");
+    }
+    job.input = cl_input_file;
+    job.conf.assign_by_commandline();
+    job.conf.check_commandline();
+    if(job.conf.print_progress){
+      Debug::warn("main:batch:print-progress")
+        << "WARNING: --print-progress ignored in batch jobs.\n";
+      job.conf.print_progress = false;
+    }
+    jobs.push_back(std::move(job));
+  }
+  llvm::cl::ResetAllOptionOccurrences();
+  llvm::cl::ParseCommandLineOptions(argc, argv);
+  return jobs;
+#else
+  throw std::logic_error("--batch is not supported with this version of LLVM.");
+#endif
+}
+
 // Normal exit code
 #define EXIT_OK 0
 // Exit code when verification failed (an error was detected)
@@ -105,18 +156,44 @@ int main(int argc, char *argv[]){
   llvm::cl::ParseCommandLineOptions(argc, argv);
 
   bool errors_detected = false;
+  /* Set if some --batch job could not be explored */
+  bool failures_detected = false;
+  /* Print the timing report only if --time was given, not if timing
+   * is enabled only for --stats-json. */
+  bool print_timing = Timing::timing_enabled();
   try{
-    Timing::Guard timing_guard(global_timing_context);
     Configuration conf;
     conf.assign_by_commandline();
     conf.check_commandline();
+    std::vector<Batch::Job> jobs;
+    if(cl_batch != ""){
+      jobs = read_batch_jobs(argc, argv);
+    }
+    if((conf.stats_json != "" && cl_transform == "") ||
+       Timing::trace_enabled() ||
+       std::any_of(jobs.begin(), jobs.end(), [](const Batch::Job &job){
+           return job.conf.stats_json != "";
+         })){
+      Timing::enable();
+    }
+    Timing::Guard timing_guard(global_timing_context);
 
-    if(cl_transform != ""){
+    if(cl_batch != ""){
+      unsigned n_threads = cl_batch_threads;
+      if(n_threads == 0){
+        n_threads = std::max(1u, std::thread::hardware_concurrency());
+      }
+      Batch::Summary summary = Batch::run(jobs, n_threads, std::cout);
+      std::cerr << "Batch: " << jobs.size() << " jobs, "
+                << summary.errors << " with errors, "
+                << summary.failures << " failed." << std::endl;
+      errors_detected = summary.errors > 0;
+      failures_detected = summary.failures > 0;
+    }else if(cl_transform != ""){
       Transform::transform(cl_input_file,cl_transform,conf);
     }else{
       /* Use DPORDriver to explore the given module */
-      DPORDriver *driver =
-        DPORDriver::parseIRFile(cl_input_file,conf);
+      DPORDriver *driver = DPORDriver::fromInput(cl_input_file,conf);
 
       DPORDriver::Result res = driver->run();
       std::cout << "Trace count: " << res.trace_count << std::endl;
@@ -126,6 +203,16 @@ int main(int argc, char *argv[]){
       if (res.sleepset_blocked_trace_count > 0)
         std::cout << "Sleepset-blocked trace count: "
                   << res.sleepset_blocked_trace_count << std::endl;
+      if (conf.sat_portfolio)
+        std::cout << "Portfolio decisions: "
+                  << res.portfolio_saturation_count << " by saturation, "
+                  << res.portfolio_heuristic_count << " by heuristic, "
+                  << res.portfolio_solver_count << " by solver" << std::endl;
+      /* The cache is on by default, so only report it on request */
+      if (conf.print_progress &&
+          res.sat_cache_hits + res.sat_cache_misses > 0)
+        std::cout << "SAT cache: " << res.sat_cache_hits << " hits, "
+                  << res.sat_cache_misses << " misses" << std::endl;
       if(res.has_errors()){
         errors_detected = true;
         std::cout << "\n Error detected:\n"
@@ -151,9 +238,12 @@ int main(int argc, char *argv[]){
   }
 
 #ifndef NO_TIMING
-  if (Timing::timing_enabled())
+  if (print_timing)
     Timing::print_report();
+  if (Timing::trace_enabled())
+    Timing::write_trace();
 #endif
 
+  if(failures_detected) return 1;
   return (errors_detected ? VERIFICATION_FAILURE : EXIT_OK);
 }
@@ -0,0 +1,499 @@
+/* Copyright (C) 2026 agent
+ *
+ * This file is part of Nidhugg.
+ *
+ * Nidhugg is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nidhugg is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/* Microbenchmarks for the data structures used by the trace builders.
+ *
+ * Each benchmark runs a synthetic workload sized like a trace of
+ * --trace-threads threads with --trace-events events each. The workloads are
+ * generated from fixed seeds, so that two runs (or two builds) measure
+ * exactly the same operations. Results are written as JSON, one entry
+ * per benchmark, with the median, minimum and maximum time per
+ * operation over --reps repetitions.
+ *
+ * Run with "make bench" in the src directory.
+ */
+
+#include <config.h>
+
+#include "GenMap.h"
+#include "GenVector.h"
+#include "IID.h"
+#include "Json.h"
+#include "Option.h"
+#include "SaturatedGraph.h"
+#include "SymAddr.h"
+#include "VClock.h"
+#include "vecset.h"
+#include "WakeupTrees.h"
+
+#include <llvm/Support/CommandLine.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+static llvm::cl::opt<unsigned>
+cl_threads("trace-threads", llvm::cl::init(8),
+           llvm::cl::desc("Number of threads in the synthetic traces."));
+
+static llvm::cl::opt<unsigned>
+cl_events("trace-events", llvm::cl::init(1000),
+          llvm::cl::desc("Number of events per thread in the synthetic traces."));
+
+static llvm::cl::opt<unsigned>
+cl_reps("reps", llvm::cl::init(9),
+        llvm::cl::desc("Number of timed repetitions of each benchmark."));
+
+static llvm::cl::opt<std::string>
+cl_filter("filter", llvm::cl::init(""),
+          llvm::cl::desc("Only run the benchmarks whose name contains this string."));
+
+static llvm::cl::opt<std::string>
+cl_output("o", llvm::cl::init("-"), llvm::cl::value_desc("FILE"),
+          llvm::cl::desc("Write the results to FILE instead of stdout."));
+
+namespace {
+
+  /* Results are accumulated here, so that the compiler cannot remove
+   * the work being measured. */
+  volatile uint64_t sink;
+
+  struct Params {
+    unsigned threads;
+    unsigned events;
+    unsigned total() const { return threads * events; }
+  };
+
+  /* A timed operation. It returns the number of operations performed. */
+  typedef std::function<uint64_t()> Run;
+
+  /* A benchmark is prepared (untimed) before each repetition, and the
+   * returned Run is then timed. State that the Run needs is captured
+   * by it, and destroyed after the timing stops.
+   */
+  struct Benchmark {
+    std::string name;
+    std::function<Run(const Params&)> prepare;
+  };
+
+  /* All benchmarks draw their randomness from a generator with a fixed
+   * seed. Values are reduced with % rather than with the std
+   * distributions, as those are not the same in all standard libraries.
+   */
+  struct Rand {
+    Rand() : engine(4711) {}
+    unsigned operator()(unsigned bound) { return unsigned(engine() % bound); }
+    std::mt19937_64 engine;
+  };
+
+  std::vector<VClock<int>> random_clocks(const Params &p, Rand &rand) {
+    std::vector<VClock<int>> vcs;
+    vcs.reserve(p.total());
+    for (unsigned i = 0; i < p.total(); ++i) {
+      std::vector<int> v(p.threads);
+      for (int &c : v) c = rand(p.events);
+      vcs.emplace_back(v);
+    }
+    return vcs;
+  }
+
+  /* COW-cloned chains must be destroyed youngest first, as a
+   * gen::vector or gen::map may not be destroyed while it has clones.
+   */
+  template<typename T> void destroy_chain(std::vector<T> &chain) {
+    while (chain.size()) chain.pop_back();
+  }
+
+  /* An SC execution of p.threads threads over p.threads variables,
+   * with each load reading from the latest store to its variable.
+   */
+  struct SyntheticEvent {
+    SaturatedGraph::Pid pid;
+    SaturatedGraph::ExtID id;
+    SaturatedGraph::EventKind kind;
+    SymAddr addr;
+    Option<SaturatedGraph::ExtID> read_from;
+  };
+
+  std::vector<SyntheticEvent> synthetic_execution(const Params &p, Rand &rand) {
+    std::vector<SyntheticEvent> exec;
+    std::vector<int> next_index(p.threads, 1);
+    std::vector<Option<SaturatedGraph::ExtID>> last_store(p.threads);
+    exec.reserve(p.total());
+    for (unsigned i = 0; i < p.total(); ++i) {
+      unsigned pid = rand(p.threads);
+      while (next_index[pid] > int(p.events)) pid = (pid + 1) % p.threads;
+      unsigned var = rand(p.threads);
+      unsigned k = rand(8);
+      SaturatedGraph::EventKind kind = k == 0 ? SaturatedGraph::RMW
+        : (k < 4 ? SaturatedGraph::STORE : SaturatedGraph::LOAD);
+      SaturatedGraph::ExtID id(pid, next_index[pid]++);
+      Option<SaturatedGraph::ExtID> rf;
+      if (kind != SaturatedGraph::STORE) rf = last_store[var];
+      if (kind != SaturatedGraph::LOAD) last_store[var] = id;
+      exec.push_back({pid, id, kind, SymAddr(SymMBlock::Global(var), 0), rf});
+    }
+    return exec;
+  }
+
+  void add_events(SaturatedGraph &g, const std::vector<SyntheticEvent> &exec) {
+    static const std::vector<SaturatedGraph::ExtID> no_edges;
+    for (const SyntheticEvent &e : exec) {
+      g.add_event(e.pid, e.id, e.kind, e.addr, e.read_from, no_edges);
+    }
+  }
+
+  struct WBranch {
+    WBranch(unsigned pid) : pid(pid) {}
+    unsigned pid;
+    bool operator==(const WBranch &b) const { return pid == b.pid; }
+  };
+
+  const std::vector<Benchmark> &benchmarks() {
+    static const std::vector<Benchmark> all = {
+      {"VClock<int>::operator+=", [](const Params &p) -> Run {
+          Rand rand;
+          auto vcs = std::make_shared<std::vector<VClock<int>>>(random_clocks(p, rand));
+          return [vcs]() {
+                   VClock<int> acc;
+                   for (const VClock<int> &vc : *vcs) acc += vc;
+                   sink += acc[0];
+                   return uint64_t(vcs->size());
+                 };
+        }},
+      {"VClock<int>::leq", [](const Params &p) -> Run {
+          Rand rand;
+          auto vcs = std::make_shared<std::vector<VClock<int>>>(random_clocks(p, rand));
+          return [vcs]() {
+                   uint64_t n = 0;
+                   for (std::size_t i = 1; i < vcs->size(); ++i) {
+                     n += (*vcs)[i-1].leq((*vcs)[i]);
+                   }
+                   sink += n;
+                   return uint64_t(vcs->size() - 1);
+                 };
+        }},
+      {"VClockVec::assign", [](const Params &p) -> Run {
+          Rand rand;
+          auto vcs = std::make_shared<std::vector<VClock<int>>>(random_clocks(p, rand));
+          auto vv = std::make_shared<VClockVec>();
+          vv->assign(p.threads, vcs->size(), VClock<int>());
+          return [vcs, vv]() {
+                   for (std::size_t i = 0; i < vcs->size(); ++i) (*vv)[i] = (*vcs)[i];
+                   sink += (*vv)[0][0];
+                   return uint64_t(vcs->size());
+                 };
+        }},
+      {"VClockVec::lt", [](const Params &p) -> Run {
+          Rand rand;
+          std::vector<VClock<int>> vcs = random_clocks(p, rand);
+          auto vv = std::make_shared<VClockVec>();
+          vv->assign(p.threads, vcs.size(), VClock<int>());
+          for (std::size_t i = 0; i < vcs.size(); ++i) (*vv)[i] = vcs[i];
+          unsigned n = vcs.size();
+          return [vv, n]() {
+                   uint64_t lts = 0;
+                   for (unsigned i = 1; i < n; ++i) lts += (*vv)[i-1].lt((*vv)[i]);
+                   sink += lts;
+                   return uint64_t(n - 1);
+                 };
+        }},
+      {"gen::vector::push_back", [](const Params &p) -> Run {
+          unsigned n = p.total();
+          return [n]() {
+                   gen::vector<unsigned> v;
+                   for (unsigned i = 0; i < n; ++i) v.push_back(i);
+                   sink += v.back();
+                   return uint64_t(n);
+                 };
+        }},
+      {"gen::vector::operator[]", [](const Params &p) -> Run {
+          Rand rand;
+          auto v = std::make_shared<gen::vector<unsigned>>();
+          auto ixs = std::make_shared<std::vector<unsigned>>();
+          for (unsigned i = 0; i < p.total(); ++i) {
+            v->push_back(i);
+            ixs->push_back(rand(p.total()));
+          }
+          return [v, ixs]() {
+                   uint64_t sum = 0;
+                   for (unsigned ix : *ixs) sum += (*v)[ix];
+                   sink += sum;
+                   return uint64_t(ixs->size());
+                 };
+        }},
+      /* A chain of clones, each modifying one element of its parent,
+       * as when a trace builder extends a saturated graph. Includes
+       * freeing the chain. */
+      {"gen::vector::clone+mut", [](const Params &p) -> Run {
+          Rand rand;
+          auto chain = std::make_shared<std::vector<gen::vector<unsigned>>>();
+          chain->reserve(p.events + 1);
+          chain->emplace_back();
+          for (unsigned i = 0; i < p.total(); ++i) chain->back().push_back(i);
+          auto ixs = std::make_shared<std::vector<unsigned>>();
+          for (unsigned i = 0; i < p.events; ++i) ixs->push_back(rand(p.total()));
+          return [chain, ixs]() {
+                   for (unsigned i = 0; i < ixs->size(); ++i) {
+                     chain->emplace_back(chain->back());
+                     chain->back().mut((*ixs)[i]) = i;
+                   }
+                   sink += chain->back()[0];
+                   destroy_chain(*chain);
+                   return uint64_t(ixs->size());
+                 };
+        }},
+      {"gen::map::mut(insert)", [](const Params &p) -> Run {
+          Rand rand;
+          auto keys = std::make_shared<std::vector<unsigned>>();
+          for (unsigned i = 0; i < p.total(); ++i) keys->push_back(unsigned(rand.engine()));
+          return [keys]() {
+                   gen::map<unsigned,unsigned> m;
+                   for (unsigned k : *keys) m.mut(k) = k;
+                   sink += m.size();
+                   return uint64_t(keys->size());
+                 };
+        }},
+      {"gen::map::find", [](const Params &p) -> Run {
+          Rand rand;
+          auto m = std::make_shared<gen::map<unsigned,unsigned>>();
+          auto keys = std::make_shared<std::vector<unsigned>>();
+          for (unsigned i = 0; i < p.total(); ++i) {
+            keys->push_back(unsigned(rand.engine()));
+            m->mut(keys->back()) = i;
+          }
+          /* Every other lookup misses */
+          for (unsigned i = 0; i < keys->size(); i += 2) (*keys)[i] ^= 1;
+          return [m, keys]() {
+                   uint64_t found = 0;
+                   for (unsigned k : *keys) found += m->find(k) != nullptr;
+                   sink += found;
+                   return uint64_t(keys->size());
+                 };
+        }},
+      {"gen::map::clone+mut", [](const Params &p) -> Run {
+          Rand rand;
+          auto chain = std::make_shared<std::vector<gen::map<unsigned,unsigned>>>();
+          chain->reserve(p.events + 1);
+          chain->emplace_back();
+          for (unsigned i = 0; i < p.total(); ++i) chain->back().mut(i) = i;
+          auto keys = std::make_shared<std::vector<unsigned>>();
+          for (unsigned i = 0; i < p.events; ++i) keys->push_back(rand(2 * p.total()));
+          return [chain, keys]() {
+                   for (unsigned i = 0; i < keys->size(); ++i) {
+                     chain->emplace_back(chain->back());
+                     chain->back().mut((*keys)[i]) = i;
+                   }
+                   sink += chain->back().size();
+                   destroy_chain(*chain);
+                   return uint64_t(keys->size());
+                 };
+        }},
+      {"VecSet::insert", [](const Params &p) -> Run {
+          Rand rand;
+          auto vals = std::make_shared<std::vector<int>>();
+          for (unsigned i = 0; i < p.total(); ++i) vals->push_back(rand(p.total()));
+          return [vals]() {
+                   VecSet<int> s;
+                   for (int v : *vals) s.insert(v);
+                   sink += s.size();
+                   return uint64_t(vals->size());
+                 };
+        }},
+      {"VecSet::count", [](const Params &p) -> Run {
+          Rand rand;
+          auto s = std::make_shared<VecSet<int>>();
+          auto vals = std::make_shared<std::vector<int>>();
+          for (unsigned i = 0; i < p.total(); ++i) {
+            s->insert(int(rand(2 * p.total())));
+            vals->push_back(rand(2 * p.total()));
+          }
+          return [s, vals]() {
+                   uint64_t n = 0;
+                   for (int v : *vals) n += s->count(v);
+                   sink += n;
+                   return uint64_t(vals->size());
+                 };
+        }},
+      {"SaturatedGraph::saturate", [](const Params &p) -> Run {
+          Rand rand;
+          std::vector<SyntheticEvent> exec = synthetic_execution(p, rand);
+          auto g = std::make_shared<SaturatedGraph>();
+          add_events(*g, exec);
+          unsigned n = exec.size();
+          return [g, n]() {
+                   sink += g->saturate();
+                   return uint64_t(n);
+                 };
+        }},
+      /* Clones a saturated graph, adds one load reading from a random
+       * store, and saturates the clone; 4 times per thread. */
+      {"SaturatedGraph::clone+saturate", [](const Params &p) -> Run {
+          Rand rand;
+          std::vector<SyntheticEvent> exec = synthetic_execution(p, rand);
+          auto base = std::make_shared<SaturatedGraph>();
+          add_events(*base, exec);
+          base->saturate();
+          std::vector<SaturatedGraph::ExtID> stores;
+          std::vector<int> last_index(p.threads, 0);
+          for (const SyntheticEvent &e : exec) {
+            if (e.kind != SaturatedGraph::LOAD) stores.push_back(e.id);
+            last_index[e.pid] = e.id.get_index();
+          }
+          auto loads = std::make_shared<std::vector<SyntheticEvent>>();
+          for (unsigned i = 0; i < 4 * p.threads; ++i) {
+            unsigned pid = rand(p.threads);
+            SaturatedGraph::ExtID rf = stores[rand(stores.size())];
+            loads->push_back({pid, SaturatedGraph::ExtID(pid, last_index[pid] + 1),
+                              SaturatedGraph::LOAD, base->event_addr(rf), rf});
+          }
+          return [base, loads]() {
+                   static const std::vector<SaturatedGraph::ExtID> no_edges;
+                   uint64_t acyclic = 0;
+                   for (const SyntheticEvent &e : *loads) {
+                     SaturatedGraph g = base->clone();
+                     g.add_event(e.pid, e.id, e.kind, e.addr, e.read_from, no_edges);
+                     acyclic += g.saturate();
+                   }
+                   sink += acyclic;
+                   return uint64_t(loads->size());
+                 };
+        }},
+      /* Extends an exploration sequence one event at a time, and at
+       * every event inserts a wakeup sequence of up to three branches
+       * at a random earlier position. */
+      {"WakeupTree::insert", [](const Params &p) -> Run {
+          Rand rand;
+          auto ops = std::make_shared<std::vector<unsigned>>();
+          for (unsigned i = 0; i < p.total(); ++i) {
+            ops->push_back(rand(p.threads));
+            ops->push_back(rand(i + 1));
+            ops->push_back(1 + rand(3));
+            for (unsigned j = 0; j < 3; ++j) ops->push_back(rand(p.threads));
+          }
+          auto buf = std::make_shared<WakeupTreeExplorationBuffer<WBranch,unsigned>>();
+          unsigned n = p.total();
+          return [ops, buf, n]() {
+                   const unsigned *op = ops->data();
+                   for (unsigned i = 0; i < n; ++i, op += 6) {
+                     buf->push(WBranch(op[0]), i);
+                     WakeupTreeRef<WBranch> node = buf->parent_at(op[1]);
+                     for (unsigned d = 0; d < op[2]; ++d) {
+                       WBranch b(op[3 + d]);
+                       auto it = node.begin();
+                       while (it != node.end() && !(it.branch() == b)) ++it;
+                       if (d == 0 && b == buf->branch(op[1])) {
+                         /* Already being explored */
+                         break;
+                       } else if (it == node.end()) {
+                         node = node.put_child(b);
+                       } else {
+                         node = it.node();
+                       }
+                     }
+                   }
+                   sink += buf->len();
+                   return uint64_t(n);
+                 };
+        }},
+    };
+    return all;
+  }
+
+  struct Result {
+    std::string name;
+    uint64_t ops;
+    double median, min, max;
+  };
+
+  Result run(const Benchmark &b, const Params &p, unsigned reps) {
+    typedef std::chrono::steady_clock clock;
+    std::vector<double> ns_per_op;
+    uint64_t ops = 0;
+    /* The first repetition warms up caches and the allocator, and is
+     * not counted. */
+    for (unsigned r = 0; r <= reps; ++r) {
+      Run f = b.prepare(p);
+      clock::time_point start = clock::now();
+      ops = f();
+      clock::time_point end = clock::now();
+      if (r == 0) continue;
+      double ns = std::chrono::duration<double,std::nano>(end - start).count();
+      ns_per_op.push_back(ops ? ns / ops : ns);
+    }
+    std::sort(ns_per_op.begin(), ns_per_op.end());
+    return {b.name, ops, ns_per_op[ns_per_op.size() / 2],
+            ns_per_op.front(), ns_per_op.back()};
+  }
+
+  void write_json(std::ostream &os, const Params &p, unsigned reps,
+                  const std::vector<Result> &results) {
+    os << "{\n"
+       << "  \"threads\": " << p.threads << ",\n"
+       << "  \"events_per_thread\": " << p.events << ",\n"
+       << "  \"reps\": " << reps << ",\n"
+       << "  \"benchmarks\": [";
+    os << std::fixed << std::setprecision(2);
+    for (std::size_t i = 0; i < results.size(); ++i) {
+      const Result &r = results[i];
+      os << (i ? ",\n" : "\n")
+         << "    {\"name\": " << Json::quote(r.name)
+         << ", \"ops\": " << r.ops
+         << ", \"median_ns_per_op\": " << r.median
+         << ", \"min_ns_per_op\": " << r.min
+         << ", \"max_ns_per_op\": " << r.max << "}";
+    }
+    os << (results.empty() ? "]\n" : "\n  ]\n") << "}\n";
+  }
+
+}
+
+int main(int argc, char *argv[]){
+  llvm::cl::ParseCommandLineOptions(argc, argv, "Nidhugg data structure microbenchmarks\n");
+  if(cl_threads < 1 || cl_events < 1 || cl_reps < 1){
+    std::cerr << "--trace-threads, --trace-events and --reps must be positive.\n";
+    return 1;
+  }
+  Params p = {cl_threads, cl_events};
+  std::vector<Result> results;
+  for(const Benchmark &b : benchmarks()){
+    if(b.name.find(cl_filter) == std::string::npos) continue;
+    std::cerr << b.name << "\n";
+    results.push_back(run(b, p, cl_reps));
+  }
+  if(cl_output == "-"){
+    write_json(std::cout, p, cl_reps, results);
+  }else{
+    std::ofstream os(cl_output);
+    write_json(os, p, cl_reps, results);
+    if(!os){
+      std::cerr << "Failed to write " << cl_output << "\n";
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -207,7 +207,7 @@ def get_lang(nidhuggcargs):
     print("WARNING: Guessing C.")
     return c
 
-# Compile the input source code file to LLVM IR in a temporary
+# Compile the input source code file to LLVM bitcode in a temporary
 # file. Return the path to the temporary file.
 def get_IR(nidhuggcargs,compilerargs):
     if not('--input' in nidhuggcargs):
@@ -218,30 +218,25 @@ def get_IR(nidhuggcargs,compilerargs):
     lang=get_lang(nidhuggcargs)
     if lang == 'LL':
         return inputfname
-    (fd,outputfname) = tempfile.mkstemp(suffix='.ll',dir=tmpdir)
+    (fd,outputfname) = tempfile.mkstemp(suffix='.bc',dir=tmpdir)
     os.close(fd)
     if lang == 'C':
-        cmd = [CLANG,'-o',outputfname,'-S','-emit-llvm','-g']
+        cmd = [CLANG,'-o',outputfname,'-c','-emit-llvm','-g']
         cmd.extend(compilerargs)
         cmd.append(inputfname)
         run(cmd)
     else:
         assert(lang == 'C++')
-        cmd = [CLANGXX,'-o',outputfname,'-S','-emit-llvm','-g']
+        cmd = [CLANGXX,'-o',outputfname,'-c','-emit-llvm','-g']
         cmd.extend(compilerargs)
         cmd.append(inputfname)
         run(cmd)
     return outputfname
 
-def transform(nidhuggcargs,transformargs,irfname):
-    (fd,outputfname) = tempfile.mkstemp(suffix='.ll',dir=tmpdir)
-    os.close(fd)
-    cmd = [NIDHUGG]+transformargs+['-transform',outputfname,irfname]
-    run(cmd)
-    return outputfname
-
-def run_nidhugg(nidhuggcargs,nidhuggargs,irfname):
-    cmd = [NIDHUGG,irfname]+nidhuggargs
+# Transform and analyze the module in a single nidhugg process, so
+# that the transformed module is never written out and parsed again.
+def run_nidhugg(nidhuggcargs,transformargs,nidhuggargs,irfname):
+    cmd = [NIDHUGG,'--transform-first']+transformargs+[irfname]+nidhuggargs
     return run(cmd)
 
 def main():
@@ -278,10 +273,8 @@ def main():
             raise Exception('Source code file \'{0}\' does not exist.'.format(nidhuggcargs['--input']))
         # Compile
         irfname = get_IR(nidhuggcargs,compilerargs)
-        # Transform
-        irfname = transform(nidhuggcargs,transformargs,irfname)
-        # Run stateless model-checker
-        ret = run_nidhugg(nidhuggcargs,nidhuggargs,irfname)
+        # Transform and run stateless model-checker
+        ret = run_nidhugg(nidhuggcargs,transformargs,nidhuggargs,irfname)
         print('Total wall-clock time: {0:.2f} s'.format(time.time()-t0))
         exit(ret)
     except Exception as e: